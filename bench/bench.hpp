@@ -0,0 +1,28 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#ifndef GIGAMONKEY_BENCH
+#define GIGAMONKEY_BENCH
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+namespace Gigamonkey::bench {
+    
+    // run a function once and return the time it took in seconds. 
+    template <typename f>
+    double seconds(f fun) {
+        auto start = std::chrono::steady_clock::now();
+        fun();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    
+    inline void report(const std::string& name, size_t count, double seconds) {
+        std::cout << "  " << name << ": " << count << " in " << seconds << "s (" 
+            << (seconds > 0 ? count / seconds : 0) << " per second)" << std::endl;
+    }
+    
+}
+
+#endif
@@ -0,0 +1,41 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include <gigamonkey/addresses.hpp>
+#include "bench.hpp"
+#include "gtest/gtest.h"
+
+namespace Gigamonkey::Bitcoin {
+    
+    TEST(AddressesBenchmark, TestAddresses) {
+        constexpr uint32 Count = 1000000;
+        
+        // the same few keys over and over, since making keys is not what is measured. 
+        std::vector<pubkey> keys;
+        keys.reserve(Count);
+        for (uint64 i = 0; i < 1000; i++) keys.push_back(secp256k1::secret{secp256k1::coordinate{i + 1}}.to_public());
+        for (uint32 i = 1000; i < Count; i++) keys.push_back(keys[i % 1000]);
+        
+        std::vector<std::string> one_at_a_time(Count);
+        bench::report("one at a time", Count, bench::seconds([&]() {
+            for (uint32 i = 0; i < Count; i++) one_at_a_time[i] = address{address::main, keys[i]}.write();
+        }));
+        
+        work_stealing_pool single{1};
+        bench::report("in one thread", Count, bench::seconds([&]() {
+            addresses::write(address::main, keys, single);
+        }));
+        
+        addresses written = addresses::write(address::main, keys);
+        bench::report("in all threads", Count, bench::seconds([&]() {
+            written = addresses::write(address::main, keys);
+        }));
+        
+        for (uint32 i = 0; i < Count; i += 997) EXPECT_EQ(written[i], one_at_a_time[i]);
+        
+        bench::report("join", Count, bench::seconds([&]() {
+            written.join();
+        }));
+    }
+    
+}
@@ -0,0 +1,55 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include <gigamonkey/wif.hpp>
+#include "bench.hpp"
+#include "gtest/gtest.h"
+
+namespace Gigamonkey::Bitcoin {
+    
+    constexpr uint32 Count = 100000;
+    
+    TEST(Base58Benchmark, TestAddresses) {
+        std::vector<address> addresses;
+        for (uint32 i = 0; i < Count; i++) addresses.push_back(address{address::main, address::digest{uint160{i + 1}}});
+        
+        std::vector<std::string> written(Count);
+        bench::report("write addresses", Count, bench::seconds([&]() {
+            for (uint32 i = 0; i < Count; i++) written[i] = addresses[i].write();
+        }));
+        
+        bench::report("write addresses at once", Count, bench::seconds([&]() {
+            EXPECT_EQ(address::write(addresses), written);
+        }));
+        
+        bench::report("write addresses generically", Count, bench::seconds([&]() {
+            for (uint32 i = 0; i < Count; i++) {
+                bytes data = append_checksum(base58::check{byte(address::main), bytes_view{addresses[i].Digest}});
+                encoding::base58::write(data);
+            }
+        }));
+        
+        bench::report("read addresses", Count, bench::seconds([&]() {
+            for (uint32 i = 0; i < Count; i++) EXPECT_TRUE(address{written[i]}.valid());
+        }));
+        
+        bench::report("read addresses generically", Count, bench::seconds([&]() {
+            for (uint32 i = 0; i < Count; i++) EXPECT_TRUE(base58::check::decode(written[i]).valid());
+        }));
+    }
+    
+    TEST(Base58Benchmark, TestWIF) {
+        std::vector<secret> keys;
+        for (uint32 i = 0; i < Count; i++) keys.push_back(secret{secret::main, secp256k1::secret{secp256k1::coordinate{i + 1}}});
+        
+        std::vector<std::string> written(Count);
+        bench::report("write WIF", Count, bench::seconds([&]() {
+            for (uint32 i = 0; i < Count; i++) written[i] = keys[i].write();
+        }));
+        
+        bench::report("read WIF", Count, bench::seconds([&]() {
+            for (uint32 i = 0; i < Count; i++) EXPECT_EQ(secret::read(written[i]), keys[i]);
+        }));
+    }
+    
+}
@@ -0,0 +1,62 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include <gigamonkey/coin_selection.hpp>
+#include "bench.hpp"
+#include "gtest/gtest.h"
+#include <random>
+#include <cmath>
+
+namespace Gigamonkey::Bitcoin {
+    
+    struct bench_redeemer final : redeemable {
+        redemption::incomplete redeem(sighash::directive) const override {
+            return {};
+        }
+        
+        uint32 expected_size() const override {
+            return 107;
+        }
+        
+        uint32 sigops() const override {
+            return 1;
+        }
+    };
+    
+    // values spread evenly over orders of magnitude from 1000 to 10^8. 
+    utxo_set synthetic_wallet(uint32 size, std::mt19937_64& random) {
+        ptr<redeemable> r = std::make_shared<bench_redeemer>();
+        std::uniform_real_distribution<double> exponent{3, 8};
+        utxo_set u;
+        for (uint32 i = 0; i < size; i++) 
+            u.insert(spendable{output{satoshi{int64(std::pow(10, exponent(random)))}, bytes(25, 0)}, r, outpoint{txid{uint256{i + 1}}, i}});
+        return u;
+    }
+    
+    TEST(CoinSelectionBenchmark, TestSelection) {
+        std::mt19937_64 random{1};
+        
+        utxo_set u;
+        double seconds = bench::seconds([&u, &random]() {
+            u = synthetic_wallet(100000, random);
+        });
+        bench::report("add outputs", 100000, seconds);
+        
+        std::uniform_real_distribution<double> exponent{4, 9};
+        uint32 spends = 100;
+        std::map<coin_selection::method, uint32> methods;
+        seconds = bench::seconds([&]() {
+            for (uint32 i = 0; i < spends; i++) {
+                coin_selection c{satoshi{int64(std::pow(10, exponent(random)))}, fee{.5, 0}, 44};
+                methods[c.select(u).Method]++;
+            }
+        });
+        bench::report("selections", spends, seconds);
+        
+        std::cout << "  branch and bound: " << methods[coin_selection::branch_and_bound] << 
+            ", knapsack: " << methods[coin_selection::knapsack] << 
+            ", largest first: " << methods[coin_selection::largest_first] << 
+            ", failed: " << methods[coin_selection::none] << std::endl;
+    }
+    
+}
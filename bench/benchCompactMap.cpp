@@ -0,0 +1,89 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include <gigamonkey/compact_map.hpp>
+#include "bench.hpp"
+#include "gtest/gtest.h"
+#include <unordered_map>
+#include <random>
+
+namespace Gigamonkey::Bitcoin {
+    
+    constexpr uint32 Entries = 10000000;
+    
+    // outpoints with random txids, a few outputs per transaction. 
+    std::vector<outpoint> random_outpoints(uint32 size, std::mt19937_64& random) {
+        std::vector<outpoint> x;
+        x.reserve(size);
+        txid id;
+        for (uint32 i = 0; i < size; i++) {
+            if (i % 3 == 0) for (auto b = id.begin(); b != id.end(); b += 8) {
+                uint64 r = random();
+                std::copy(reinterpret_cast<byte*>(&r), reinterpret_cast<byte*>(&r) + 8, b);
+            }
+            x.push_back(outpoint{id, i % 3});
+        }
+        return x;
+    }
+    
+    // insert everything, look up everything, look up as many 
+    // that are not there, and then remove everything. 
+    template <typename insert, typename find, typename erase> 
+    void run(const std::string& name, const std::vector<outpoint>& keys, const std::vector<outpoint>& missing, 
+        insert i, find f, erase e) {
+        std::cout << name << std::endl;
+        
+        bench::report("insert", keys.size(), bench::seconds([&keys, &i]() {
+            for (const outpoint& o : keys) i(o);
+        }));
+        
+        size_t found = 0;
+        bench::report("find", keys.size(), bench::seconds([&keys, &f, &found]() {
+            for (const outpoint& o : keys) found += f(o);
+        }));
+        EXPECT_EQ(found, keys.size());
+        
+        bench::report("miss", missing.size(), bench::seconds([&missing, &f, &found]() {
+            for (const outpoint& o : missing) found += f(o);
+        }));
+        EXPECT_EQ(found, keys.size());
+        
+        bench::report("erase", keys.size(), bench::seconds([&keys, &e]() {
+            for (const outpoint& o : keys) e(o);
+        }));
+    }
+    
+    TEST(CompactMapBenchmark, TestOutpoints) {
+        std::mt19937_64 random{1};
+        std::vector<outpoint> keys = random_outpoints(Entries, random);
+        std::vector<outpoint> missing = random_outpoints(Entries, random);
+        
+        {
+            outpoint_map<satoshi> m;
+            run("compact_map", keys, missing, 
+                [&m](const outpoint& o) { m.insert(o, satoshi{1}); }, 
+                [&m](const outpoint& o) -> bool { return m.contains(o); }, 
+                [&m](const outpoint& o) { m.erase(o); });
+            EXPECT_TRUE(m.empty());
+        }
+        
+        {
+            std::unordered_map<outpoint, satoshi, compact_hash<outpoint>> m;
+            run("std::unordered_map", keys, missing, 
+                [&m](const outpoint& o) { m.emplace(o, satoshi{1}); }, 
+                [&m](const outpoint& o) -> bool { return m.find(o) != m.end(); }, 
+                [&m](const outpoint& o) { m.erase(o); });
+            EXPECT_TRUE(m.empty());
+        }
+        
+        {
+            data::map<outpoint, satoshi> m;
+            run("data::map", keys, missing, 
+                [&m](const outpoint& o) { m = m.insert(o, satoshi{1}); }, 
+                [&m](const outpoint& o) -> bool { return m.contains(o); }, 
+                [&m](const outpoint& o) { m = m.remove(o); });
+            EXPECT_TRUE(m.empty());
+        }
+    }
+    
+}
@@ -0,0 +1,106 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include <gigamonkey/ecies/electrum.hpp>
+#include <gigamonkey/ecies/bitcore.hpp>
+#include "bench.hpp"
+#include "gtest/gtest.h"
+
+namespace Gigamonkey::ECIES {
+    
+    constexpr size_t MessageSize = 64 << 20;
+    constexpr size_t ChunkSize = 64 << 10;
+    
+    // only the size of the output is kept, as it would be written to a file. 
+    template <typename stream> size_t in_chunks(stream& s, bytes_view b) {
+        size_t size = 0;
+        for (size_t i = 0; i < b.size(); i += ChunkSize) size += s.update(b.substr(i, ChunkSize)).size();
+        return size + s.finalize().size();
+    }
+    
+    template <typename encryptor, typename decryptor, typename encrypt, typename decrypt> 
+    void run(const std::string& name, bytes_view message, const secp256k1::secret& key, encrypt en, decrypt de) {
+        std::cout << name << std::endl;
+        secp256k1::pubkey to = key.to_public();
+        
+        bytes encrypted;
+        bench::report("encrypt", message.size(), bench::seconds([&]() {
+            encrypted = en(message, to);
+        }));
+        
+        bench::report("decrypt", message.size(), bench::seconds([&]() {
+            EXPECT_EQ(de(encrypted, key).size(), message.size());
+        }));
+        
+        bench::report("encrypt in chunks", message.size(), bench::seconds([&]() {
+            encryptor e{to};
+            EXPECT_EQ(in_chunks(e, message), encrypted.size());
+        }));
+        
+        bench::report("decrypt in chunks", message.size(), bench::seconds([&]() {
+            decryptor d{key};
+            EXPECT_EQ(in_chunks(d, encrypted), message.size());
+        }));
+    }
+    
+    TEST(ECIESBenchmark, TestThroughput) {
+        secp256k1::secret key{secp256k1::coordinate{12345}};
+        bytes message(MessageSize);
+        for (size_t i = 0; i < message.size(); i++) message[i] = byte(i);
+        
+        run<electrum::encryptor, electrum::decryptor>("electrum", message, key, 
+            [](bytes_view m, const secp256k1::pubkey& to) { return electrum::encrypt(m, to); }, 
+            [](bytes_view m, const secp256k1::secret& k) { return electrum::decrypt(m, k); });
+        
+        run<bitcore::encryptor, bitcore::decryptor>("bitcore", message, key, 
+            [](bytes_view m, const secp256k1::pubkey& to) { return bitcore::encrypt(m, to); }, 
+            [](bytes_view m, const secp256k1::secret& k) { return bitcore::decrypt(m, k); });
+    }
+    
+    // short messages between the same two parties. 
+    TEST(ECIESBenchmark, TestSession) {
+        secp256k1::secret alice{secp256k1::coordinate{12345}};
+        secp256k1::secret bob{secp256k1::coordinate{67890}};
+        secp256k1::pubkey to = bob.to_public();
+        
+        constexpr uint32 Messages = 10000;
+        bytes message(100, 7);
+        
+        std::cout << "electrum" << std::endl;
+        bench::report("encrypt", Messages, bench::seconds([&]() {
+            for (uint32 i = 0; i < Messages; i++) electrum::encrypt(message, to, alice);
+        }));
+        
+        // a sender which reuses its key. 
+        bytes encrypted = electrum::encrypt(message, to, alice);
+        bench::report("decrypt", Messages, bench::seconds([&]() {
+            for (uint32 i = 0; i < Messages; i++) electrum::decrypt(encrypted, bob);
+        }));
+        
+        electrum::session d{bob};
+        bench::report("decrypt with session", Messages, bench::seconds([&]() {
+            for (uint32 i = 0; i < Messages; i++) d.decrypt(encrypted);
+        }));
+        
+        std::cout << "bitcore" << std::endl;
+        bench::report("encrypt", Messages, bench::seconds([&]() {
+            for (uint32 i = 0; i < Messages; i++) bitcore::encrypt(message, to, alice);
+        }));
+        
+        bitcore::session be{alice};
+        bench::report("encrypt with session", Messages, bench::seconds([&]() {
+            for (uint32 i = 0; i < Messages; i++) be.encrypt(message, to);
+        }));
+        
+        encrypted = be.encrypt(message, to);
+        bench::report("decrypt", Messages, bench::seconds([&]() {
+            for (uint32 i = 0; i < Messages; i++) bitcore::decrypt(encrypted, bob);
+        }));
+        
+        bitcore::session bd{bob};
+        bench::report("decrypt with session", Messages, bench::seconds([&]() {
+            for (uint32 i = 0; i < Messages; i++) bd.decrypt(encrypted);
+        }));
+    }
+    
+}
@@ -0,0 +1,60 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include <gigamonkey/secp256k1.hpp>
+#include "bench.hpp"
+#include "gtest/gtest.h"
+
+namespace Gigamonkey::Bitcoin {
+    
+    TEST(HashBenchmark, TestHash160) {
+        constexpr uint32 Count = 1000000;
+        
+        // compressed public keys, as in a watch list. 
+        std::vector<bytes> keys;
+        keys.reserve(Count);
+        for (uint32 i = 0; i < Count; i++) {
+            digest256 d = sha256(std::to_string(i));
+            bytes key(secp256k1::CompressedPubkeySize);
+            key[0] = byte(0x02 + (i & 1));
+            std::copy(d.begin(), d.end(), key.begin() + 1);
+            keys.push_back(key);
+        }
+        
+        std::vector<bytes_view> views(keys.begin(), keys.end());
+        
+        std::vector<digest160> one_at_a_time(Count);
+        bench::report("hash160 one at a time", Count, bench::seconds([&]() {
+            for (uint32 i = 0; i < Count; i++) one_at_a_time[i] = hash160(views[i]);
+        }));
+        
+        std::vector<digest160> batched(Count);
+        bench::report("hash160 in a batch", Count, bench::seconds([&]() {
+            hash160_batch(views.data(), batched.data(), Count);
+        }));
+        
+        EXPECT_EQ(batched, one_at_a_time);
+    }
+    
+    // the hash of a node in a Merkle tree. 
+    TEST(HashBenchmark, TestHashConcatenated) {
+        constexpr uint32 Count = 1000000;
+        
+        std::vector<digest256> digests;
+        digests.reserve(Count + 1);
+        for (uint32 i = 0; i <= Count; i++) digests.push_back(sha256(std::to_string(i)));
+        
+        std::vector<digest256> written(Count);
+        bench::report("hash256 after writing", Count, bench::seconds([&]() {
+            for (uint32 i = 0; i < Count; i++) written[i] = hash256(write(64, digests[i], digests[i + 1]));
+        }));
+        
+        std::vector<digest256> streamed(Count);
+        bench::report("hash256 while writing", Count, bench::seconds([&]() {
+            for (uint32 i = 0; i < Count; i++) streamed[i] = (hash256_writer{} << digests[i] << digests[i + 1]).finalize();
+        }));
+        
+        EXPECT_EQ(streamed, written);
+    }
+    
+}
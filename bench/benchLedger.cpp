@@ -0,0 +1,62 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include <gigamonkey/local_ledger.hpp>
+#include "bench.hpp"
+#include "gtest/gtest.h"
+#include <cstdlib>
+#include <filesystem>
+
+namespace Gigamonkey::Bitcoin {
+    
+    TEST(LedgerBenchmark, TestLocalLedger) {
+        char name[] = "/tmp/local_ledger_XXXXXX";
+        ASSERT_NE(mkdtemp(name), nullptr);
+        std::string directory{name};
+        
+        bytes script(25, 0);
+        std::vector<bytes> txs;
+        for (uint32 i = 0; i < 200000; i++) txs.push_back(transaction{1, 
+            list<input>{input{outpoint{txid{uint256{i + 1}}, 0}, bytes(107, byte(i)), 0}}, 
+            list<output>{output{satoshi{1000 + i}, script}, output{satoshi{2000 + i}, script}}, 0}.write());
+        
+        std::vector<txid> ids;
+        {
+            local_ledger l{directory};
+            double import = bench::seconds([&txs, &l]() {
+                for (const bytes& tx : txs) l.add_transaction(tx);
+            });
+            bench::report("import", txs.size(), import);
+            EXPECT_EQ(l.size(), txs.size());
+            
+            double flush = bench::seconds([&l]() {
+                l.flush();
+            });
+            bench::report("flush", txs.size(), flush);
+            
+            for (const bytes& tx : txs) ids.push_back(Bitcoin::transaction::id(tx));
+        }
+        
+        std::unique_ptr<local_ledger> l;
+        double open = bench::seconds([&l, &directory]() {
+            l = std::make_unique<local_ledger>(directory);
+        });
+        bench::report("reopen", txs.size(), open);
+        
+        size_t total = 0;
+        double view = bench::seconds([&ids, &l, &total]() {
+            for (const txid& id : ids) total += l->view(id).size();
+        });
+        bench::report("view", ids.size(), view);
+        
+        double copy = bench::seconds([&ids, &l, &total]() {
+            for (const txid& id : ids) total += l->transaction(id).Value->size();
+        });
+        bench::report("transaction", ids.size(), copy);
+        EXPECT_GT(total, 0);
+        
+        l.reset();
+        std::filesystem::remove_all(directory);
+    }
+
+}
@@ -0,0 +1,75 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include <gigamonkey/script/machine.hpp>
+#include <gigamonkey/boost/boost.hpp>
+#include "bench.hpp"
+#include "gtest/gtest.h"
+
+namespace Gigamonkey::Bitcoin {
+    
+    // pushes of various sizes which are dropped again, ending in OP_TRUE. 
+    program push_and_drop(uint32 size) {
+        bytes small(20, 0xab);
+        bytes large(1000, 0xcd);
+        
+        program p{};
+        for (uint32 i = 0; i < size; i++) p = p << push_data(i % 100 == 0 ? large : small) << OP_DROP;
+        return p << OP_TRUE;
+    }
+    
+    // a Boost output script with a dummy input script. It runs 
+    // until the proof of work is checked, which fails. 
+    program boost_program() {
+        digest160 address{uint160{7}};
+        bytes input = Boost::input_script::contract(signature{}, pubkey{bytes(33, 0x02)}, 
+            0, timestamp{uint32(0)}, 0, Stratum::session_id{uint32(0)}).write();
+        bytes output = Boost::output_script::contract(1, uint256{}, work::compact{32, 0x0080ff}, 
+            bytes(20, 0x01), 0, bytes(100, 0x02), address, false).write();
+        
+        program p = decompile(input);
+        for (const instruction& i : decompile(output)) p = p << i;
+        return p;
+    }
+    
+    // count the steps that a machine takes when it runs n instructions at a time. 
+    uint32 count_steps(machine& m, uint32 n) {
+        uint32 steps = 0;
+        while (!m.halt()) {
+            size_t position = m.position();
+            m.step(n);
+            for (const instruction_view& i : instructions{bytes_view{m.Script}.substr(position, m.position() - position)}) steps++;
+        }
+        return steps;
+    }
+    
+    void bench_machine(const std::string& name, program p) {
+        std::cout << name << ", " << p.size() << " instructions:" << std::endl;
+        
+        for (uint32 n : {1, 100, 10000}) {
+            machine m{p};
+            uint32 steps;
+            double seconds = bench::seconds([&m, &steps, n]() {
+                steps = count_steps(m, n);
+            });
+            
+            bench::report(std::string{"steps, "} + std::to_string(n) + " at a time", steps, seconds);
+        }
+        
+        machine m{p};
+        uint32 snapshots = 0;
+        bench::report("step and snapshot", p.size(), bench::seconds([&m, &snapshots]() {
+            while (!m.halt()) {
+                m.step();
+                machine::state x = m.snapshot();
+                snapshots++;
+            }
+        }));
+    }
+    
+    TEST(MachineBenchmark, TestSteps) {
+        bench_machine("Boost", boost_program());
+        bench_machine("push and drop", push_and_drop(50000));
+    }
+    
+}
@@ -0,0 +1,51 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include <gigamonkey/payout.hpp>
+#include "bench.hpp"
+#include "gtest/gtest.h"
+
+namespace Gigamonkey::Bitcoin {
+    
+    struct bench_keysource final : keysource {
+        uint64 Index;
+        
+        bench_keysource(uint64 i) : Index{i} {}
+        
+        secret first() const override {
+            return secret{secret::test, secp256k1::secret{secp256k1::coordinate{Index}}};
+        }
+        
+        ptr<keysource> rest() const override {
+            return std::make_shared<bench_keysource>(Index + 1);
+        }
+    };
+    
+    TEST(PayoutBenchmark, TestPayout) {
+        ptr<keysource> keys = std::make_shared<bench_keysource>(1);
+        
+        funds f{};
+        for (uint32 i = 0; i < 1000; i++) {
+            secret s = keys->first();
+            keys = keys->rest();
+            f.add(spendable{output{satoshi{10000000}, pay_to_address::script(s.address().Digest)},
+                std::make_shared<redeem_pay_to_address>(s, s.to_public()), outpoint{txid{uint256{i + 1}}, i}});
+        }
+        
+        std::vector<payment> payments;
+        for (uint32 i = 0; i < 100000; i++) payments.push_back(payment{satoshi{1000 + i % 1000}, bytes(25, byte(i))});
+        
+        for (size_t max_size : {size_t{100000}, size_t{1000000}}) {
+            payout p{fee{.5, 0}, std::make_shared<pay_to_address_pattern>(), max_size};
+            payout::result r;
+            double seconds = bench::seconds([&]() {
+                r = p.pay(payments, f, keys);
+            });
+            
+            EXPECT_TRUE(r.valid());
+            bench::report(std::string{"outputs paid in transactions of up to "} + std::to_string(max_size) + " bytes", payments.size(), seconds);
+            std::cout << "  transactions: " << r.Batches.size() << ", fee: " << int64(r.Fee) << std::endl;
+        }
+    }
+    
+}
@@ -0,0 +1,113 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include <gigamonkey/script/pattern.hpp>
+#include "bench.hpp"
+#include "gtest/gtest.h"
+
+namespace Gigamonkey::Bitcoin {
+    
+    // a program like those found in data transactions, with 
+    // pushes of various sizes and a few op codes in between. 
+    program data_program(uint32 size) {
+        bytes small(20, 0xab);
+        bytes medium(200, 0xcd);
+        bytes large(1000, 0xef);
+        
+        program p{};
+        for (uint32 i = 0; i < size; i++) switch (i % 5) {
+            case 0: 
+                p = p << push_data(small);
+                break;
+            case 1: 
+                p = p << OP_DROP;
+                break;
+            case 2: 
+                p = p << push_data(medium);
+                break;
+            case 3: 
+                p = p << OP_DROP;
+                break;
+            default: 
+                p = p << (i % 1000 == 4 ? push_data(large) : instruction{OP_NOP});
+        }
+        
+        return p;
+    }
+    
+    TEST(ScriptBenchmark, TestCompileAndRead) {
+        
+        for (uint32 size : {10000, 100000, 1000000}) {
+            std::cout << size << " instructions:" << std::endl;
+            
+            program p = data_program(size);
+            
+            bytes script;
+            bench::report("compile", size, bench::seconds([&p, &script]() {
+                script = compile(p);
+            }));
+            
+            EXPECT_EQ(script.size(), length(p));
+            
+            bool is_valid;
+            bench::report("valid(program)", size, bench::seconds([&p, &is_valid]() {
+                is_valid = valid(p);
+            }));
+            
+            EXPECT_TRUE(is_valid);
+            
+            bench::report("valid_program(script)", size, bench::seconds([&script, &is_valid]() {
+                is_valid = valid_program(script);
+            }));
+            
+            EXPECT_TRUE(is_valid);
+            
+            uint32 count = 0;
+            bench::report("iterate instructions", size, bench::seconds([&script, &count]() {
+                for (const instruction_view& i : instructions{script}) if (i.valid()) count++;
+            }));
+            
+            EXPECT_EQ(count, size);
+            
+            program decompiled;
+            bench::report("decompile", size, bench::seconds([&script, &decompiled]() {
+                decompiled = decompile(script);
+            }));
+            
+            EXPECT_EQ(decompiled.size(), size);
+        }
+        
+    }
+    
+    TEST(ScriptBenchmark, TestPatternMatch) {
+        
+        uint32 size = 1000000;
+        
+        list<bytes> scripts{
+            pay_to_address::script(digest160{uint160{7}}), 
+            compile(program{OP_FALSE, OP_RETURN, push_data(bytes(40, 0x01))})};
+        
+        for (const bytes& script : scripts) {
+            std::cout << script.size() << " byte script:" << std::endl;
+            
+            bytes address;
+            Bitcoin::pattern tree = pay_to_address::pattern(address);
+            compiled_pattern compiled{tree};
+            
+            uint32 matches = 0;
+            bench::report("pattern::match", size, bench::seconds([&]() {
+                for (uint32 i = 0; i < size; i++) if (tree.match(script)) matches++;
+            }));
+            
+            uint32 compiled_matches = 0;
+            bytes_view captured;
+            bench::report("compiled_pattern::match", size, bench::seconds([&]() {
+                for (uint32 i = 0; i < size; i++) if (compiled.match(script, &captured)) compiled_matches++;
+            }));
+            
+            EXPECT_EQ(matches, compiled_matches);
+        }
+        
+    }
+    
+}
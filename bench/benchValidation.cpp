@@ -0,0 +1,44 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include <gigamonkey/script/validation.hpp>
+#include "bench.hpp"
+#include "gtest/gtest.h"
+
+namespace Gigamonkey::Bitcoin {
+    
+    // a transaction with many inputs whose scripts take some work to run. 
+    bytes many_inputs(uint32 inputs, const bytes& unlock) {
+        list<input> in;
+        for (uint32 i = 0; i < inputs; i++) in = in << input{outpoint{txid{uint256{1}}, i}, unlock};
+        return transaction{in, list<output>{output{satoshi{1}, compile(program{OP_1})}}, 0}.write();
+    }
+    
+    TEST(ValidationBenchmark, TestScaling) {
+        bytes lock = compile(program{OP_SHA256, OP_SIZE, push_data(bytes(1, 32)), OP_EQUALVERIFY, OP_DROP, OP_1});
+        bytes unlock = compile(program{push_data(bytes(100000, 0xab))});
+        
+        uint32 inputs = 2000;
+        bytes tx = many_inputs(inputs, unlock);
+        spending x{tx, std::vector<transaction_view::output>(inputs, transaction_view::output{satoshi{1}, lock})};
+        
+        script_cache none{0};
+        for (uint32 threads = 1; threads <= std::thread::hardware_concurrency(); threads *= 2) {
+            work_stealing_pool pool{threads};
+            script_validation v = validate_scripts(x, pool, SCRIPT_VERIFY_NONE, none);
+            EXPECT_TRUE(v.valid());
+            bench::report(std::to_string(threads) + " threads", inputs, v.Seconds);
+        }
+        
+        // the second time, every input is found in the cache. 
+        script_cache cache{};
+        for (std::string run : {"first run", "cached"}) {
+            script_validation v = validate_scripts(x, work_stealing_pool::common(), SCRIPT_VERIFY_NONE, cache);
+            EXPECT_TRUE(v.valid());
+            bench::report(run, inputs, v.Seconds);
+        }
+        
+        std::cout << "hit rate: " << cache.hit_rate() << std::endl;
+    }
+    
+}
@@ -5,6 +5,8 @@
 #define GIGAMONKEY_ACCOUNTS
 
 #include "ledger.hpp"
+#include "compact_map.hpp"
+#include <unordered_set>
 
 namespace Gigamonkey::bookkeeping {
     
@@ -42,8 +44,9 @@ namespace Gigamonkey::bookkeeping {
         }
         
         Amount value() const {
-            if (Entries.size() == 0) return 0;
-            return Entries.first().value() + account{Entries.rest()}.value();
+            Amount x{0};
+            for (const entry<Amount, Time>& e : Entries) x = x + e.Value;
+            return x;
         }
     };
 }
@@ -104,6 +107,87 @@ namespace Gigamonkey::Bitcoin {
             return reduce(txs.first()).reduce(txs.rest());
         }
     };
+    
+    // An account which is updated in place as events come in. The outputs that 
+    // are mine and unspent are kept in a hash table, and the balance after each 
+    // event is kept in order of time, so the balance at any time is found by 
+    // binary search. Events may be given out of order. Inputs which spend 
+    // outputs that are not known to be mine are remembered with their time, 
+    // so that if an earlier event turns out to have made the output, the 
+    // debit is recorded then. Inputs which spend outputs of transactions 
+    // that we already have are not remembered, but the rest are kept until 
+    // their output comes in, which for inputs spending other people's 
+    // outputs is never. That is about 50 bytes for every such input, so 
+    // a long running engine should call prune once events from before 
+    // some time are not expected anymore. 
+    class balance_engine {
+    public:
+        balance_engine() : Transactions{}, Unspent{}, Spends{}, History{}, Received{0}, Spent{0} {}
+        
+        // false if the transaction cannot be read or has been seen already. 
+        // An event which is earlier than the last one is inserted into the 
+        // history, which takes time proportional to the number of later events. 
+        bool ingest(bytes_view tx, timestamp t, const std::vector<uint32>& mine);
+        bool ingest(const account::event&);
+        
+        satoshi balance() const {
+            return History.size() == 0 ? satoshi{0} : satoshi{History.back().Balance};
+        }
+        
+        // the balance after every event at or before the given time. 
+        satoshi balance(timestamp) const;
+        
+        // total that has ever been received or spent. 
+        satoshi received() const {
+            return Received;
+        }
+        
+        satoshi spent() const {
+            return Spent;
+        }
+        
+        bool unspent(const outpoint& o) const {
+            return Unspent.contains(o);
+        }
+        
+        size_t unspent() const {
+            return Unspent.size();
+        }
+        
+        size_t events() const {
+            return Transactions.size();
+        }
+        
+        // the number of inputs remembered because we don't know what they spend. 
+        size_t pending() const {
+            return Spends.size();
+        }
+        
+        // forget inputs from before the given time. An event which comes in 
+        // after this and makes an output that one of them spent will be 
+        // counted as unspent. Returns the number of inputs forgotten. 
+        size_t prune(timestamp before);
+        
+    private:
+        // the balance after all events up to a time. 
+        struct point {
+            uint32 Time;
+            int64 Balance;
+        };
+        
+        std::unordered_set<txid, salted_hasher> Transactions;
+        outpoint_map<satoshi> Unspent;
+        
+        // outputs spent by events which came in before the output was known. 
+        outpoint_map<uint32> Spends;
+        
+        std::vector<point> History;
+        
+        satoshi Received;
+        satoshi Spent;
+        
+        void record(uint32 time, int64 change);
+    };
 }
 
 namespace Gigamonkey::bookkeeping {
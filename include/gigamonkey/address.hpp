@@ -6,6 +6,7 @@
 
 #include "hash.hpp"
 #include "secp256k1.hpp"
+#include "base58.hpp"
 #include <data/encoding/base58.hpp>
 
 namespace Gigamonkey::base58 {
@@ -78,6 +79,9 @@ namespace Gigamonkey::Bitcoin {
 
         string write() const;
 
+        // many addresses at once. 
+        static std::vector<string> write(const std::vector<address>&);
+        
         operator string() const;
 
         static bool valid_prefix(type p);
@@ -135,7 +139,10 @@ namespace Gigamonkey::Bitcoin {
     }
 
     inline string address::write(char prefix, const address::digest& d) {
-        return base58::check{byte(prefix), bytes_view{d}}.encode();
+        byte data[21];
+        data[0] = byte(prefix);
+        std::copy(d.Value.begin(), d.Value.end(), data + 1);
+        return base58::fixed<21>::encode(data);
     }
 
     inline string address::write() const {
@@ -0,0 +1,52 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#ifndef GIGAMONKEY_ADDRESSES
+#define GIGAMONKEY_ADDRESSES
+
+#include "address.hpp"
+#include "parallel.hpp"
+
+namespace Gigamonkey::Bitcoin {
+    
+    // The addresses of many public keys, written into one buffer. Each key 
+    // is checksummed and encoded on the stack, so nothing is allocated for 
+    // each address. The keys are divided among the threads of a pool in 
+    // blocks, and the keys of a block are hashed together. 
+    class addresses {
+    public:
+        // each address begins at a multiple of this. 
+        constexpr static size_t Stride = base58::fixed<21>::MaxSize;
+        
+        // keys which are not the size of a public key are given empty addresses. 
+        // Keys are not otherwise checked. 
+        static addresses write(address::type, const pubkey* keys, size_t size, 
+            work_stealing_pool& = work_stealing_pool::common());
+        
+        static addresses write(address::type t, const std::vector<pubkey>& keys, 
+            work_stealing_pool& pool = work_stealing_pool::common()) {
+            return write(t, keys.data(), keys.size(), pool);
+        }
+        
+        size_t size() const {
+            return Sizes.size();
+        }
+        
+        string_view operator[](size_t i) const {
+            return string_view{Characters.get() + i * Stride, Sizes[i]};
+        }
+        
+        // every address followed by the separator, as for an export. 
+        std::string join(char separator = '\n') const;
+        
+    private:
+        std::unique_ptr<char[]> Characters;
+        std::vector<byte> Sizes;
+        
+        addresses(size_t size) : Characters{new char[size * Stride]}, Sizes(size) {}
+    };
+    
+}
+
+#endif
+
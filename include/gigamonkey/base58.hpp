@@ -0,0 +1,159 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#ifndef GIGAMONKEY_BASE58
+#define GIGAMONKEY_BASE58
+
+#include "hash.hpp"
+#include <array>
+#include <cstdint>
+
+namespace Gigamonkey::base58 {
+    
+    inline constexpr char Characters[] = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+    
+    // the value of each character, or -1. 
+    inline constexpr std::array<std::int8_t, 128> Digits = []() {
+        std::array<std::int8_t, 128> d{};
+        for (std::int8_t& x : d) x = -1;
+        for (std::int8_t i = 0; i < 58; i++) d[Characters[i]] = i;
+        return d;
+    }();
+    
+    // Base 58 check for data of a fixed size, such as addresses, which are 21 
+    // bytes with the version byte, and WIF keys, which are 33 or 34. The data 
+    // and the checksum are held on the stack as 32 bit limbs, which are divided 
+    // or multiplied by 58^5 at a time, so nothing is allocated but the string. 
+    template <size_t size> struct fixed {
+        constexpr static size_t CheckedSize = size + 4;
+        
+        // the largest number of characters that can be written. 
+        constexpr static size_t MaxSize = CheckedSize * 138 / 100 + 1;
+        
+        // out must have room for MaxSize characters. Returns the number written. 
+        static size_t write(const byte* data, char* out);
+        
+        static std::string encode(const byte* data) {
+            char x[MaxSize];
+            return std::string(x, write(data, x));
+        }
+        
+        // an empty string if the data is not the right size. 
+        static std::string encode(bytes_view data) {
+            return data.size() == size ? encode(data.data()) : std::string{};
+        }
+        
+        // many pieces of data written one after another. 
+        static std::vector<std::string> encode_all(bytes_view data);
+        
+        // false if the string is not base 58 check for data of this size. 
+        static bool read(string_view, byte* data);
+    
+    private:
+        constexpr static size_t Limbs = (CheckedSize + 3) / 4;
+        
+        // 58^5, the largest power of 58 less than 2^32. 
+        constexpr static uint32 Base = 656356768;
+    };
+    
+    template <size_t size>
+    size_t fixed<size>::write(const byte* data, char* out) {
+        digest256 digest = Bitcoin::hash256(bytes_view{data, size});
+        
+        // the data and checksum as a big-endian number. 
+        uint32 limbs[Limbs] = {};
+        constexpr size_t offset = Limbs * 4 - CheckedSize;
+        for (size_t i = 0; i < CheckedSize; i++) {
+            size_t p = offset + i;
+            limbs[p / 4] |= uint32(i < size ? data[i] : digest.Value[i - size]) << (8 * (3 - p % 4));
+        }
+        
+        size_t zeros = 0;
+        while (zeros < size && data[zeros] == 0) zeros++;
+        
+        // digits from least to most significant. 
+        byte digits[MaxSize + 5];
+        size_t n = 0;
+        size_t first = 0;
+        while (first < Limbs && limbs[first] == 0) first++;
+        while (first < Limbs) {
+            uint64 remainder = 0;
+            for (size_t j = first; j < Limbs; j++) {
+                uint64 x = (remainder << 32) | limbs[j];
+                limbs[j] = uint32(x / Base);
+                remainder = x % Base;
+            }
+            
+            while (first < Limbs && limbs[first] == 0) first++;
+            
+            for (int k = 0; k < 5; k++) {
+                digits[n++] = byte(remainder % 58);
+                remainder /= 58;
+            }
+        }
+        
+        while (n > 0 && digits[n - 1] == 0) n--;
+        
+        char* x = std::fill_n(out, zeros, '1');
+        while (n > 0) *x++ = Characters[digits[--n]];
+        return x - out;
+    }
+    
+    template <size_t size>
+    std::vector<std::string> fixed<size>::encode_all(bytes_view data) {
+        std::vector<std::string> x;
+        x.reserve(data.size() / size);
+        char b[MaxSize];
+        for (size_t i = 0; i + size <= data.size(); i += size) x.emplace_back(b, write(data.data() + i, b));
+        return x;
+    }
+    
+    template <size_t size>
+    bool fixed<size>::read(string_view s, byte* data) {
+        size_t ones = 0;
+        while (ones < s.size() && s[ones] == '1') ones++;
+        if (ones > size || s.size() - ones > MaxSize) return false;
+        
+        // multiply by 58 up to five digits at a time. 
+        uint32 limbs[Limbs] = {};
+        for (size_t i = ones; i < s.size();) {
+            uint64 digits = 0;
+            uint64 multiplier = 1;
+            for (int k = 0; k < 5 && i < s.size(); k++, i++) {
+                unsigned char c = s[i];
+                if (c >= 128 || Digits[c] < 0) return false;
+                digits = digits * 58 + Digits[c];
+                multiplier *= 58;
+            }
+            
+            uint64 carry = digits;
+            for (size_t j = Limbs; j-- > 0;) {
+                uint64 x = uint64(limbs[j]) * multiplier + carry;
+                limbs[j] = uint32(x);
+                carry = x >> 32;
+            }
+            
+            if (carry != 0) return false;
+        }
+        
+        byte checked[Limbs * 4];
+        for (size_t i = 0; i < Limbs * 4; i++) checked[i] = byte(limbs[i / 4] >> (8 * (3 - i % 4)));
+        
+        constexpr size_t offset = Limbs * 4 - CheckedSize;
+        for (size_t i = 0; i < offset; i++) if (checked[i] != 0) return false;
+        
+        // there is a '1' for every leading zero byte and no more. 
+        size_t zeros = 0;
+        while (zeros < size && checked[offset + zeros] == 0) zeros++;
+        if (zeros != ones) return false;
+        
+        digest256 digest = Bitcoin::hash256(bytes_view{checked + offset, size});
+        if (!std::equal(digest.Value.begin(), digest.Value.begin() + 4, checked + offset + size)) return false;
+        
+        std::copy(checked + offset, checked + offset + size, data);
+        return true;
+    }
+
+}
+
+#endif
@@ -0,0 +1,65 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#ifndef GIGAMONKEY_CACHING_LEDGER
+#define GIGAMONKEY_CACHING_LEDGER
+
+#include "ledger.hpp"
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace Gigamonkey::Bitcoin {
+    
+    // A ledger in front of another ledger which remembers the transactions 
+    // that were most recently looked up. Lookups of many transactions at once 
+    // ask the other ledger only for those that are not remembered, without 
+    // repeats, in a single call. 
+    class caching_ledger final : public ledger {
+    public:
+        caching_ledger(ptr<ledger> l, size_t capacity = 10000) : 
+            Ledger{l}, Capacity{capacity}, Mutex{}, Recent{}, Index{}, Hits{0}, Misses{0} {}
+        
+        list<block_header> headers(uint64 since_height) override {
+            return Ledger->headers(since_height);
+        }
+        
+        data::entry<txid, double_entry> transaction(const txid&) const override;
+        
+        std::vector<data::entry<txid, double_entry>> transactions(const std::vector<txid>&) const override;
+        
+        block_header header(const digest256& d) const override {
+            return Ledger->header(d);
+        }
+        
+        bytes block(const digest256& d) const override {
+            return Ledger->block(d);
+        }
+        
+        size_t size() const;
+        
+        uint64 hits() const;
+        uint64 misses() const;
+        
+    private:
+        using recent = std::list<data::entry<txid, double_entry>>;
+        
+        ptr<ledger> Ledger;
+        size_t Capacity;
+        
+        // the most recently used is at the front. 
+        mutable std::mutex Mutex;
+        mutable recent Recent;
+        mutable std::unordered_map<txid, recent::iterator, salted_hasher> Index;
+        
+        mutable uint64 Hits;
+        mutable uint64 Misses;
+        
+        // these must be called with the lock held. 
+        bool find(const txid&, double_entry&) const;
+        void remember(const data::entry<txid, double_entry>&) const;
+    };
+    
+}
+
+#endif
@@ -0,0 +1,86 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#ifndef GIGAMONKEY_CHANGE_POOL
+#define GIGAMONKEY_CHANGE_POOL
+
+#include "spendable.hpp"
+#include "parallel.hpp"
+#include <exception>
+
+namespace Gigamonkey::Bitcoin {
+    
+    // An output pattern which makes its change ahead of time. A thread of its 
+    // own derives keys and makes scripts with another pattern and puts them 
+    // in a queue. When the queue falls to half full the thread fills it up 
+    // again, so a spend only has to wait if it takes more change at once than 
+    // the pool holds. If the pattern throws, the exception is thrown again by 
+    // next() once the change made before it has been taken. 
+    class change_pool final : public output_pattern {
+    public:
+        change_pool(ptr<output_pattern> pattern, ptr<keysource> keys, uint32 size = 256);
+        ~change_pool();
+        
+        change_pool(const change_pool&) = delete;
+        change_pool& operator=(const change_pool&) = delete;
+        
+        // Keys come from the keysource that the pool was constructed with. 
+        // The one given is set to what follows the keys of the change that 
+        // is returned, so a caller that began with the pool's keysource 
+        // keeps track of which keys have been given out. 
+        change create_redeemable(ptr<keysource>&) const override;
+        
+        uint32 expected_size() const override {
+            return Pattern->expected_size();
+        }
+        
+        // change in the order its keys come from the keysource. 
+        change next() const;
+        
+        // change that is ready to be taken. 
+        size_t available() const {
+            return Queue.size();
+        }
+        
+    private:
+        // change together with the keysource that follows it. 
+        struct made {
+            change Change;
+            ptr<keysource> Keys;
+        };
+        
+        made take() const;
+        
+        ptr<output_pattern> Pattern;
+        
+        // only used by the worker. 
+        ptr<keysource> Keys;
+        
+        mutable bounded_queue<made> Queue;
+        size_t LowWater;
+        
+        mutable std::mutex Mutex;
+        
+        // set by the worker if the pattern throws. 
+        std::exception_ptr Error;
+        mutable std::condition_variable Refill;
+        mutable std::condition_variable Ready;
+        std::atomic<bool> Stop;
+        std::thread Worker;
+        
+        void fill();
+    };
+    
+    inline change change_pool::create_redeemable(ptr<keysource>& k) const {
+        made m = take();
+        k = m.Keys;
+        return m.Change;
+    }
+    
+    inline change change_pool::next() const {
+        return take().Change;
+    }
+    
+}
+
+#endif
@@ -0,0 +1,81 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#ifndef GIGAMONKEY_COIN_SELECTION
+#define GIGAMONKEY_COIN_SELECTION
+
+#include "wallet.hpp"
+
+namespace Gigamonkey::Bitcoin {
+    
+    // Selects outputs to pay a given amount. First a branch-and-bound search 
+    // looks for a set of outputs whose value is close enough to the amount 
+    // and the fee that no change is needed. If there is none, a randomized 
+    // knapsack search and then largest-first selection are tried, which 
+    // make change. The fee for each input comes from the expected size of 
+    // its redeem script, so outputs without a redeemer are not selected. 
+    struct coin_selection {
+        enum method : byte {none, branch_and_bound, knapsack, largest_first};
+        
+        struct result {
+            std::vector<spendable> Inputs;
+            
+            // total value of the inputs. 
+            satoshi Value;
+            satoshi Fee;
+            
+            // zero if there is no change output. 
+            satoshi Change;
+            
+            method Method;
+            
+            bool valid() const {
+                return Method != none;
+            }
+            
+            result() : Inputs{}, Value{0}, Fee{0}, Change{0}, Method{none} {}
+        };
+        
+        // amount to be paid, not counting the fee. 
+        satoshi Target;
+        
+        Bitcoin::fee Fee;
+        
+        // size and sigops of the transaction with its outputs but no inputs, 
+        // as given by estimate::size. 
+        size_t BaseSize;
+        uint32 BaseSigops;
+        
+        // size of a change output and of an input that would spend it. 
+        // By default these are pay to address. 
+        size_t ChangeOutputSize;
+        size_t ChangeInputSize;
+        
+        // change smaller than this is given up to the fee. 
+        satoshi Dust;
+        
+        // steps allowed to the branch-and-bound search. 
+        uint32 MaxTries;
+        
+        coin_selection(satoshi target, Bitcoin::fee f, size_t base_size, uint32 base_sigops = 0, satoshi dust = satoshi{546}) : 
+            Target{target}, Fee{f}, BaseSize{base_size}, BaseSigops{base_sigops}, 
+            ChangeOutputSize{estimate::output_size(estimate::PayToAddressScriptSize)}, 
+            ChangeInputSize{estimate::input_size(estimate::pay_to_address_redeem_size(true))}, Dust{dust}, MaxTries{100000} {}
+        
+        result select(const utxo_set&) const;
+        
+        // each method can also be used alone. 
+        result select_branch_and_bound(const utxo_set&) const;
+        result select_knapsack(const utxo_set&) const;
+        result select_largest_first(const utxo_set&) const;
+        
+        // the fee of a transaction with the given inputs and an optional change output. 
+        satoshi fee(const std::vector<spendable>&, bool change) const;
+        
+        // size of an input spending the output. 
+        static size_t input_size(const spendable&);
+    };
+    
+}
+
+#endif
@@ -0,0 +1,243 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#ifndef GIGAMONKEY_COMPACT_MAP
+#define GIGAMONKEY_COMPACT_MAP
+
+#include "timechain.hpp"
+#include <memory>
+#include <utility>
+
+namespace Gigamonkey::Bitcoin {
+    
+    // salted hashes for keys which are already uniformly distributed. 
+    template <typename key> struct compact_hash;
+    
+    template <> struct compact_hash<digest256> : salted_hasher {};
+    
+    template <> struct compact_hash<outpoint> : salted_hasher {
+        uint64 operator()(const outpoint& o) const {
+            return salted_hasher::operator()(o.Reference, o.Index);
+        }
+    };
+    
+    // A hash table with open addressing for keys such as txids and outpoints. 
+    // Keys and values are stored inline in one array and are found by linear 
+    // probing, so a lookup usually touches one or two cache lines. There is a 
+    // control byte for every slot with seven bits of the hash, so that most 
+    // slots with other keys are passed over without comparing the keys. Entries 
+    // are removed by shifting later entries back, so no tombstones are left. 
+    // Each map has its own hasher, which keeps its salt when the map grows. 
+    template <typename key, typename value, typename hash = compact_hash<key>>
+    class compact_map {
+    public:
+        struct entry {
+            key Key;
+            value Value;
+        };
+        
+        compact_map() : Hash{}, Control{}, Slots{nullptr}, Size{0} {}
+        
+        explicit compact_map(size_t n) : compact_map{} {
+            reserve(n);
+        }
+        
+        compact_map(const compact_map&);
+        compact_map(compact_map&& m) : compact_map{} {
+            swap(m);
+        }
+        
+        compact_map& operator=(const compact_map& m) {
+            compact_map x{m};
+            swap(x);
+            return *this;
+        }
+        
+        compact_map& operator=(compact_map&& m) {
+            swap(m);
+            return *this;
+        }
+        
+        ~compact_map() {
+            clear();
+            if (Slots != nullptr) std::allocator<entry>{}.deallocate(Slots, capacity());
+        }
+        
+        size_t size() const {
+            return Size;
+        }
+        
+        bool empty() const {
+            return Size == 0;
+        }
+        
+        size_t capacity() const {
+            return Control.size();
+        }
+        
+        // make room for n entries without rehashing. 
+        void reserve(size_t n);
+        
+        // nullptr if the key is not present. 
+        value* find(const key& k) {
+            size_t i = locate(k);
+            return i == npos ? nullptr : &Slots[i].Value;
+        }
+        
+        const value* find(const key& k) const {
+            size_t i = locate(k);
+            return i == npos ? nullptr : &Slots[i].Value;
+        }
+        
+        bool contains(const key& k) const {
+            return locate(k) != npos;
+        }
+        
+        // the value for the key and whether it was inserted. 
+        // If the key was already present, nothing is changed. 
+        template <typename... P> std::pair<value*, bool> emplace(const key&, P&&...);
+        
+        bool insert(const key& k, const value& v) {
+            return emplace(k, v).second;
+        }
+        
+        // false if the key was not present. 
+        bool erase(const key&);
+        
+        void clear();
+        
+        template <typename F> void for_each(F f) const {
+            for (size_t i = 0; i < capacity(); i++) if (Control[i] != 0) f(Slots[i].Key, Slots[i].Value);
+        }
+        
+        void swap(compact_map& m) {
+            std::swap(Hash, m.Hash);
+            std::swap(Control, m.Control);
+            std::swap(Slots, m.Slots);
+            std::swap(Size, m.Size);
+        }
+    
+    private:
+        constexpr static size_t npos = size_t(-1);
+        constexpr static size_t MinCapacity = 16;
+        
+        hash Hash;
+        
+        // zero for an empty slot, and otherwise the top bit 
+        // and the seven highest bits of the hash of the key. 
+        std::vector<byte> Control;
+        entry* Slots;
+        size_t Size;
+        
+        size_t mask() const {
+            return capacity() - 1;
+        }
+        
+        static byte tag(uint64 h) {
+            return byte(0x80 | (h >> 57));
+        }
+        
+        size_t locate(const key& k) const;
+        
+        // put an entry which is not present into an empty slot. 
+        template <typename... P> size_t place(uint64 h, const key&, P&&...);
+        
+        void rehash(size_t capacity);
+    };
+    
+    template <typename value> using txid_map = compact_map<txid, value>;
+    template <typename value> using outpoint_map = compact_map<outpoint, value>;
+    
+    template <typename key, typename value, typename hash>
+    compact_map<key, value, hash>::compact_map(const compact_map& m) : 
+        Hash{m.Hash}, Control{m.Control}, Slots{nullptr}, Size{m.Size} {
+        if (m.Slots == nullptr) return;
+        Slots = std::allocator<entry>{}.allocate(capacity());
+        for (size_t i = 0; i < capacity(); i++) if (Control[i] != 0) new (&Slots[i]) entry{m.Slots[i]};
+    }
+    
+    template <typename key, typename value, typename hash>
+    void compact_map<key, value, hash>::reserve(size_t n) {
+        // at most seven eighths of the slots are used. 
+        size_t c = MinCapacity;
+        while (c - c / 8 < n) c <<= 1;
+        if (c > capacity()) rehash(c);
+    }
+    
+    template <typename key, typename value, typename hash>
+    size_t compact_map<key, value, hash>::locate(const key& k) const {
+        if (Size == 0) return npos;
+        uint64 h = Hash(k);
+        byte t = tag(h);
+        for (size_t i = h & mask();; i = (i + 1) & mask()) {
+            if (Control[i] == 0) return npos;
+            if (Control[i] == t && Slots[i].Key == k) return i;
+        }
+    }
+    
+    template <typename key, typename value, typename hash>
+    template <typename... P>
+    size_t compact_map<key, value, hash>::place(uint64 h, const key& k, P&&... p) {
+        size_t i = h & mask();
+        while (Control[i] != 0) i = (i + 1) & mask();
+        new (&Slots[i]) entry{k, value{std::forward<P>(p)...}};
+        Control[i] = tag(h);
+        Size++;
+        return i;
+    }
+    
+    template <typename key, typename value, typename hash>
+    template <typename... P>
+    std::pair<value*, bool> compact_map<key, value, hash>::emplace(const key& k, P&&... p) {
+        size_t i = locate(k);
+        if (i != npos) return {&Slots[i].Value, false};
+        if (Size + 1 > capacity() - capacity() / 8) reserve(Size + 1);
+        return {&Slots[place(Hash(k), k, std::forward<P>(p)...)].Value, true};
+    }
+    
+    template <typename key, typename value, typename hash>
+    bool compact_map<key, value, hash>::erase(const key& k) {
+        size_t i = locate(k);
+        if (i == npos) return false;
+        
+        Slots[i].~entry();
+        Size--;
+        
+        // move back every following entry which would 
+        // not be found again once the hole is there. 
+        for (size_t j = (i + 1) & mask(); Control[j] != 0; j = (j + 1) & mask()) {
+            size_t home = Hash(Slots[j].Key) & mask();
+            if (((j - home) & mask()) < ((j - i) & mask())) continue;
+            new (&Slots[i]) entry{std::move(Slots[j])};
+            Slots[j].~entry();
+            Control[i] = Control[j];
+            i = j;
+        }
+        
+        Control[i] = 0;
+        return true;
+    }
+    
+    template <typename key, typename value, typename hash>
+    void compact_map<key, value, hash>::clear() {
+        for (size_t i = 0; i < capacity(); i++) if (Control[i] != 0) {
+            Slots[i].~entry();
+            Control[i] = 0;
+        }
+        Size = 0;
+    }
+    
+    template <typename key, typename value, typename hash>
+    void compact_map<key, value, hash>::rehash(size_t c) {
+        compact_map x{};
+        x.Hash = Hash;
+        x.Control.resize(c, 0);
+        x.Slots = std::allocator<entry>{}.allocate(c);
+        for (size_t i = 0; i < capacity(); i++) if (Control[i] != 0)
+            x.place(Hash(Slots[i].Key), Slots[i].Key, std::move(Slots[i].Value));
+        swap(x);
+    }
+
+}
+
+#endif
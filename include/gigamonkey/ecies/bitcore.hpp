@@ -4,15 +4,76 @@
 #ifndef GIGAMONKEY_ECIES_BITCORE
 #define GIGAMONKEY_ECIES_BITCORE
 
-#include <gigamonkey/hash.hpp>
-#include <gigamonkey/secp256k1.hpp>
-#include <data/encoding/base58.hpp>
+#include <gigamonkey/ecies/session.hpp>
 
 namespace Gigamonkey::ECIES::bitcore {
     
-    bytes encrypt(const bytes message, const secp256k1::pubkey& to);
+    constexpr size_t IVSize = 16;
+    
+    // A message is the compressed ephemeral public key, the IV, the 
+    // ciphertext with AES-256, and a MAC over the IV and the ciphertext. 
+    // The keys come from SHA-512 of the x coordinate of the shared point. 
+    bytes encrypt(bytes_view message, const secp256k1::pubkey& to);
+    
+    // as bitcore does it, the IV is made from the ephemeral key and the message. 
+    bytes encrypt(bytes_view message, const secp256k1::pubkey& to, const secp256k1::secret& ephemeral);
+    
+    // throws std::invalid_argument if the message cannot be decrypted. 
+    bytes decrypt(bytes_view message, const secp256k1::secret& to);
+    
+    class session;
+    
+    class encryptor final : public ECIES::encryptor {
+    public:
+        // the ephemeral key and the IV are random, since 
+        // the message is not known when the IV is needed. 
+        explicit encryptor(const secp256k1::pubkey& to);
+        encryptor(const secp256k1::pubkey& to, const secp256k1::secret& ephemeral, bytes_view iv);
+        
+    private:
+        encryptor(keys, const secp256k1::pubkey& from, bytes_view iv);
+        friend class session;
+    };
+    
+    class decryptor final : public ECIES::decryptor {
+    public:
+        explicit decryptor(const secp256k1::secret& to);
+        
+    private:
+        secp256k1::secret To;
+        ptr<const key_cache> Cache;
+        
+        decryptor(ptr<const key_cache>);
+        friend class session;
+        
+        keys derive(bytes_view header) const override;
+    };
+    
+    // Messages between our key and others, with our key in place of an 
+    // ephemeral key. Keys are derived once for each party and every 
+    // message has its own random IV, so the same message encrypted 
+    // twice is not the same. 
+    class session {
+    public:
+        explicit session(const secp256k1::secret& ours, size_t capacity = 1024);
+        
+        // with a random IV. 
+        bytes encrypt(bytes_view message, const secp256k1::pubkey& to) const;
+        
+        // messages to us from any key. 
+        bytes decrypt(bytes_view message) const;
+        
+        // with a random IV. 
+        encryptor encrypting(const secp256k1::pubkey& to) const;
+        decryptor decrypting() const;
+        
+        const key_cache& cache() const {
+            return *Cache;
+        }
         
-    bytes decrypt(const bytes message, const secp256k1::secret& to);
+    private:
+        ptr<const key_cache> Cache;
+    };
     
 }
 
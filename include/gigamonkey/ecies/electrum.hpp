@@ -4,15 +4,62 @@
 #ifndef GIGAMONKEY_ECIES_ELECTRUM
 #define GIGAMONKEY_ECIES_ELECTRUM
 
-#include <gigamonkey/hash.hpp>
-#include <gigamonkey/secp256k1.hpp>
-#include <data/encoding/base58.hpp>
+#include <gigamonkey/ecies/session.hpp>
 
 namespace Gigamonkey::ECIES::electrum {
     
-    bytes encrypt(const bytes message, const secp256k1::pubkey& to);
+    // A message is the magic bytes "BIE1", the compressed ephemeral public 
+    // key, the ciphertext with AES-128, and a MAC over all of that. The keys 
+    // and the IV come from SHA-512 of the compressed shared point. 
+    bytes encrypt(bytes_view message, const secp256k1::pubkey& to);
+    bytes encrypt(bytes_view message, const secp256k1::pubkey& to, const secp256k1::secret& ephemeral);
+    
+    // throws std::invalid_argument if the message cannot be decrypted. 
+    bytes decrypt(bytes_view message, const secp256k1::secret& to);
+    
+    class session;
+    
+    class encryptor final : public ECIES::encryptor {
+    public:
+        explicit encryptor(const secp256k1::pubkey& to) : encryptor{to, ephemeral()} {}
+        encryptor(const secp256k1::pubkey& to, const secp256k1::secret& ephemeral);
+    };
+    
+    class decryptor final : public ECIES::decryptor {
+    public:
+        explicit decryptor(const secp256k1::secret& to);
+        
+    private:
+        secp256k1::secret To;
+        ptr<const key_cache> Cache;
+        
+        decryptor(ptr<const key_cache>);
+        friend class session;
+        
+        keys derive(bytes_view header) const override;
+    };
+    
+    // Messages to our key. Keys are derived once for each ephemeral key, 
+    // which saves time when a sender reuses its ephemeral key. There is no 
+    // sending side: since the IV is derived along with the keys, a sender 
+    // which reused its key would give every message the same key and IV, 
+    // so each message must be encrypted with a new ephemeral key. 
+    class session {
+    public:
+        explicit session(const secp256k1::secret& ours, size_t capacity = 1024);
+        
+        // messages to us from any key. 
+        bytes decrypt(bytes_view message) const;
+        
+        decryptor decrypting() const;
+        
+        const key_cache& cache() const {
+            return *Cache;
+        }
         
-    bytes decrypt(const bytes message, const secp256k1::secret& to);
+    private:
+        ptr<const key_cache> Cache;
+    };
     
 }
 
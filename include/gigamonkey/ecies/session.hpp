@@ -0,0 +1,64 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#ifndef GIGAMONKEY_ECIES_SESSION
+#define GIGAMONKEY_ECIES_SESSION
+
+#include <gigamonkey/ecies/stream.hpp>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace Gigamonkey::ECIES {
+    
+    // Keys for messages between one secret key and many public keys. Finding 
+    // the shared point is a scalar multiplication, which costs far more than 
+    // the rest of a short message, so the keys for the public keys that were 
+    // most recently used are remembered. It is safe to use from many threads. 
+    class key_cache {
+    public:
+        // keys from the shared point, without the IV if it is not derived. 
+        using derivation = keys (*)(const secp256k1::pubkey& shared);
+        
+        key_cache(const secp256k1::secret& s, derivation d, size_t capacity) : 
+            Secret{s}, Pubkey{s.to_public()}, Derive{d}, Capacity{capacity}, 
+            Mutex{}, Recent{}, Index{}, Hits{0}, Misses{0} {}
+        
+        const secp256k1::secret& secret() const {
+            return Secret;
+        }
+        
+        // compressed. 
+        const secp256k1::pubkey& pubkey() const {
+            return Pubkey;
+        }
+        
+        // throws std::invalid_argument if the public key is not valid. 
+        keys get(const secp256k1::pubkey& theirs) const;
+        
+        size_t size() const;
+        
+        uint64 hits() const;
+        uint64 misses() const;
+        
+    private:
+        using recent = std::list<std::pair<bytes, keys>>;
+        
+        secp256k1::secret Secret;
+        secp256k1::pubkey Pubkey;
+        derivation Derive;
+        size_t Capacity;
+        
+        // the most recently used is at the front. 
+        mutable std::mutex Mutex;
+        mutable recent Recent;
+        mutable std::unordered_map<bytes, recent::iterator, salted_hasher> Index;
+        
+        mutable uint64 Hits;
+        mutable uint64 Misses;
+    };
+    
+}
+
+#endif
+
@@ -0,0 +1,86 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#ifndef GIGAMONKEY_ECIES_STREAM
+#define GIGAMONKEY_ECIES_STREAM
+
+#include <gigamonkey/hash.hpp>
+#include <gigamonkey/secp256k1.hpp>
+#include <memory>
+
+namespace Gigamonkey::ECIES {
+    
+    // Both schemes encrypt with AES in CBC mode with PKCS#7 padding and 
+    // authenticate with HMAC-SHA256 at the end of the message. They differ 
+    // in how the keys are derived and in what comes before the ciphertext. 
+    struct keys {
+        bytes Encryption;
+        bytes IV;
+        bytes Authentication;
+    };
+    
+    // A message which is encrypted a piece at a time. Ciphertext is returned 
+    // as soon as it is available, so memory does not depend on message size. 
+    class encryptor {
+    public:
+        // ciphertext for as much of the message as can be written so far. 
+        bytes update(bytes_view);
+        
+        // the rest of the ciphertext and the MAC. 
+        bytes finalize();
+        
+        encryptor(encryptor&&);
+        encryptor& operator=(encryptor&&);
+        virtual ~encryptor();
+    
+    protected:
+        // the header is written before the ciphertext and the 
+        // part of it after the first unauthenticated bytes is 
+        // covered by the MAC along with the ciphertext. 
+        encryptor(const keys&, bytes header, size_t unauthenticated);
+    
+    private:
+        struct state;
+        std::unique_ptr<state> State;
+    };
+    
+    // A message which is decrypted a piece at a time. Plaintext which is 
+    // returned by update has not been authenticated until finalize returns. 
+    // Both throw std::invalid_argument if the message cannot be decrypted. 
+    class decryptor {
+    public:
+        bytes update(bytes_view);
+        
+        // the rest of the plaintext once the MAC is checked. 
+        bytes finalize();
+        
+        decryptor(decryptor&&);
+        decryptor& operator=(decryptor&&);
+        virtual ~decryptor();
+    
+    protected:
+        decryptor(size_t header_size, size_t unauthenticated);
+        
+        // keys from the header of the message. 
+        virtual keys derive(bytes_view header) const = 0;
+    
+    private:
+        struct state;
+        std::unique_ptr<state> State;
+        
+        size_t HeaderSize;
+        size_t Unauthenticated;
+        bytes Header;
+        
+        // the last bytes seen, which may be the MAC. 
+        bytes Tail;
+        
+        bytes feed(bytes_view);
+    };
+    
+    // a secret key which is not likely to have been used before. 
+    secp256k1::secret ephemeral();
+
+}
+
+#endif
@@ -0,0 +1,81 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#ifndef GIGAMONKEY_ESTIMATE
+#define GIGAMONKEY_ESTIMATE
+
+#include <gigamonkey/signature.hpp>
+
+namespace Gigamonkey::Bitcoin {
+    
+    // The size and sigops of a transaction which has not been built. The size 
+    // of a transaction depends only on the numbers of inputs and outputs and 
+    // on the sizes of their scripts, so totals are kept as they are added and 
+    // nothing is serialized. 
+    struct estimate {
+        // a DER signature with low S is at most 71 bytes. With the 
+        // sighash directive and the push op it is at most 73. 
+        constexpr static size_t MaxSignaturePushSize = 73;
+        
+        constexpr static size_t pubkey_push_size(bool compressed) {
+            return compressed ? 34 : 66;
+        }
+        
+        // sizes of the scripts of standard outputs. 
+        constexpr static size_t PayToAddressScriptSize = 25;
+        
+        constexpr static size_t pay_to_pubkey_script_size(bool compressed) {
+            return pubkey_push_size(compressed) + 1;
+        }
+        
+        // largest sizes of the scripts that redeem them. 
+        constexpr static size_t PayToPubkeyRedeemSize = MaxSignaturePushSize;
+        
+        constexpr static size_t pay_to_address_redeem_size(bool compressed) {
+            return MaxSignaturePushSize + pubkey_push_size(compressed);
+        }
+        
+        // an outpoint, a script, and a sequence number. 
+        static size_t input_size(size_t script) {
+            return 40 + writer::var_int_size(script) + script;
+        }
+        
+        // a value and a script. 
+        static size_t output_size(size_t script) {
+            return 8 + writer::var_int_size(script) + script;
+        }
+        
+        size_t Inputs;
+        size_t Outputs;
+        
+        // sizes of the inputs and outputs without their numbers. 
+        size_t InputsSize;
+        size_t OutputsSize;
+        
+        uint32 Sigops;
+        
+        estimate() : Inputs{0}, Outputs{0}, InputsSize{0}, OutputsSize{0}, Sigops{0} {}
+        
+        estimate& add_input(size_t script, uint32 sigops = 0) {
+            Inputs++;
+            InputsSize += input_size(script);
+            Sigops += sigops;
+            return *this;
+        }
+        
+        estimate& add_output(size_t script, uint32 sigops = 0) {
+            Outputs++;
+            OutputsSize += output_size(script);
+            Sigops += sigops;
+            return *this;
+        }
+        
+        // version and locktime are four bytes each. 
+        size_t size() const {
+            return 8 + writer::var_int_size(Inputs) + writer::var_int_size(Outputs) + InputsSize + OutputsSize;
+        }
+    };
+
+}
+
+#endif
@@ -10,6 +10,9 @@
 #include <data/math/number/bytes/N.hpp>
 
 #include "arith_uint256.h"
+#include <crypto/sha256.h>
+#include <algorithm>
+#include <random>
 
 namespace Gigamonkey {
     
@@ -145,13 +148,102 @@ namespace Gigamonkey {
     using digest256 = digest<32>;
     using digest512 = digest<64>;
     
+    // A hash for tables whose keys are digests, such as txids. Eight bytes of a 
+    // digest are as good as any others, but whoever chooses the keys could grind 
+    // them to collide, so the bytes are mixed with a salt which is random for 
+    // each hasher, as with Bitcoin Core's salted hashers. 
+    class salted_hasher {
+    public:
+        salted_hasher();
+        salted_hasher(uint64 k0, uint64 k1) : K0{k0}, K1{k1 | 1} {}
+        
+        template <size_t size> uint64 operator()(const digest<size>& d) const {
+            return mix(first(d.begin()), 0);
+        }
+        
+        // a digest and an index, as for an outpoint. 
+        uint64 operator()(const digest256& d, uint32 index) const {
+            return mix(first(d.begin()), index);
+        }
+        
+        // data which is already random, such as a public key. 
+        uint64 operator()(bytes_view b) const {
+            uint64 x = 0;
+            std::copy(b.begin(), b.begin() + std::min(b.size(), sizeof(uint64)), reinterpret_cast<byte*>(&x));
+            return mix(x, b.size());
+        }
+        
+    private:
+        uint64 K0;
+        uint64 K1;
+        
+        static uint64 first(const byte* b) {
+            uint64 x;
+            std::copy(b, b + sizeof(uint64), reinterpret_cast<byte*>(&x));
+            return x;
+        }
+        
+        // the finalizer of splitmix64, so that every bit 
+        // of the result depends on every bit of the input. 
+        uint64 mix(uint64 x, uint64 extra) const {
+            x = (x ^ K0) + extra * K1;
+            x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+            x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+            return x ^ (x >> 31);
+        }
+    };
+    
+    inline salted_hasher::salted_hasher() {
+        static thread_local std::mt19937_64 Random{std::random_device{}()};
+        K0 = Random();
+        K1 = Random() | 1;
+    }
+    
     // standard hash functions. 
     digest160 ripemd160(bytes_view b);
     digest256 sha256(bytes_view b);
+    digest512 sha512(bytes_view b);
     
     digest160 ripemd160(string_view b);
     digest256 sha256(string_view b);
     
+    // SHA-256 applied some number of times to everything written with <<. The 
+    // data goes straight into the hash, so nothing needs to be concatenated 
+    // into a buffer before it is hashed. 
+    template <size_t rounds> class basic_sha256_writer {
+    public:
+        basic_sha256_writer& write(const byte* b, size_t size) {
+            Hasher.Write(b, size);
+            return *this;
+        }
+        
+        basic_sha256_writer& operator<<(bytes_view b) {
+            return write(b.data(), b.size());
+        }
+        
+        basic_sha256_writer& operator<<(byte b) {
+            return write(&b, 1);
+        }
+        
+        template <boost::endian::order Order, bool is_signed, std::size_t bytes>
+        basic_sha256_writer& operator<<(const endian::arithmetic<Order, is_signed, bytes>& x) {
+            return write(reinterpret_cast<const byte*>(x.data()), bytes);
+        }
+        
+        // the writer should not be used again afterwards. 
+        digest256 finalize() {
+            digest256 d;
+            Hasher.Finalize(d.Value.data());
+            for (size_t i = 1; i < rounds; i++) CSHA256{}.Write(d.Value.data(), 32).Finalize(d.Value.data());
+            return d;
+        }
+    
+    private:
+        CSHA256 Hasher;
+    };
+    
+    using sha256_writer = basic_sha256_writer<1>;
+    
     namespace Bitcoin {
     
         // bitcoin hash functions. 
@@ -161,6 +253,19 @@ namespace Gigamonkey {
         digest160 hash160(string_view b);
         digest256 hash256(string_view b);
         
+        // for example, (hash256_writer{} << a << b).finalize() is hash256(write(64, a, b)). 
+        using hash256_writer = basic_sha256_writer<2>;
+        
+        // hash160 of many messages at once. Messages of up to 55 bytes, such 
+        // as public keys, are hashed eight at a time in vector registers. 
+        void hash160_batch(const bytes_view* in, digest160* out, size_t size);
+        
+        inline std::vector<digest160> hash160_batch(const std::vector<bytes_view>& in) {
+            std::vector<digest160> out(in.size());
+            hash160_batch(in.data(), out.data(), in.size());
+            return out;
+        }
+        
         inline digest160 address_hash(bytes_view b) {
             return hash160(b);
         }
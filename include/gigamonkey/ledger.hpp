@@ -6,6 +6,7 @@
 
 #include "spv.hpp"
 #include <gigamonkey/script/script.hpp>
+#include <algorithm>
 
 namespace Gigamonkey::Bitcoin {
     
@@ -70,6 +71,15 @@ namespace Gigamonkey::Bitcoin {
         
         virtual data::entry<txid, double_entry> transaction(const txid&) const = 0;
         
+        // look up many transactions at once. A backend for which each lookup 
+        // is a round trip should override this to make only one. 
+        virtual std::vector<data::entry<txid, double_entry>> transactions(const std::vector<txid>& ids) const {
+            std::vector<data::entry<txid, double_entry>> x;
+            x.reserve(ids.size());
+            for (const txid& id : ids) x.push_back(transaction(id));
+            return x;
+        }
+        
         // get header by header hash and merkle root.
         virtual block_header header(const digest256&) const = 0; 
         
@@ -110,7 +120,7 @@ namespace Gigamonkey::Bitcoin {
             
             satoshi spent() const {
                 return data::fold([](satoshi x, const prevout& p) -> satoshi {
-                    return p.spent();
+                    return x + p.spent();
                 }, satoshi{0}, prevouts());
             }
             
@@ -118,6 +128,8 @@ namespace Gigamonkey::Bitcoin {
                 return spent() - sent();
             }
             
+            // scripts are checked on the common pool. Called from 
+            // inside a loop of a pool, they are checked on this thread. 
             bool valid() const;
             
             uint32 sigops() const;
@@ -141,10 +153,19 @@ namespace Gigamonkey::Bitcoin {
             }
         };
         
+        // each previous transaction is looked up once, 
+        // all in one call to transactions(). 
         vertex make_vertex(const double_entry& d) {
-            list<input> in = d.inputs();
+            transaction_view t{*d};
+            std::vector<txid> ids;
+            ids.reserve(t.Inputs.size());
+            for (const transaction_view::input& in : t.Inputs) 
+                ids.push_back(outpoint::reference(slice<36>(const_cast<byte*>(in.Outpoint.data()))));
+            std::sort(ids.begin(), ids.end());
+            ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+            
             data::map<txid, double_entry> p;
-            for (const input& i : in) p = p.insert(transaction(i.Outpoint.Reference));
+            for (const data::entry<txid, double_entry>& x : transactions(ids)) p = p.insert(x);
             return {d, p};
         }
     
@@ -194,16 +215,20 @@ namespace Gigamonkey::Bitcoin {
         return Header > t.Header;
     }
     
+    // only the output or input that is asked for is read and copied. 
     Bitcoin::output inline ledger::double_entry::output(uint32 i) const {
-        auto t = Bitcoin::transaction::read(ptr<bytes>::operator*());
-        if (!t.valid() || t.Outputs.size() <= i) return {};
-        return t.Outputs[i];
+        Bitcoin::transaction_view::output out;
+        if (!Bitcoin::transaction_view::find_output(ptr<bytes>::operator*(), i, out)) return {};
+        return Bitcoin::output{out.Value, bytes{out.Script}};
     }
     
     Bitcoin::input inline ledger::double_entry::input(uint32 i) const {
-        auto t = Bitcoin::transaction::read(ptr<bytes>::operator*());
-        if (!t.valid() || t.Inputs.size() <= i) return {};
-        return t.Inputs[i];
+        Bitcoin::transaction_view::input in;
+        if (!Bitcoin::transaction_view::find_input(ptr<bytes>::operator*(), i, in)) return {};
+        slice<36> op{const_cast<byte*>(in.Outpoint.data())};
+        return Bitcoin::input{
+            Bitcoin::outpoint{Bitcoin::outpoint::reference(op), Bitcoin::outpoint::index(op)}, 
+            bytes{in.Script}, in.Sequence};
     }
     
 }
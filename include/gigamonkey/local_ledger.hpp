@@ -0,0 +1,127 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#ifndef GIGAMONKEY_LOCAL_LEDGER
+#define GIGAMONKEY_LOCAL_LEDGER
+
+#include "ledger.hpp"
+#include <mutex>
+#include <memory>
+#include <unordered_map>
+
+namespace Gigamonkey::Bitcoin {
+    
+    // A ledger kept in files in a directory. Transactions, headers, Merkle 
+    // proofs and blocks are appended as records to segment files of a fixed 
+    // size, which are mapped into memory, so writing a record is a copy and 
+    // reading one needs no copy at all. The indices from txid and from block 
+    // hash to records are kept in memory and are rebuilt when the ledger is 
+    // opened. Only one process should open a directory at a time. 
+    class local_ledger final : public ledger {
+    public:
+        constexpr static size_t DefaultSegmentSize = size_t{1} << 28;
+        
+        // open the ledger in a directory, which is created if necessary. 
+        // Throws std::runtime_error if the files cannot be opened. 
+        explicit local_ledger(const std::string& directory, size_t segment_size = DefaultSegmentSize);
+        ~local_ledger();
+        
+        local_ledger(const local_ledger&) = delete;
+        local_ledger& operator=(const local_ledger&) = delete;
+        
+        // false if the transaction cannot be read or is already known. 
+        bool add_transaction(bytes_view tx);
+        
+        // headers must be added in order, starting from any header. 
+        bool add_header(const Bitcoin::header&);
+        
+        // the root of the proof must be that of a known header. 
+        bool add_proof(const Merkle::proof&);
+        
+        // adds the header, the transactions and a proof for each of them. 
+        bool add_block(bytes_view block);
+        
+        // a transaction as it is stored, which is valid as long as the ledger is. 
+        bytes_view view(const txid&) const;
+        
+        list<block_header> headers(uint64 since_height) override;
+        
+        data::entry<txid, double_entry> transaction(const txid&) const override;
+        
+        // all are looked up with the lock taken once. 
+        std::vector<data::entry<txid, double_entry>> transactions(const std::vector<txid>&) const override;
+        
+        // by header hash or by merkle root. 
+        block_header header(const digest256&) const override;
+        bytes block(const digest256&) const override;
+        
+        // the number of transactions. 
+        size_t size() const;
+        
+        // the number of headers. 
+        uint64 height() const;
+        
+        // write everything to disk. 
+        void flush() const;
+    
+    private:
+        enum kind : byte {
+            none = 0,
+            transaction_record = 1,
+            header_record = 2,
+            proof_record = 3,
+            block_record = 4
+        };
+        
+        // a record is a kind, a four byte length, and a payload. 
+        constexpr static size_t RecordHeaderSize = 5;
+        
+        struct segment {
+            int File;
+            byte* Data;
+            size_t Size;
+            size_t Used;
+        };
+        
+        // where the payload of a record is. 
+        struct location {
+            uint32 Segment;
+            uint32 Offset;
+            uint32 Length;
+        };
+        
+        struct stored_header {
+            digest256 Hash;
+            Bitcoin::header Header;
+            work::difficulty Cumulative;
+        };
+        
+        std::string Directory;
+        size_t SegmentSize;
+        std::vector<std::unique_ptr<segment>> Segments;
+        
+        mutable std::mutex Mutex;
+        std::unordered_map<txid, location, salted_hasher> Transactions;
+        std::unordered_map<txid, location, salted_hasher> Proofs;
+        std::unordered_map<digest256, location, salted_hasher> Blocks;
+        std::vector<stored_header> Headers;
+        std::unordered_map<digest256, uint32, salted_hasher> ByHash;
+        std::unordered_map<digest256, uint32, salted_hasher> ByRoot;
+        
+        // these must be called with the lock held. 
+        bool open(uint32 segment_index);
+        bool append(kind, std::initializer_list<bytes_view> parts, location&);
+        void index(kind, const location&);
+        bytes_view read(const location&) const;
+        const stored_header* find_header(const digest256&) const;
+        data::entry<txid, double_entry> find_transaction(const txid&) const;
+        block_header make_header(uint32 height) const;
+        Merkle::proof make_proof(const location&, Bitcoin::header&) const;
+        bool insert_header(const Bitcoin::header&);
+        bool insert_transaction(bytes_view);
+        bool insert_proof(const Merkle::proof&);
+    };
+
+}
+
+#endif
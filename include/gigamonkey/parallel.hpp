@@ -0,0 +1,158 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#ifndef GIGAMONKEY_PARALLEL
+#define GIGAMONKEY_PARALLEL
+
+#include <gigamonkey/types.hpp>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <optional>
+#include <memory>
+
+namespace Gigamonkey {
+    
+    // A pool of threads which run loops over a range of indices. Each thread 
+    // begins with an equal share of the range. A thread which finishes its 
+    // share steals half of what is left of the largest remaining share. 
+    class work_stealing_pool {
+    public:
+        // the calling thread works too, so a pool of one thread starts no others. 
+        explicit work_stealing_pool(uint32 threads = std::thread::hardware_concurrency());
+        ~work_stealing_pool();
+        
+        work_stealing_pool(const work_stealing_pool&) = delete;
+        work_stealing_pool& operator=(const work_stealing_pool&) = delete;
+        
+        uint32 threads() const {
+            return Shares.size();
+        }
+        
+        // call f(i) for every i < n and return when all the calls are done. 
+        // f must not throw. Loops from different threads run one at a time. 
+        // A loop started from inside f, or from a worker of any pool, runs 
+        // on the calling thread alone, since the workers are already busy. 
+        void run(size_t n, const std::function<void(size_t)>& f);
+        
+        // a pool with a thread for every core. 
+        static work_stealing_pool& common();
+        
+    private:
+        struct share {
+            std::mutex Mutex;
+            size_t Begin;
+            size_t End;
+        };
+        
+        std::vector<share> Shares;
+        std::vector<std::thread> Workers;
+        
+        std::mutex Running;
+        
+        std::mutex Mutex;
+        std::condition_variable Start;
+        std::condition_variable Done;
+        const std::function<void(size_t)>* Job;
+        uint64 Generation;
+        uint32 Working;
+        bool Stop;
+        
+        void work(uint32 thread);
+        bool next(uint32 thread, size_t& i);
+    };
+    
+    // A queue of fixed capacity which any number of threads can push to and 
+    // pop from without locking. Every cell has a sequence number which says 
+    // whether it is ready to be written or to be read in the current round. 
+    template <typename X>
+    class bounded_queue {
+    public:
+        // the capacity is rounded up to a power of two. 
+        explicit bounded_queue(size_t capacity);
+        
+        bounded_queue(const bounded_queue&) = delete;
+        bounded_queue& operator=(const bounded_queue&) = delete;
+        
+        // false if the queue is full, in which case x is not moved from. 
+        bool push(X&& x);
+        
+        // false if the queue is empty. 
+        bool pop(X& x);
+        
+        size_t capacity() const {
+            return Mask + 1;
+        }
+        
+        // only approximate while other threads are using the queue. 
+        size_t size() const {
+            size_t tail = Tail.load(std::memory_order_relaxed);
+            size_t head = Head.load(std::memory_order_relaxed);
+            return tail > head ? tail - head : 0;
+        }
+        
+    private:
+        struct cell {
+            std::atomic<size_t> Sequence;
+            std::optional<X> Value;
+        };
+        
+        std::unique_ptr<cell[]> Cells;
+        size_t Mask;
+        
+        // kept on separate cache lines since they are written by different threads. 
+        alignas(64) std::atomic<size_t> Head;
+        alignas(64) std::atomic<size_t> Tail;
+    };
+    
+    template <typename X>
+    bounded_queue<X>::bounded_queue(size_t capacity) : Cells{}, Mask{0}, Head{0}, Tail{0} {
+        size_t size = 1;
+        while (size < capacity) size <<= 1;
+        Cells = std::unique_ptr<cell[]>{new cell[size]};
+        Mask = size - 1;
+        for (size_t i = 0; i < size; i++) Cells[i].Sequence.store(i, std::memory_order_relaxed);
+    }
+    
+    template <typename X>
+    bool bounded_queue<X>::push(X&& x) {
+        size_t position = Tail.load(std::memory_order_relaxed);
+        cell* c;
+        while (true) {
+            c = &Cells[position & Mask];
+            int64 diff = int64(c->Sequence.load(std::memory_order_acquire)) - int64(position);
+            if (diff == 0) {
+                if (Tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) return false;
+            else position = Tail.load(std::memory_order_relaxed);
+        }
+        
+        c->Value.emplace(std::move(x));
+        c->Sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+    
+    template <typename X>
+    bool bounded_queue<X>::pop(X& x) {
+        size_t position = Head.load(std::memory_order_relaxed);
+        cell* c;
+        while (true) {
+            c = &Cells[position & Mask];
+            int64 diff = int64(c->Sequence.load(std::memory_order_acquire)) - int64(position + 1);
+            if (diff == 0) {
+                if (Head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) return false;
+            else position = Head.load(std::memory_order_relaxed);
+        }
+        
+        x = std::move(*c->Value);
+        c->Value.reset();
+        c->Sequence.store(position + Mask + 1, std::memory_order_release);
+        return true;
+    }
+    
+}
+
+#endif
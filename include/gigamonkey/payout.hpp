@@ -0,0 +1,75 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#ifndef GIGAMONKEY_PAYOUT
+#define GIGAMONKEY_PAYOUT
+
+#include "spendable.hpp"
+#include "wallet.hpp"
+#include "parallel.hpp"
+
+namespace Gigamonkey::Bitcoin {
+    
+    // Pays a large number of recipients with as few transactions as the size 
+    // limit allows. The payments are split up in order, sizes and fees are 
+    // calculated without serializing anything, inputs for all the transactions 
+    // are chosen in one pass over the funds from largest to smallest, and 
+    // every input of every transaction is signed in parallel. 
+    struct payout {
+        
+        // one of the transactions that was made. 
+        struct batch {
+            bytes Transaction;
+            txid ID;
+            
+            // the payments in this transaction are its first outputs. 
+            // If there is change, it is the last output. 
+            uint32 Payments;
+            
+            satoshi Fee;
+            satoshi Change;
+        };
+        
+        struct result {
+            std::vector<batch> Batches;
+            
+            // the funds that were not spent together with the change. 
+            funds Remainder;
+            
+            satoshi Fee;
+            
+            bool valid() const {
+                return Batches.size() != 0;
+            }
+            
+            result() : Batches{}, Remainder{}, Fee{0} {}
+        };
+        
+        Bitcoin::fee Fee;
+        
+        ptr<output_pattern> Change;
+        
+        // no transaction will be larger than this. A tenth of 
+        // the space is kept for inputs when payments are split up, 
+        // and if the inputs need more, the payments are split again. 
+        size_t MaxSize;
+        
+        // payments smaller than this are not made and 
+        // change smaller than this is given up to the fee. 
+        satoshi Dust;
+        
+        sighash::directive Directive;
+        
+        payout(Bitcoin::fee f, ptr<output_pattern> change, size_t max_size = 1000000, satoshi dust = satoshi{546}) :
+            Fee{f}, Change{change}, MaxSize{max_size}, Dust{dust}, Directive{sighash::all | sighash::fork_id} {}
+        
+        // Change keys are taken from the keysource only for change that is made, 
+        // and the keysource is left as it was unless the result is valid. The 
+        // result is invalid if the funds are not sufficient. 
+        result pay(const std::vector<payment>&, const funds&, ptr<keysource>& keys,
+            work_stealing_pool& = work_stealing_pool::common()) const;
+    };
+
+}
+
+#endif
@@ -5,6 +5,7 @@
 #define GIGAMONKEY_REDEEM
 
 #include <gigamonkey/ledger.hpp>
+#include <gigamonkey/estimate.hpp>
 #include <gigamonkey/script/script.hpp>
 #include <gigamonkey/wif.hpp>
 
@@ -23,19 +24,21 @@ namespace Gigamonkey::Bitcoin::redemption {
             return (Secret == nullptr) || (Script.size() == 0);
         }
         
-        bytes redeem(bytes_view tx, index i, bool dummy_signature = false) const {
+        bytes redeem(bytes_view tx, index i, const output& spent, bool dummy_signature = false) const {
             return Secret == nullptr ? Script : 
-                compile(Bitcoin::program{} << push_data(dummy_signature ? signature{} : Secret->sign(tx, i, Directive)));
+                compile(Bitcoin::program{} << push_data(dummy_signature ? signature{} : Secret->sign(tx, i, Directive, spent)));
         };
         
+        // a signature is pushed with its sighash directive. 
         uint32 expected_size() const {
-            return Secret == nullptr ? Script.size() : signature::MaxSignatureSize;
+            return Secret == nullptr ? Script.size() : estimate::MaxSignaturePushSize;
         };
     };
     
     using incomplete = list<element>;
     
-    bytes redeem(incomplete x, bytes_view tx, index i, bool dummy_signature = false);
+    // the script for input i, which spends the given output. 
+    bytes redeem(incomplete x, bytes_view tx, index i, const output& spent, bool dummy_signature = false);
     
     uint32 expected_size(incomplete x);
 }
@@ -0,0 +1,83 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#ifndef GIGAMONKEY_SCRIPT_CACHE
+#define GIGAMONKEY_SCRIPT_CACHE
+
+#include <gigamonkey/timechain.hpp>
+#include <atomic>
+#include <mutex>
+#include <deque>
+#include <unordered_set>
+
+namespace Gigamonkey::Bitcoin {
+    
+    // A set of inputs whose scripts are known to be valid, like the 
+    // signature cache in bitcoind. An entry is a salted hash of the 
+    // txid, the input index, the spent output and the flags, so that 
+    // its contents cannot be predicted by anyone else. Only successes 
+    // are kept. When the cache is full, the oldest entries are dropped. 
+    class script_cache {
+    public:
+        constexpr static size_t DefaultCapacity = 1 << 20;
+        
+        // a cache of capacity zero keeps nothing. 
+        explicit script_cache(size_t capacity = DefaultCapacity);
+        
+        script_cache(const script_cache&) = delete;
+        script_cache& operator=(const script_cache&) = delete;
+        
+        digest256 key(const txid&, index, const transaction_view::output& spent, uint32 flags) const;
+        
+        // whether the key is in the cache. This is counted as a hit or a miss. 
+        bool contains(const digest256&);
+        
+        void insert(const digest256&);
+        
+        void clear();
+        
+        size_t capacity() const {
+            return Capacity;
+        }
+        
+        size_t size() const;
+        
+        uint64 hits() const {
+            return Hits;
+        }
+        
+        uint64 misses() const {
+            return Misses;
+        }
+        
+        double hit_rate() const {
+            uint64 total = Hits + Misses;
+            return total == 0 ? 0 : double(Hits) / double(total);
+        }
+        
+        static script_cache& common();
+        
+    private:
+        constexpr static uint32 Shards = 16;
+        
+        struct shard {
+            mutable std::mutex Mutex;
+            std::unordered_set<digest256, salted_hasher> Keys;
+            std::deque<digest256> Order;
+        };
+        
+        size_t Capacity;
+        uint256 Salt;
+        shard Shard[Shards];
+        
+        std::atomic<uint64> Hits;
+        std::atomic<uint64> Misses;
+        
+        shard& get(const digest256& d) {
+            return Shard[d.begin()[31] % Shards];
+        }
+    };
+    
+}
+
+#endif
@@ -0,0 +1,25 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#ifndef GIGAMONKEY_SCRIPT_CHECKER
+#define GIGAMONKEY_SCRIPT_CHECKER
+
+#include <gigamonkey/signature_cache.hpp>
+#include "script/interpreter.h"
+
+namespace Gigamonkey::Bitcoin {
+    
+    // A signature checker for the interpreter which looks 
+    // in secp256k1::signature_cache::common() before it 
+    // verifies a signature. 
+    class cached_signature_checker : public TransactionSignatureChecker {
+    public:
+        using TransactionSignatureChecker::TransactionSignatureChecker;
+        
+    protected:
+        bool VerifySignature(const std::vector<uint8_t>& sig, const CPubKey& pubkey, const ::uint256& sighash) const override;
+    };
+    
+}
+
+#endif
@@ -0,0 +1,54 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#ifndef GIGAMONKEY_SCRIPT_CLASSIFIER
+#define GIGAMONKEY_SCRIPT_CLASSIFIER
+
+#include <gigamonkey/script/script.hpp>
+#include <gigamonkey/timechain.hpp>
+
+namespace Gigamonkey::Bitcoin { 
+    
+    // Recognizes standard output scripts by their length and leading 
+    // op codes so that each script needs only one targeted check. 
+    struct script_classifier {
+        enum type : byte {
+            unknown, 
+            pay_to_address, 
+            pay_to_pubkey, 
+            op_return_data,  // OP_RETURN followed by pushes, with or without OP_FALSE before it. 
+            multisig,        // bare multisig. 
+            boost            // Boost output script. 
+        };
+        
+        // The fields are views into the script that was classified. 
+        struct classification {
+            type Type;
+            
+            // the hash of a pay to address script or the miner 
+            // address of a Boost contract script. 
+            bytes_view Hash160;
+            
+            // the pubkey of a pay to pubkey script. 
+            bytes_view Pubkey;
+            
+            // the data pushed after OP_RETURN or the pubkeys of a multisig 
+            // script, which can be read with instructions{Pushes}. 
+            bytes_view Pushes;
+            
+            // the number of signatures required by a multisig script. 
+            byte Required;
+            
+            classification() : Type{unknown}, Hash160{}, Pubkey{}, Pushes{}, Required{0} {}
+        };
+        
+        static classification classify(bytes_view);
+        
+        // classify every output of a transaction. The 
+        // vector is resized, so it can be reused. 
+        static void classify(const transaction_view&, std::vector<classification>&);
+    };
+    
+}
+
+#endif
@@ -7,71 +7,145 @@
 #include <gigamonkey/script/script.hpp>
 #include <script/script_flags.h>
 #include <policy/policy.h>
+#include <array>
 
-namespace Gigamonkey::Bitcoin { 
+namespace Gigamonkey::Bitcoin {
     
+    // A script machine which runs a compiled script in place. The stacks
+    // are kept by the interpreter between steps rather than being copied
+    // in and out for every instruction.
     struct machine {
         
+        // A stack element which keeps small values inline.
+        struct element {
+            constexpr static size_t Inline = 40;
+            
+            element() : Size{0}, Small{}, Large{} {}
+            explicit element(bytes_view b) : Size{b.size()}, Small{}, Large{} {
+                if (Size <= Inline) std::copy(b.begin(), b.end(), Small.begin());
+                else Large = bytes{b};
+            }
+            
+            size_t size() const {
+                return Size;
+            }
+            
+            const byte* data() const {
+                return Size <= Inline ? Small.data() : Large.data();
+            }
+            
+            operator bytes_view() const {
+                return bytes_view{data(), Size};
+            }
+            
+            bool operator==(const element& e) const {
+                return bytes_view(*this) == bytes_view(e);
+            }
+            
+            bool operator!=(const element& e) const {
+                return !operator==(e);
+            }
+        
+        private:
+            size_t Size;
+            std::array<byte, Inline> Small;
+            bytes Large;
+        };
+        
+        // A copy of the state of the machine which can be restored later.
+        // The stacks are listed from bottom to top.
         struct state {
             bool Halt;
             bool Success;
             ScriptError Error;
             
             uint32 Flags;
-        
-            list<bytes> Stack;
-            list<bytes> AltStack;
             
-            list<bool> Exec;
-            list<bool> Else;
+            std::vector<element> Stack;
+            std::vector<element> AltStack;
+            
+            std::vector<bool> Exec;
+            std::vector<bool> Else;
             
             long Counter;
             
-            state(uint32 flags) : Halt{false}, Success{false}, Error{SCRIPT_ERR_OK}, Flags{flags}, Stack{}, AltStack{}, Exec{}, Else{}, Counter{0} {}
-                
-            state step(const BaseSignatureChecker&, instruction) const;
-        
-            state run(const BaseSignatureChecker& x, program p) const {
-                state m = *this;
-                while (m.Error == SCRIPT_ERR_OK && p.size() > 0) {
-                    m = m.step(x, p.first());
-                    p = p.rest();
-                }
-                
-                return m;
-            }
+            // position of the next instruction in the script.
+            size_t Position;
+            
+            state(uint32 flags) : Halt{false}, Success{false}, Error{SCRIPT_ERR_OK}, Flags{flags},
+                Stack{}, AltStack{}, Exec{}, Else{}, Counter{0}, Position{0} {}
         };
         
-        program Program;
+        bytes Script;
         
-        state State;
         transaction Transaction;
         uint32 Index;
-    
+        
         machine(program p, uint32 flags = StandardScriptVerifyFlags(true, true), uint32 index = 0, satoshi value = 0, transaction tx = {});
         
+        machine(const machine&) = delete;
+        machine& operator=(const machine&) = delete;
+        
         bool halt() const {
-            return State.Halt || State.Error || Program.empty();
+            return Halt || Error || Position == Script.size();
         }
         
-        void step() {
-            if (halt()) return;
-            State = State.step(*SignatureChecker, Program.first());
-            Program = Program.rest();
-        };
+        bool success() const {
+            return Success;
+        }
         
-        ~machine() {
-            delete SignatureChecker;
-            delete Tx;
+        ScriptError error() const {
+            return Error;
+        }
+        
+        // position of the next instruction in the script.
+        size_t position() const {
+            return Position;
+        }
+        
+        // run one instruction.
+        void step() {
+            step(1);
         }
         
+        // run up to n instructions in one call to the interpreter.
+        // Signatures are checked against the part of the script that
+        // was given to the interpreter, so use run() to check them
+        // against the whole script.
+        void step(uint32 n);
+        
+        // run until the machine halts.
+        void run();
+        
+        state snapshot() const;
+        void restore(const state&);
+        
+        ~machine();
+    
     private:
+        struct stacks;
+        
+        bool Halt;
+        bool Success;
+        ScriptError Error;
+        uint32 Flags;
+        
+        stacks* Stacks;
+        std::vector<bool> Exec;
+        std::vector<bool> Else;
+        long Counter;
+        size_t Position;
+        
         BaseSignatureChecker* SignatureChecker;
         CTransaction* Tx;
+        
+        void eval(size_t end);
     };
     
     std::ostream& operator<<(std::ostream&, const machine&);
     
+    std::ostream& operator<<(std::ostream&, const machine::element&);
+
 }
 
 #endif
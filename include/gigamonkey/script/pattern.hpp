@@ -12,6 +12,7 @@ namespace Gigamonkey::Bitcoin {
     struct optional;
     struct alternatives;
     struct repeated;
+    struct compiled_pattern;
     
     // for matching and scraping values.
     struct pattern {
@@ -45,6 +46,9 @@ namespace Gigamonkey::Bitcoin {
             return Pattern->scan(p);
         }
         
+        // write this pattern into a compiled_pattern. 
+        virtual void compile(compiled_pattern&) const;
+        
         virtual ~pattern() {}
         
         struct sequence;
@@ -59,6 +63,7 @@ namespace Gigamonkey::Bitcoin {
     struct any final : pattern {
         any() {}
         virtual bytes_view scan(bytes_view p) const final override;
+        virtual void compile(compiled_pattern&) const final override;
     };
     
     // A pattern that represents a single instruction. 
@@ -67,14 +72,16 @@ namespace Gigamonkey::Bitcoin {
         atom(instruction i) : Instruction{i} {}
         
         virtual bytes_view scan(bytes_view p) const final override;
+        virtual void compile(compiled_pattern&) const final override;
     };
     
     // A pattern that represents a single instruction. 
     struct pattern::string final : pattern {
         bytes Program;
-        string(program p) : Program{compile(p)} {}
+        string(program p) : Program{Bitcoin::compile(p)} {}
         
         virtual bytes_view scan(bytes_view p) const final override;
+        virtual void compile(compiled_pattern&) const final override;
     };
     
     // A pattern that represents a push instruction 
@@ -83,7 +90,7 @@ namespace Gigamonkey::Bitcoin {
     class push final : public pattern {
         enum type : byte {any, value, data, read};
         type Type;
-        Z Value;
+        int64 Value;
         bytes Data;
         bytes& Read;
         
@@ -97,9 +104,10 @@ namespace Gigamonkey::Bitcoin {
         // match any push data and save the result.
         push(bytes& r) : Type{read}, Value{0}, Data{}, Read{r} {}
         
-        bool match(const instruction& i) const;
+        bool match(const instruction_view& i) const;
         
         virtual bytes_view scan(bytes_view p) const final override;
+        virtual void compile(compiled_pattern&) const final override;
         
         //operator instruction() const;
     };
@@ -116,9 +124,10 @@ namespace Gigamonkey::Bitcoin {
         // match any push data and save the result.
         push_size(size_t s, bytes& r) : Reader(true), Size(s), Data(), Read(r) {}
         
-        bool match(const instruction& i) const;
+        bool match(const instruction_view& i) const;
         
         virtual bytes_view scan(bytes_view p) const final override;
+        virtual void compile(compiled_pattern&) const final override;
     };
     
     enum repeated_directive : byte {
@@ -147,6 +156,7 @@ namespace Gigamonkey::Bitcoin {
         repeated(alternatives, uint32, uint32);
         
         virtual bytes_view scan(bytes_view p) const final override;
+        virtual void compile(compiled_pattern&) const final override;
     };
     
     struct optional final : pattern {
@@ -160,6 +170,7 @@ namespace Gigamonkey::Bitcoin {
         optional(alternatives);
         
         virtual bytes_view scan(bytes_view p) const final override;
+        virtual void compile(compiled_pattern&) const final override;
     };
     
     inline pattern::pattern(op o) : pattern{instruction{o}} {}
@@ -175,6 +186,7 @@ namespace Gigamonkey::Bitcoin {
         sequence(P... p) : Patterns(make(p...)) {}
         
         virtual bytes_view scan(bytes_view p) const override;
+        virtual void compile(compiled_pattern&) const override;
         
     private:
         
@@ -185,6 +197,8 @@ namespace Gigamonkey::Bitcoin {
         static ptr<pattern> construct(push_size p);
         static ptr<pattern> construct(alternatives p);
         static ptr<pattern> construct(optional p);
+        static ptr<pattern> construct(repeated p);
+        static ptr<pattern> construct(any p);
         static ptr<pattern> construct(pattern p);
         
         template <typename X> 
@@ -200,6 +214,91 @@ namespace Gigamonkey::Bitcoin {
         alternatives(P... p) : sequence{p...} {}
         
         virtual bytes_view scan(bytes_view) const final override;
+        virtual void compile(compiled_pattern&) const final override;
+    };
+    
+    // A pattern compiled into a flat table of steps. Matching does not 
+    // throw or allocate and captures are written as views into the script. 
+    // Alternatives, optional and repeated patterns are matched as in 
+    // pattern::scan: greedily and without backtracking into a branch once 
+    // it has succeeded. 
+    struct compiled_pattern {
+        // limits on the nesting of optional, repeated, and alternatives
+        // patterns and on the number of captures. A pattern that exceeds 
+        // them does not compile and matches nothing. 
+        constexpr static uint32 MaxDepth = 32;
+        constexpr static uint32 MaxCaptures = 16;
+        
+        struct step {
+            enum code : byte {
+                end,             // the pattern has matched if the whole script has been read. 
+                instruction,     // match Op with the constant data at Offset. 
+                string,          // match the constant bytes at Offset. 
+                any,             // match any instruction. 
+                push,            // match any push. 
+                push_value,      // match a push of Value. 
+                push_data,       // match a push of the constant data at Offset. 
+                push_size,       // match a push of Size bytes. 
+                choice,          // save a backtrack point which resumes at Offset. 
+                commit,          // drop the last backtrack point and go to Offset.
+                partial_commit   // update the last backtrack point and go to Offset. 
+            };
+            
+            code Code;
+            op Op;
+            int16 Capture;   // the capture slot for push and push_size, or -1. 
+            uint32 Offset;   // position of constant data, or a jump target. 
+            uint32 Size;     // size of constant data or of a push.
+            int64 Value;
+        };
+        
+        explicit compiled_pattern(const pattern&);
+        
+        bool valid() const {
+            return Valid;
+        }
+        
+        // the number of capture slots that match must be given. 
+        uint32 captures() const {
+            return Targets.size();
+        }
+        
+        // captures must point to at least captures() views. A slot which 
+        // was not captured is left as a null view. 
+        bool match(bytes_view script, bytes_view* captures) const;
+        
+        // match and copy the captures into the variables given to the 
+        // pattern that this was compiled from, like pattern::match. 
+        bool match(bytes_view script) const;
+        
+        // used by patterns to compile themselves. 
+        uint32 next() const {
+            return Steps.size();
+        }
+        
+        void add(step);
+        void add(step::code, op = OP_INVALIDOPCODE, uint32 offset = 0, uint32 size = 0);
+        uint32 constant(bytes_view);
+        int16 capture(bytes&);
+        
+        // set the jump target of a choice or commit step.
+        void target(uint32 step, uint32 target);
+        
+        // optional, repeated and alternatives patterns open a backtrack point. 
+        void open();
+        void close();
+        
+    private:
+        std::vector<step> Steps;
+        bytes Constants;
+        std::vector<bytes*> Targets;
+        uint32 Depth;
+        uint32 MaxOpen;
+        bool Valid;
+        
+        bytes_view constant(const step& x) const {
+            return bytes_view{Constants.data() + x.Offset, x.Size};
+        }
     };
     
     // A pattern that matches a pubkey and grabs the value of that pubkey.
@@ -247,9 +346,11 @@ namespace Gigamonkey::Bitcoin {
         }
         
         pay_to_pubkey(bytes_view script) : Pubkey{} {
-            pubkey p;
-            if (!pattern(p.Value).match(script)) return;
-            Pubkey = p;
+            static bytes Unused{};
+            static compiled_pattern Pattern{pattern(Unused)};
+            bytes_view captured[2];
+            if (!Pattern.match(script, captured)) return;
+            Pubkey = pubkey{captured[0].data() != nullptr ? captured[0] : captured[1]};
         }
         
         static bytes redeem(const signature& s) {
@@ -277,9 +378,11 @@ namespace Gigamonkey::Bitcoin {
         }
         
         pay_to_address(bytes_view script) : Address{} {
-            bytes addr{20};
-            if (!pattern(addr).match(script)) return;
-            std::copy(addr.begin(), addr.end(), Address.Value.begin());
+            static bytes Unused{};
+            static compiled_pattern Pattern{pattern(Unused)};
+            bytes_view address;
+            if (!Pattern.match(script, &address)) return;
+            std::copy(address.begin(), address.end(), Address.Value.begin());
         }
         
         static bytes redeem(const signature& s, const pubkey& p) {
@@ -354,6 +457,14 @@ namespace Gigamonkey::Bitcoin {
         return std::make_shared<optional>(p);
     }
     
+    inline ptr<pattern> pattern::sequence::construct(repeated p) {
+        return std::make_shared<repeated>(p);
+    }
+    
+    inline ptr<pattern> pattern::sequence::construct(any p) {
+        return std::make_shared<any>(p);
+    }
+    
     inline ptr<pattern> pattern::sequence::construct(pattern p) {
         return std::make_shared<pattern>(p);
     }
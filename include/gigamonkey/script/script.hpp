@@ -12,6 +12,8 @@
 
 #include <boost/endian/conversion.hpp>
 
+#include <iterator>
+
 #include <gigamonkey/signature.hpp>
 #include <gigamonkey/address.hpp>
 
@@ -150,15 +152,15 @@ namespace Gigamonkey::Bitcoin {
         
         instruction(bytes_view data) : Op{[](size_t size)->op{
             if (size <= OP_PUSHSIZE75) return static_cast<op>(size);
-            if (size <= 0xffff) return OP_PUSHDATA1;
-            if (size <= 0xffffffff) return OP_PUSHDATA2;
+            if (size <= 0xff) return OP_PUSHDATA1;
+            if (size <= 0xffff) return OP_PUSHDATA2;
             return OP_PUSHDATA4;
         }(data.size())}, Data{data} {} 
         
         bytes data() const {
             if (is_push_data(Op) || Op == OP_RETURN) return Data;
             if (!is_push(Op)) return {};
-            if (Op == OP_1NEGATE) return {OP_1NEGATE};
+            if (Op == OP_1NEGATE) return bytes{static_cast<byte>(0x81)};
             return bytes{static_cast<byte>(Op - 0x50)};
         }
         
@@ -167,9 +169,9 @@ namespace Gigamonkey::Bitcoin {
             if (Op == OP_RETURN) return true;
             size_t size = Data.size();
             return (!is_push_data(Op) && size == 0) || (Op <= OP_PUSHSIZE75 && Op == size) 
-                || (Op == OP_PUSHDATA1 && size <= 0xffff) 
-                || (Op == OP_PUSHDATA2 && size <= 0xffffffff) 
-                || (Op == OP_PUSHDATA4 && size <= 0xffffffffffffffff);
+                || (Op == OP_PUSHDATA1 && size <= 0xff) 
+                || (Op == OP_PUSHDATA2 && size <= 0xffff) 
+                || (Op == OP_PUSHDATA4 && size <= 0xffffffff);
         }
         
         uint32 length() const {
@@ -200,9 +202,10 @@ namespace Gigamonkey::Bitcoin {
         }
         
         bytes_writer write(bytes_writer w) const {
-            return is_push_data(Op) ? 
-                write_push_data(w, Op, Data.size()) << Data : 
-                w << static_cast<byte>(Op);
+            if (is_push_data(Op)) return write_push_data(w, Op, Data.size()) << Data;
+            // data after OP_RETURN is written as it is, in agreement with length(). 
+            if (Op == OP_RETURN && Data.size() != 0) return w << static_cast<byte>(Op) << Data;
+            return w << static_cast<byte>(Op);
         }
         
         static instruction op_code(op o) {
@@ -220,8 +223,153 @@ namespace Gigamonkey::Bitcoin {
             if (Push <= OP_PUSHSIZE75) return w << static_cast<byte>(Push);
             if (Push == OP_PUSHDATA1) return w << static_cast<byte>(OP_PUSHDATA1) << static_cast<byte>(size); 
             if (Push == OP_PUSHDATA2) return w << static_cast<byte>(OP_PUSHDATA2) << static_cast<uint16_little>(size); 
-            return w << static_cast<byte>(OP_PUSHDATA2) << static_cast<uint32_little>(size);
+            return w << static_cast<byte>(OP_PUSHDATA4) << static_cast<uint32_little>(size);
+        }
+    };
+    
+    // A view of an instruction inside of a compiled script.
+    // Push data is not copied out of the script.
+    struct instruction_view {
+        op Op;
+        bytes_view Data;
+        
+        instruction_view() : Op{OP_INVALIDOPCODE}, Data{} {}
+        instruction_view(op p) : Op{p}, Data{} {}
+        instruction_view(op p, bytes_view d) : Op{p}, Data{d} {}
+        
+        // the data that this instruction pushes to the stack, including
+        // the small numbers which are pushed by an op code alone.
+        bytes_view data() const;
+        
+        // read the data pushed by this instruction as a script number. 
+        // false if this is not a push or if the number is longer than 8 bytes. 
+        bool number(int64&) const;
+        
+        bool valid() const {
+            return Op != OP_INVALIDOPCODE;
+        }
+        
+        // the size of the instruction in the script, or zero if it is invalid.
+        uint32 length() const {
+            if (!is_push_data(Op)) return valid() ? 1 : 0;
+            uint32 size = Data.size();
+            if (Op <= OP_PUSHSIZE75) return size + 1;
+            if (Op == OP_PUSHDATA1) return size + 2;
+            if (Op == OP_PUSHDATA2) return size + 3;
+            return size + 5;
+        }
+        
+        bool operator==(const instruction_view& i) const {
+            return Op == i.Op && Data == i.Data;
+        }
+        
+        bool operator!=(const instruction_view& i) const {
+            return !operator==(i);
+        }
+        
+        bool operator==(const instruction& i) const {
+            return Op == i.Op && Data == bytes_view(i.Data);
+        }
+        
+        bool operator!=(const instruction& i) const {
+            return !operator==(i);
+        }
+        
+        explicit operator instruction() const {
+            return instruction{Op, bytes(Data)};
+        }
+        
+        // read the first instruction of a script. If the script
+        // is empty or ends in the middle of the instruction,
+        // the result is invalid.
+        static instruction_view read(bytes_view);
+    };
+    
+    // The instructions of a compiled script, which can be iterated over
+    // without copying. If an invalid instruction is encountered, it is
+    // returned once and then iteration stops.
+    struct instructions {
+        bytes_view Script;
+        
+        instructions(bytes_view b) : Script{b} {}
+        
+        struct iterator {
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = instruction_view;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const instruction_view*;
+            using reference = const instruction_view&;
+            
+            iterator() : Position{nullptr}, Next{nullptr}, End{nullptr}, Instruction{} {}
+            
+            const instruction_view& operator*() const {
+                return Instruction;
+            }
+            
+            const instruction_view* operator->() const {
+                return &Instruction;
+            }
+            
+            iterator& operator++() {
+                Position = Next;
+                read();
+                return *this;
+            }
+            
+            iterator operator++(int) {
+                iterator i = *this;
+                ++(*this);
+                return i;
+            }
+            
+            bool operator==(const iterator& i) const {
+                return Position == i.Position;
+            }
+            
+            bool operator!=(const iterator& i) const {
+                return Position != i.Position;
+            }
+            
+            // the part of the script beginning with the current instruction.
+            bytes_view remaining() const {
+                return bytes_view{Position, static_cast<size_t>(End - Position)};
+            }
+        
+        private:
+            const byte* Position;
+            const byte* Next;
+            const byte* End;
+            instruction_view Instruction;
+            
+            iterator(const byte* p, const byte* e) : Position{p}, Next{p}, End{e}, Instruction{} {
+                read();
+            }
+            
+            void read() {
+                if (Position == End) {
+                    Instruction = {};
+                    return;
+                }
+                
+                Instruction = instruction_view::read(remaining());
+                Next = Instruction.valid() ? Position + Instruction.length() : End;
+            }
+            
+            friend struct instructions;
+        };
+        
+        iterator begin() const {
+            return iterator{Script.data(), Script.data() + Script.size()};
         }
+        
+        iterator end() const {
+            return iterator{Script.data() + Script.size(), Script.data() + Script.size()};
+        }
+        
+        // true if the script is not empty and every instruction up to
+        // the first OP_RETURN can be read. This is the same condition as
+        // decompile returning a non-empty program.
+        bool valid() const;
     };
     
     instruction push_value(int);
@@ -230,8 +378,14 @@ namespace Gigamonkey::Bitcoin {
     
     using program = list<instruction>;
     
+    // whether every instruction is valid and IF, NOTIF, ELSE 
+    // and ENDIF are balanced. 
     bool valid(program);
     
+    // the same as valid(decompile(script)) without making the program. 
+    // Like decompile, it stops at the first OP_RETURN, even inside an IF. 
+    bool valid_program(bytes_view);
+    
     bytes compile(program p); 
     
     bytes compile(instruction i); 
@@ -242,10 +396,7 @@ namespace Gigamonkey::Bitcoin {
         return o.length();
     }
     
-    size_t inline length(program p) {
-        if (p.empty()) return 0;
-        return length(p.first()) + length(p.rest());
-    }
+    size_t length(program p);
     
     instruction inline push_data(int32_little x) {
         return instruction{bytes_view{x.data(), 4}};
@@ -271,6 +422,8 @@ namespace Gigamonkey::Bitcoin {
         return {OP_FALSE, instruction::op_return(b)};
     }
     
+    // whether a program begins with OP_FALSE OP_RETURN, meaning
+    // that the output can never be redeemed. 
     bool provably_prunable(program p);
     
     std::ostream& operator<<(std::ostream&, instruction);
@@ -0,0 +1,72 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#ifndef GIGAMONKEY_SCRIPT_VALIDATION
+#define GIGAMONKEY_SCRIPT_VALIDATION
+
+#include <gigamonkey/ledger.hpp>
+#include <gigamonkey/parallel.hpp>
+#include <gigamonkey/script/cache.hpp>
+#include <policy/policy.h>
+
+namespace Gigamonkey::Bitcoin {
+    
+    // The results of evaluating input scripts. For many transactions, 
+    // the inputs of all of them are listed in order. 
+    struct script_validation {
+        std::vector<evaluated> Inputs;
+        
+        // total time taken, in seconds. 
+        double Seconds;
+        
+        bool valid() const {
+            for (const evaluated& e : Inputs) if (!e.valid() || !e.Return) return false;
+            return true;
+        }
+        
+        script_validation() : Inputs{}, Seconds{0} {}
+        
+        // a single failed input, for when the inputs cannot be evaluated at all. 
+        static script_validation failed() {
+            script_validation x{};
+            x.Inputs.push_back(evaluated{SCRIPT_ERR_UNKNOWN_ERROR});
+            return x;
+        }
+    };
+    
+    // A transaction together with the outputs spent by each of its inputs. 
+    struct spending {
+        bytes_view Transaction;
+        std::vector<transaction_view::output> Spent;
+    };
+    
+    // Evaluate the input scripts of all the transactions concurrently. Each 
+    // transaction is deserialized and its signature hash data is computed 
+    // once and shared among its inputs. Inputs found in the cache are not 
+    // run again and inputs which are found to be valid are added to it. 
+    script_validation validate_scripts(const std::vector<spending>&, 
+        work_stealing_pool& = work_stealing_pool::common(), uint32 flags = StandardScriptVerifyFlags(true, true), 
+        script_cache& = script_cache::common());
+    
+    script_validation inline validate_scripts(const spending& x, 
+        work_stealing_pool& pool = work_stealing_pool::common(), uint32 flags = StandardScriptVerifyFlags(true, true), 
+        script_cache& cache = script_cache::common()) {
+        return validate_scripts(std::vector<spending>{x}, pool, flags, cache);
+    }
+    
+    // the previous transactions are taken from the vertex. If the transaction 
+    // or any output it spends is missing, the result is failed(). 
+    script_validation validate_scripts(const ledger::vertex&, 
+        work_stealing_pool& = work_stealing_pool::common(), uint32 flags = StandardScriptVerifyFlags(true, true), 
+        script_cache& = script_cache::common());
+    
+    // Every transaction in the block but the coinbase, given the outputs spent 
+    // by each of them in order. If the number of transactions is wrong, the 
+    // result is failed(). 
+    script_validation validate_block_scripts(bytes_view block, const std::vector<std::vector<transaction_view::output>>& spent, 
+        work_stealing_pool& = work_stealing_pool::common(), uint32 flags = StandardScriptVerifyFlags(true, true), 
+        script_cache& = script_cache::common());
+    
+}
+
+#endif
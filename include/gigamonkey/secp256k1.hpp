@@ -48,6 +48,7 @@ namespace Gigamonkey::secp256k1 {
     
     class secret;
     class pubkey;
+    class signature_cache;
     
     class signature : public bytes {
         friend class secret;
@@ -95,6 +96,8 @@ namespace Gigamonkey::secp256k1 {
     };
     
     class pubkey {
+        friend class signature_cache;
+        
         static bool valid(bytes_view);
         static bool verify(bytes_view pubkey, const digest&, const signature&);
         static bytes compress(bytes_view);
@@ -125,6 +128,7 @@ namespace Gigamonkey::secp256k1 {
         
         bool operator!=(const pubkey& p) const;
         
+        // verified signatures are kept in signature_cache::common(). 
         bool verify(const digest& d, const signature& s) const;
         
         size_t size() const;
@@ -280,10 +284,6 @@ namespace Gigamonkey::secp256k1 {
         return Value != p.Value;
     }
     
-    inline bool pubkey::verify(const digest& d, const signature& s) const {
-        return verify(Value, d, s);
-    }
-    
     inline size_t pubkey::size() const {
         return Value.size();
     }
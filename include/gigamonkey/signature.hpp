@@ -68,14 +68,16 @@ namespace Gigamonkey::Bitcoin {
         
     };
     
-    digest256 signature_hash(const bytes_view tx, index i, sighash::directive d);
+    // the script code and the amount are those of the output 
+    // which is spent by input i, not those of output i. 
+    digest256 signature_hash(const bytes_view tx, index i, sighash::directive d, const output& spent);
     
-    inline signature sign(const bytes_view tx, index i, sighash::directive d, const secp256k1::secret& s) {
-        return signature{s.sign(signature_hash(tx, i, d)), d};
+    inline signature sign(const bytes_view tx, index i, sighash::directive d, const output& spent, const secp256k1::secret& s) {
+        return signature{s.sign(signature_hash(tx, i, d, spent)), d};
     }
     
-    inline bool verify(const signature& x, bytes_view tx, index i, sighash::directive d, const pubkey& p) {
-        return p.verify(signature_hash(tx, i, d), x.raw());
+    inline bool verify(const signature& x, bytes_view tx, index i, sighash::directive d, const output& spent, const pubkey& p) {
+        return p.verify(signature_hash(tx, i, d, spent), x.raw());
     }
     
     inline std::ostream& operator<<(std::ostream& o, const Gigamonkey::Bitcoin::signature& x) {
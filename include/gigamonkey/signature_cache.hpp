@@ -0,0 +1,95 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#ifndef GIGAMONKEY_SIGNATURE_CACHE
+#define GIGAMONKEY_SIGNATURE_CACHE
+
+#include <gigamonkey/secp256k1.hpp>
+#include <gigamonkey/parallel.hpp>
+#include <atomic>
+#include <mutex>
+
+namespace Gigamonkey::secp256k1 {
+    
+    // A cache of signatures which are known to be valid. An entry is a salted 
+    // hash of the pubkey, the digest and the signature. The memory used is 
+    // fixed when the cache is made. Each key belongs in a small bucket and 
+    // when its bucket is full a random entry in it is replaced. Buckets 
+    // are locked in stripes so that many threads can use the cache at once. 
+    class signature_cache {
+    public:
+        constexpr static size_t DefaultBytes = 32 << 20;
+        
+        // a cache of less than one bucket keeps nothing. 
+        explicit signature_cache(size_t bytes = DefaultBytes);
+        
+        signature_cache(const signature_cache&) = delete;
+        signature_cache& operator=(const signature_cache&) = delete;
+        
+        digest256 key(bytes_view pubkey, const digest&, bytes_view signature) const;
+        
+        // whether the key is in the cache. This is counted as a hit or a miss. 
+        bool contains(const digest256&);
+        
+        void insert(const digest256&);
+        
+        // check the cache before the signature is verified and 
+        // add the signature to the cache if it is valid. 
+        bool verify(bytes_view pubkey, const digest&, const signature&);
+        
+        struct verification {
+            bytes_view Pubkey;
+            digest Digest;
+            bytes_view Signature;
+        };
+        
+        // verify many signatures concurrently. True if all of them are valid. 
+        bool verify(const std::vector<verification>&, work_stealing_pool& = work_stealing_pool::common());
+        
+        void clear();
+        
+        // number of entries the cache can hold. 
+        size_t capacity() const {
+            return Slots.size();
+        }
+        
+        uint64 hits() const {
+            return Hits;
+        }
+        
+        uint64 misses() const {
+            return Misses;
+        }
+        
+        double hit_rate() const {
+            uint64 total = Hits + Misses;
+            return total == 0 ? 0 : double(Hits) / double(total);
+        }
+        
+        static signature_cache& common();
+        
+    private:
+        constexpr static uint32 Ways = 4;
+        constexpr static uint32 Stripes = 64;
+        
+        struct stripe {
+            std::mutex Mutex;
+            uint64 Random;
+        };
+        
+        uint256 Salt;
+        salted_hasher Hash;
+        
+        // empty slots are zero. 
+        std::vector<digest256> Slots;
+        stripe Stripe[Stripes];
+        
+        std::atomic<uint64> Hits;
+        std::atomic<uint64> Misses;
+        
+        size_t bucket(const digest256&) const;
+    };
+    
+}
+
+#endif
@@ -17,6 +17,10 @@ namespace Gigamonkey::Bitcoin {
     
     struct output_pattern {
         virtual change create_redeemable(ptr<keysource>&) const = 0;
+        
+        // the largest size of the output scripts that are made, 
+        // so that fees can be estimated without taking a key. 
+        virtual uint32 expected_size() const = 0;
     };
     
     struct redeem_pay_to_pubkey final : redeemable {
@@ -30,7 +34,7 @@ namespace Gigamonkey::Bitcoin {
         }
         
         uint32 expected_size() const override {
-            return signature::MaxSignatureSize + 1;
+            return estimate::PayToPubkeyRedeemSize;
         };
         
         uint32 sigops() const override {
@@ -50,7 +54,7 @@ namespace Gigamonkey::Bitcoin {
         }
         
         uint32 expected_size() const override {
-            return signature::MaxSignatureSize + Pubkey.size() + 2;
+            return estimate::MaxSignaturePushSize + Pubkey.size() + 1;
         };
         
         uint32 sigops() const override {
@@ -66,6 +70,10 @@ namespace Gigamonkey::Bitcoin {
             return change{pay_to_pubkey::script(s.to_public()),
                 std::make_shared<redeem_pay_to_pubkey>(s)};
         };
+        
+        uint32 expected_size() const override {
+            return estimate::pay_to_pubkey_script_size(false);
+        }
     };
     
     struct pay_to_address_pattern : output_pattern {
@@ -75,6 +83,10 @@ namespace Gigamonkey::Bitcoin {
             return change{pay_to_address::script(s.address().Digest), 
                 std::make_shared<redeem_pay_to_address>(s, s.to_public())};
         };
+        
+        uint32 expected_size() const override {
+            return estimate::PayToAddressScriptSize;
+        }
     };
     
 }
@@ -54,6 +54,8 @@ namespace Gigamonkey::Bitcoin {
         
     };
     
+    inline headers::header::header() : Hash{}, Header{}, Height{}, Cumulative{} {}
+    
     /*class headers::memory final : headers {
         struct entry : header {
             Merkle::map Tree;
@@ -59,6 +59,14 @@ namespace Gigamonkey::Bitcoin {
 
     std::ostream& operator<<(std::ostream& o, const transaction& p);
     
+    struct indexed_transaction;
+    
+    bool operator==(const indexed_transaction&, const indexed_transaction&);
+    bool operator!=(const indexed_transaction&, const indexed_transaction&);
+    
+    writer operator<<(writer w, const indexed_transaction& h);
+    reader operator>>(reader r, indexed_transaction& h);
+    
     struct header;
     
     bool operator==(const header& a, const header& b);
@@ -239,6 +247,150 @@ namespace Gigamonkey::Bitcoin {
         }
     };
     
+    // A transaction whose inputs and outputs are kept in vectors so that 
+    // they can be reached by index in constant time. It is written the 
+    // same way as transaction. 
+    struct indexed_transaction {
+        int32_little Version;
+        std::vector<Bitcoin::input> Inputs;
+        std::vector<Bitcoin::output> Outputs;
+        uint32_little Locktime;
+        
+        indexed_transaction(int32_little v, std::vector<Bitcoin::input> i, std::vector<Bitcoin::output> o, uint32_little t) : 
+            Version{v}, Inputs{std::move(i)}, Outputs{std::move(o)}, Locktime{t} {}
+        
+        indexed_transaction() : Version{}, Inputs{}, Outputs{}, Locktime{} {}
+        
+        explicit indexed_transaction(const transaction&);
+        explicit indexed_transaction(bytes_view b) : indexed_transaction{read(b)} {}
+        
+        explicit operator transaction() const;
+        
+        bool valid() const;
+        
+        static indexed_transaction read(bytes_view);
+        bytes write() const;
+        
+        txid id() const {
+            return hash256(write());
+        }
+        
+        size_t serialized_size() const;
+        
+        satoshi sent() const {
+            satoshi x{0};
+            for (const Bitcoin::output& o : Outputs) x = x + o.Value;
+            return x;
+        }
+    };
+    
+    // A serialized transaction read without copying its scripts. 
+    struct transaction_view {
+        struct input {
+            bytes_view Outpoint; 
+            bytes_view Script;
+            uint32_little Sequence;
+        };
+        
+        struct output {
+            satoshi Value{0}; 
+            bytes_view Script;
+        };
+        
+        bytes_view Transaction;
+        int32_little Version;
+        std::vector<input> Inputs;
+        std::vector<output> Outputs;
+        uint32_little Locktime;
+        
+        // the view is invalid if the transaction cannot be read 
+        // or if there is anything left over after it. 
+        explicit transaction_view(bytes_view);
+        
+        bool valid() const {
+            return Valid;
+        }
+        
+        txid id() const {
+            return hash256(Transaction);
+        }
+        
+        // Find one input or output by skipping over those before it, without 
+        // reading the rest of the transaction. False if there is no such entry 
+        // or if the transaction cannot be read up to it. 
+        static bool find_input(bytes_view tx, uint32 index, input&);
+        static bool find_output(bytes_view tx, uint32 index, output&);
+        
+    private:
+        bool Valid;
+        bool read();
+    };
+    
+    // Writes a transaction into a single buffer as inputs and outputs are added. 
+    // The buffer is a valid transaction at every step. Space can be reserved 
+    // for an input script that is not known yet, such as one with a signature. 
+    // The space is filled with zeros, which do not change the signature hash 
+    // of any other input, so the transaction can be signed with incomplete() 
+    // and the scripts written in afterwards with set_script. Reserved space 
+    // which is not used is removed by complete(). 
+    class transaction_builder {
+    public:
+        explicit transaction_builder(int32_little version = 1, uint32_little locktime = 0);
+        
+        void reserve(size_t size) {
+            Transaction.reserve(size);
+        }
+        
+        // the index of the new input. 
+        uint32 add_input(const outpoint&, bytes_view script, uint32_little sequence);
+        uint32 add_input(const outpoint&, size_t reserved, uint32_little sequence);
+        
+        // the index of the new output. 
+        uint32 add_output(satoshi, bytes_view script);
+        
+        size_t inputs() const {
+            return Slots.size();
+        }
+        
+        size_t outputs() const {
+            return Outputs;
+        }
+        
+        // the transaction so far, with reserved scripts as they are. 
+        bytes_view incomplete() const {
+            return Transaction;
+        }
+        
+        // write the script of an input for which space was reserved. 
+        // False if there is no space or not enough. 
+        bool set_script(uint32 input, bytes_view script);
+        
+        // the finished transaction. The builder is left empty. 
+        bytes complete();
+        
+    private:
+        // the script of an input. 
+        struct slot {
+            // position of the script size. 
+            size_t Offset;
+            uint32 Reserved;
+            uint32 Size;
+            bool Open;
+        };
+        
+        bytes Transaction;
+        std::vector<slot> Slots;
+        size_t Outputs;
+        
+        // where the outputs begin, including their number. 
+        size_t InputsEnd;
+        
+        uint32 add_input(const outpoint&, bytes_view script, size_t reserved, uint32_little sequence);
+        
+        // write a new count and return how much the buffer moved. 
+        int64 count(size_t offset, uint64 previous, uint64 next);
+    };
+    
     txid inline id(const transaction& b) {
         return hash256(b.write());
     }
@@ -385,6 +537,22 @@ namespace Gigamonkey::Bitcoin {
         return w << t.Version << t.Inputs << t.Outputs << t.Locktime;
     }
 
+    reader inline operator>>(reader r, indexed_transaction& t) {
+        return r >> t.Version >> t.Inputs >> t.Outputs >> t.Locktime;
+    }
+    
+    writer inline operator<<(writer w, const indexed_transaction& t) {
+        return w << t.Version << t.Inputs << t.Outputs << t.Locktime;
+    }
+    
+    bool inline operator==(const indexed_transaction& a, const indexed_transaction& b) {
+        return a.Version == b.Version && a.Inputs == b.Inputs && a.Outputs == b.Outputs && a.Locktime == b.Locktime;
+    }
+    
+    bool inline operator!=(const indexed_transaction& a, const indexed_transaction& b) {
+        return !(a == b);
+    }
+    
     reader inline operator>>(reader r, block& b) {
         return r >> b.Header >> b.Transactions;
     }
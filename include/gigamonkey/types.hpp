@@ -149,6 +149,18 @@ namespace Gigamonkey::Bitcoin {
             }
             return r;
         }
+        
+        template <typename X> 
+        reader operator>>(std::vector<X>& v) {
+            v.clear();
+            uint64 size;
+            auto r = reader{read_var_int(Reader, size)};
+            for (uint64 i = 0; i < size; i++) {
+                v.emplace_back();
+                r = r >> v.back();
+            }
+            return r;
+        }
     };
     
     struct writer {
@@ -189,6 +201,13 @@ namespace Gigamonkey::Bitcoin {
                     return w << x;
                 }, writer{write_var_int(Writer, data::size(l))}, l);
         }
+        
+        template <typename X> 
+        writer operator<<(const std::vector<X>& v) {
+            writer w{write_var_int(Writer, v.size())};
+            for (const X& x : v) w = w << x;
+            return w;
+        }
     };
     
 }
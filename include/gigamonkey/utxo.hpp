@@ -0,0 +1,96 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#ifndef GIGAMONKEY_UTXO
+#define GIGAMONKEY_UTXO
+
+#include "spendable.hpp"
+#include <map>
+
+namespace Gigamonkey::Bitcoin {
+    
+    // A set of spendable outputs indexed by outpoint, by value and by the 
+    // order in which they were added. Adding and removing an output is 
+    // O(log n) and so is finding the oldest, the largest, a random output, 
+    // or the smallest output worth at least a given amount. 
+    class utxo_set {
+    public:
+        utxo_set() : ByOutpoint{}, ByOrder{}, ByValue{}, Positions{}, Next{0}, Value{0} {}
+        
+        utxo_set(const utxo_set&);
+        utxo_set(utxo_set&&) = default;
+        
+        utxo_set& operator=(const utxo_set&);
+        utxo_set& operator=(utxo_set&&) = default;
+        
+        size_t size() const {
+            return ByOutpoint.size();
+        }
+        
+        bool empty() const {
+            return ByOutpoint.empty();
+        }
+        
+        // total value of all outputs. 
+        satoshi value() const {
+            return Value;
+        }
+        
+        // false if the outpoint is already in the set. 
+        bool insert(const spendable&);
+        
+        // false if the outpoint is not in the set. 
+        bool remove(const outpoint&);
+        
+        bool contains(const outpoint& o) const {
+            return ByOutpoint.find(o) != ByOutpoint.end();
+        }
+        
+        // nullptr if the outpoint is not in the set. 
+        const spendable* find(const outpoint&) const;
+        
+        // these return nullptr if the set is empty. 
+        const spendable* oldest() const;
+        const spendable* largest() const;
+        const spendable* smallest() const;
+        
+        // the smallest output worth at least v. 
+        const spendable* at_least(satoshi v) const;
+        
+        // an output chosen by a random number r. Every output is equally 
+        // likely if r is uniformly distributed. 
+        const spendable* random(uint64 r) const;
+        
+        // all outputs from largest to smallest. 
+        template <typename F> void by_value(F f) const {
+            for (auto i = ByValue.rbegin(); i != ByValue.rend(); i++) f(i->second->second.Spendable);
+        }
+        
+        // all outputs in the order they were added. 
+        list<spendable> entries() const;
+        
+    private:
+        struct entry {
+            spendable Spendable;
+            uint64 Order;
+            
+            // position in Positions. 
+            size_t Position;
+        };
+        
+        using iterator = std::map<outpoint, entry>::iterator;
+        
+        std::map<outpoint, entry> ByOutpoint;
+        std::map<uint64, iterator> ByOrder;
+        std::map<std::pair<int64, uint64>, iterator> ByValue;
+        
+        // for choosing an output at random. 
+        std::vector<iterator> Positions;
+        
+        uint64 Next;
+        satoshi Value;
+    };
+    
+}
+
+#endif
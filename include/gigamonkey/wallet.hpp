@@ -4,7 +4,7 @@
 #ifndef GIGAMONKEY_WALLET
 #define GIGAMONKEY_WALLET
 
-#include "spendable.hpp"
+#include "utxo.hpp"
 
 namespace Gigamonkey::Bitcoin {
     
@@ -15,6 +15,10 @@ namespace Gigamonkey::Bitcoin {
         satoshi calculate(size_t size, uint32 sigops) const {
             return FeePerByte * size + FeePerSigop * sigops;
         }
+        
+        satoshi calculate(const estimate& e) const {
+            return calculate(e.size(), e.Sigops);
+        }
         bool sufficient(const ledger::vertex& t) const {
             return t.fee() >= calculate(t->size(), t.sigops());
         }
@@ -22,29 +26,64 @@ namespace Gigamonkey::Bitcoin {
     };
     
     struct funds {
-        list<spendable> Entries;
+        utxo_set Entries;
         satoshi Value;
         bool Valid;
         
         funds() : Entries{}, Value{0}, Valid{true} {}
         funds(list<spendable> e) : funds{funds{}.insert(e)} {}
         
-        funds insert(spendable s) const {
-            return {Entries << s, Value + s.Value, Valid && s.valid()};
+        funds insert(spendable s) const & {
+            funds f{*this};
+            f.add(s);
+            return f;
         }
         
-        funds insert(list<spendable> s) const {
-            if (s.empty()) return {};
-            return insert(s.first()).insert(s.rest());
+        funds insert(list<spendable> s) const & {
+            funds f{*this};
+            for (const spendable& x : s) f.add(x);
+            return f;
+        }
+        
+        // these take the funds they are called on rather than copy them. 
+        funds insert(spendable s) && {
+            add(s);
+            return std::move(*this);
+        }
+        
+        funds insert(list<spendable> s) && {
+            for (const spendable& x : s) add(x);
+            return std::move(*this);
+        }
+        
+        // add and remove outputs in place. 
+        void add(const spendable& s) {
+            if (!Entries.insert(s)) return;
+            Value = Entries.value();
+            Valid = Valid && s.valid();
+        }
+        
+        bool remove(const outpoint& o) {
+            if (!Entries.remove(o)) return false;
+            Value = Entries.value();
+            return true;
         }
         
         struct selected;
         
-        selected select_next() const;
-        selected select_random() const;
+        // these copy the funds to make the remainder. When 
+        // selecting many outputs, use the take functions instead. 
+        selected select_next() const &;
+        selected select_random() const &;
         
-    private:
-        funds(list<spendable> e, satoshi value, bool valid) : Entries{e}, Value{value}, Valid{valid} {}
+        // the remainder is made from the funds these are called on. 
+        selected select_next() &&;
+        selected select_random() &&;
+        
+        // remove an output and return it. The funds must not be empty. 
+        spendable take_next();
+        spendable take_random();
+        spendable take_largest();
     };
     
     struct funds::selected {
@@ -52,12 +91,22 @@ namespace Gigamonkey::Bitcoin {
         funds Remainder;
     };
     
-    inline funds::selected funds::select_next() const {
-        throw method::unimplemented{"funds::select_next"};
+    inline funds::selected funds::select_next() const & {
+        return funds{*this}.select_next();
+    }
+    
+    inline funds::selected funds::select_random() const & {
+        return funds{*this}.select_random();
+    }
+    
+    inline funds::selected funds::select_next() && {
+        spendable x = take_next();
+        return {x, std::move(*this)};
     }
     
-    inline funds::selected funds::select_random() const {
-        throw method::unimplemented{"funds::select_random"};
+    inline funds::selected funds::select_random() && {
+        spendable x = take_random();
+        return {x, std::move(*this)};
     }
     
     struct payment {
@@ -83,7 +132,8 @@ namespace Gigamonkey::Bitcoin {
     };
     
     struct wallet {
-        enum spend_policy {unset, all, fifo, random};
+        // best searches for inputs that need no change before it makes change. 
+        enum spend_policy {unset, all, fifo, random, best};
         
         funds Funds;
         spend_policy Policy;
@@ -108,17 +158,25 @@ namespace Gigamonkey::Bitcoin {
         spent spend(list<payment>) const;
     };
     
+    // The wallet only has the outputs that it spends and not the transactions 
+    // they came from, so they are given here in the order of the inputs. 
     struct wallet::spent {
-        ledger::vertex Vertex;
+        ledger::double_entry Transaction;
+        list<spendable> Spent;
+        satoshi Fee;
+        
+        // the funds that were not spent together with the change, 
+        // and the keys that were not used for change. 
         wallet Remainder;
         
         bool valid() const {
-            return Vertex.valid() && Remainder.valid();
+            return Transaction.valid() && Remainder.valid();
         }
         
     private:
-        spent() : Vertex{}, Remainder{} {}
-        spent(const ledger::vertex& v, const wallet& r) : Vertex{v}, Remainder{r} {}
+        spent() : Transaction{}, Spent{}, Fee{0}, Remainder{} {}
+        spent(const ledger::double_entry& t, list<spendable> s, satoshi f, const wallet& r) : 
+            Transaction{t}, Spent{s}, Fee{f}, Remainder{r} {}
         
         friend struct wallet;
     };
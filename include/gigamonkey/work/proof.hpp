@@ -288,7 +288,9 @@ namespace Gigamonkey::work {
     }
     
     digest256 inline proof::merkle_root() const {
-        return Puzzle.Candidate.Path.derive_root(Bitcoin::hash256(meta()));
+        // the same as hashing meta(), without writing it first. 
+        return Puzzle.Candidate.Path.derive_root((Bitcoin::hash256_writer{} << 
+            Puzzle.Header << Solution.ExtraNonce1 << Solution.Share.ExtraNonce2 << Puzzle.Body).finalize());
     }
     
     string inline proof::string() const {
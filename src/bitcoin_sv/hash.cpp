@@ -1,5 +1,6 @@
 #include <gigamonkey/hash.hpp>
 #include <hash.h>
+#include <crypto/sha512.h>
 
 #include "arith_uint256.h"
 
@@ -11,6 +12,12 @@ namespace Gigamonkey {
         return result;
     } 
     
+    digest512 sha512(bytes_view b) {
+        digest512 result;
+        CSHA512().Write(b.data(), b.size()).Finalize(result.Value.data());
+        return result;
+    }
+    
     digest160 ripemd160(bytes_view b) {
         digest160 result;
         CRIPEMD160().Write(b.data(), b.size()).Finalize(result.Value.data());
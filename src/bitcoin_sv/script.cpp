@@ -2,6 +2,7 @@
 // Distributed under the Open BSV software license, see the accompanying file LICENSE.
 
 #include <gigamonkey/script/machine.hpp>
+#include <gigamonkey/script/checker.hpp>
 #include "script/interpreter.h"
 #include "taskcancellation.h"
 #include "streams.h"
@@ -50,18 +51,49 @@ namespace Gigamonkey::Bitcoin {
             (const char*)(tx.data() + tx.size()), SER_NETWORK, PROTOCOL_VERSION};
         CTransaction ctx{deserialize, stream}; 
         
-        return evaluate_script(lock, unlock, TransactionSignatureChecker(&ctx, i, Amount(int64(output::value(transaction::output(tx, i))))));
+        return evaluate_script(lock, unlock, cached_signature_checker(&ctx, i, Amount(int64(output::value(transaction::output(tx, i))))));
+    }
+    
+    std::ostream& operator<<(std::ostream& o, const machine::element& e) {
+        return o << data::encoding::hex::write(bytes_view(e));
+    }
+    
+    template <typename X> 
+    std::ostream& write_vector(std::ostream& o, const std::vector<X>& v) {
+        o << "[";
+        for (size_t i = 0; i < v.size(); i++) {
+            if (i != 0) o << ", ";
+            o << v[i];
+        }
+        return o << "]";
     }
     
     std::ostream& operator<<(std::ostream& o, const machine& i) {
-        return o << "machine{\n\tProgram: " << i.Program << ",\n\tState: {Halt: " << (i.State.Halt ? "true" : "false") 
-            << ", Success: " << (i.State.Success ? "true" : "false") << ", Error: " 
-            << i.State.Error << ", Flags: " << i.State.Flags << ",\n\t\tStack: " << i.State.Stack << ",\n\t\tAltStack: " 
-            << i.State.AltStack << ", Exec: " << i.State.Exec << ", Else: " << i.State.Else << "}}";
+        machine::state x = i.snapshot();
+        o << "machine{\n\tScript: " << decompile(i.Script) << ",\n\tState: {Halt: " << (x.Halt ? "true" : "false") 
+            << ", Success: " << (x.Success ? "true" : "false") << ", Error: " 
+            << x.Error << ", Flags: " << x.Flags << ", Position: " << x.Position << ",\n\t\tStack: ";
+        write_vector(o, x.Stack) << ",\n\t\tAltStack: ";
+        write_vector(o, x.AltStack) << ", Exec: ";
+        write_vector(o, x.Exec) << ", Else: ";
+        return write_vector(o, x.Else) << "}}";
     }
     
+    // the interpreter's stacks, which persist between steps. 
+    struct machine::stacks {
+        LimitedStack Stack;
+        LimitedStack AltStack;
+        
+        stacks(uint32 flags) : 
+            Stack(GlobalConfig::GetConfig().GetMaxStackMemoryUsage(flags & SCRIPT_UTXO_AFTER_GENESIS, false)), 
+            AltStack{Stack.makeChildStack()} {}
+    };
+    
     machine::machine(program p, uint32 flags, uint32 index, satoshi value, transaction tx) : 
-        Program{p}, State{flags}, Transaction{tx}, Index{index}, SignatureChecker{nullptr}, Tx{nullptr} {
+        Script{compile(p)}, Transaction{tx}, Index{index}, 
+        Halt{false}, Success{false}, Error{SCRIPT_ERR_OK}, Flags{flags}, 
+        Stacks{new stacks{flags}}, Exec{}, Else{}, Counter{0}, Position{0}, 
+        SignatureChecker{nullptr}, Tx{nullptr} {
         
         if (!tx.valid()) {
             SignatureChecker = new DummySignatureChecker{};
@@ -73,79 +105,127 @@ namespace Gigamonkey::Bitcoin {
         CDataStream stream{(const char*)(tx_bytes.data()), 
         (const char*)(tx_bytes.data() + tx_bytes.size()), SER_NETWORK, PROTOCOL_VERSION};
         Tx = new CTransaction{deserialize, stream};
-        SignatureChecker = new TransactionSignatureChecker(Tx, index, Amount(int64(value)));
+        SignatureChecker = new cached_signature_checker(Tx, index, Amount(int64(value)));
         
     }
     
-    machine::state machine::state::step(const BaseSignatureChecker& x, instruction i) const {
-                
-        if (Error || Halt) return *this;
-        
-        const GlobalConfig& config = GlobalConfig::GetConfig();
-        bool consensus = false;
-        
-        bytes compiled = compile(i);
-        CScript z(compiled.begin(), compiled.end());
-        
-        LimitedStack stack(config.GetMaxStackMemoryUsage(Flags & SCRIPT_UTXO_AFTER_GENESIS, consensus));
-        LimitedStack altstack {stack.makeChildStack()};
-        
-        // TODO copy from stacks onto limited stack
-        for (const bytes& b : Stack.reverse()) stack.push_back(b);
-        for (const bytes& b : AltStack.reverse()) altstack.push_back(b);
-        
-        std::vector<bool> v_exec(Exec.size());
-        std::vector<bool> v_else(Else.size());
-        
-        auto f_exec = Exec;
-        for (int i = 0; i < v_exec.size(); i++) {
-            v_exec[i] = f_exec.first();
-            f_exec = f_exec.rest();
+    machine::~machine() {
+        delete Stacks;
+        delete SignatureChecker;
+        delete Tx;
+    }
+    
+    void machine::step(uint32 n) {
+        if (n == 0 || halt()) return;
+        
+        size_t end = Position;
+        for (const instruction_view& i : instructions{bytes_view{Script}.substr(Position)}) {
+            if (n-- == 0) break;
+            if (!i.valid()) {
+                Error = SCRIPT_ERR_BAD_OPCODE;
+                Halt = true;
+                return;
+            }
+            
+            end += i.length();
+            if (i.Op == OP_RETURN) {
+                end = Script.size();
+                break;
+            }
         }
         
-        auto f_else = Else;
-        for (int i = 0; i < v_else.size(); i++) {
-            v_else[i] = f_else.first();
-            f_else = f_else.rest();
+        eval(end);
+    }
+    
+    void machine::run() {
+        if (halt()) return;
+        if (!instructions{bytes_view{Script}.substr(Position)}.valid()) {
+            Error = SCRIPT_ERR_BAD_OPCODE;
+            Halt = true;
+            return;
         }
         
-        state m{Flags};
-        m.Counter = Counter;
+        eval(Script.size());
+    }
+    
+    // the same rule as CastToBool in the interpreter. 
+    bool cast_to_bool(bytes_view b) {
+        for (size_t i = 0; i < b.size(); i++) if (b[i] != 0) return i != b.size() - 1 || b[i] != 0x80;
+        return false;
+    }
+    
+    void machine::eval(size_t end) {
+        CScript z(Script.begin() + Position, Script.begin() + end);
         
         std::optional<bool> result = EvalScript(
-            config, consensus, 
+            GlobalConfig::GetConfig(), false, 
             task::CCancellationSource::Make()->GetToken(), 
-            stack, z, Flags, x, 
-            altstack, m.Counter,
-            v_exec, v_else, &m.Error);
+            Stacks->Stack, z, Flags, *SignatureChecker, 
+            Stacks->AltStack, Counter,
+            Exec, Else, &Error);
         
-        // copy stacks back 
-        while(!stack.empty()) {
-            auto elem = stack.back().GetElement();
-            m.Stack = m.Stack << bytes_view{elem.data(), elem.size()};
-            stack.pop_back();
-        }
+        Position = end;
         
-        while(!altstack.empty()) {
-            auto elem = altstack.back().GetElement();
-            m.AltStack = m.AltStack << bytes_view{elem.data(), elem.size()};
-            altstack.pop_back();
+        if (!result.has_value() || !result.value()) {
+            if (Error == SCRIPT_ERR_OK) Error = SCRIPT_ERR_UNKNOWN_ERROR;
+            Halt = true;
+            Success = false;
+            return;
         }
         
-        for (int i = 0; i < v_exec.size(); i++) m.Exec = m.Exec << v_exec[i];
-        for (int i = 0; i < v_else.size(); i++) m.Else = m.Else << v_else[i];
-        
-        if ((i.Op == OP_RETURN || 
-            i.Op == OP_VERIFY || 
-            i.Op == OP_EQUALVERIFY || 
-            i.Op == OP_NUMEQUALVERIFY || 
-            i.Op == OP_CHECKSIGVERIFY || 
-            i.Op == OP_CHECKMULTISIGVERIFY) && (!result.has_value() || !result.value())) {
-            m.Halt = true;
-            m.Success = false;
+        if (Position == Script.size()) {
+            Halt = true;
+            if (Stacks->Stack.empty()) return;
+            auto top = Stacks->Stack.back().GetElement();
+            Success = Exec.empty() && cast_to_bool(bytes_view{top.data(), top.size()});
+        }
+    }
+    
+    // LimitedStack can only be read from the top, so the 
+    // elements are popped off and then pushed back on. 
+    void copy_stack(LimitedStack& from, std::vector<machine::element>& to) {
+        std::vector<std::vector<uint8_t>> popped;
+        while (!from.empty()) {
+            popped.push_back(from.back().GetElement());
+            from.pop_back();
         }
         
-        return m;
+        to.clear();
+        to.reserve(popped.size());
+        for (auto i = popped.rbegin(); i != popped.rend(); i++) {
+            to.emplace_back(bytes_view{i->data(), i->size()});
+            from.push_back(*i);
+        }
+    }
+    
+    machine::state machine::snapshot() const {
+        state x{Flags};
+        x.Halt = Halt;
+        x.Success = Success;
+        x.Error = Error;
+        x.Exec = Exec;
+        x.Else = Else;
+        x.Counter = Counter;
+        x.Position = Position;
+        copy_stack(Stacks->Stack, x.Stack);
+        copy_stack(Stacks->AltStack, x.AltStack);
+        return x;
+    }
+    
+    void machine::restore(const state& x) {
+        Halt = x.Halt;
+        Success = x.Success;
+        Error = x.Error;
+        Flags = x.Flags;
+        Exec = x.Exec;
+        Else = x.Else;
+        Counter = x.Counter;
+        Position = x.Position;
+        
+        delete Stacks;
+        Stacks = new stacks{Flags};
+        for (const element& e : x.Stack) Stacks->Stack.push_back(std::vector<uint8_t>(e.data(), e.data() + e.size()));
+        for (const element& e : x.AltStack) Stacks->AltStack.push_back(std::vector<uint8_t>(e.data(), e.data() + e.size()));
     }
 
 }
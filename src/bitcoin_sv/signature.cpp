@@ -1,5 +1,6 @@
 
 #include <gigamonkey/signature.hpp>
+#include <gigamonkey/script/checker.hpp>
 #include <key.h>
 #include <pubkey.h>
 #include <script/interpreter.h>
@@ -7,21 +8,31 @@
 
 namespace Gigamonkey::Bitcoin {
     
-    digest256 signature_hash(const bytes_view tx, index i, sighash::directive d) {
+    digest256 signature_hash(const bytes_view tx, index i, sighash::directive d, const output& spent) {
         
         CDataStream stream{(const char*)(tx.data()), 
             (const char*)(tx.data() + tx.size()), SER_NETWORK, PROTOCOL_VERSION};
         CTransaction ctx{deserialize, stream};
         
-        bytes_view o = transaction::output(tx, i);
-        bytes_view x = output::script(o);
-        
-        ::uint256 tmp= SignatureHash(CScript(x.begin(), x.end()), ctx, i, SigHashType(d), Amount((int64)output::value(o)));
+        ::uint256 tmp= SignatureHash(CScript(spent.Script.begin(), spent.Script.end()), ctx, i, SigHashType(d), Amount((int64)spent.Value));
         
         digest<32> output;
-        std::copy(output.begin(), tmp.begin(), tmp.end());
+        std::copy(tmp.begin(), tmp.end(), output.begin());
         return output;
         
     }
+    
+    bool cached_signature_checker::VerifySignature(const std::vector<uint8_t>& sig, const CPubKey& pubkey, const ::uint256& sighash) const {
+        secp256k1::signature_cache& cache = secp256k1::signature_cache::common();
+        
+        digest256 d;
+        std::copy(sighash.begin(), sighash.end(), d.begin());
+        digest256 key = cache.key(bytes_view{pubkey.begin(), pubkey.size()}, d, bytes_view{sig.data(), sig.size()});
+        
+        if (cache.contains(key)) return true;
+        if (!TransactionSignatureChecker::VerifySignature(sig, pubkey, sighash)) return false;
+        cache.insert(key);
+        return true;
+    }
 
 }
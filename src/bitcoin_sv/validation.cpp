@@ -0,0 +1,137 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include <gigamonkey/script/validation.hpp>
+#include <gigamonkey/script/checker.hpp>
+#include "script/interpreter.h"
+#include "taskcancellation.h"
+#include "streams.h"
+#include "config.h"
+
+namespace Gigamonkey::Bitcoin {
+    
+    namespace {
+        
+        // what is shared among the inputs of a transaction. 
+        struct transaction_context {
+            transaction_view View;
+            txid ID;
+            CDataStream Stream;
+            CTransaction Tx;
+            PrecomputedTransactionData Data;
+            
+            transaction_context(bytes_view tx) : View{tx}, ID{View.id()}, 
+                Stream{(const char*)(tx.data()), (const char*)(tx.data() + tx.size()), SER_NETWORK, PROTOCOL_VERSION}, 
+                Tx{deserialize, Stream}, Data{Tx} {}
+        };
+        
+        evaluated evaluate_input(const transaction_context& x, const transaction_view::output& spent, uint32 index, uint32 flags) {
+            bytes_view unlock = x.View.Inputs[index].Script;
+            
+            evaluated Response;
+            std::optional<bool> response = VerifyScript(
+                GlobalConfig::GetConfig(), 
+                false, 
+                task::CCancellationSource::Make()->GetToken(), 
+                CScript(unlock.begin(), unlock.end()), 
+                CScript(spent.Script.begin(), spent.Script.end()), 
+                flags, 
+                cached_signature_checker(&x.Tx, index, Amount(int64(spent.Value)), x.Data), 
+                &Response.Error);
+            if (response.has_value()) Response.Return = *response;
+            return Response;
+        }
+        
+    }
+    
+    script_validation validate_scripts(const std::vector<spending>& txs, work_stealing_pool& pool, uint32 flags, script_cache& cache) {
+        auto start = std::chrono::steady_clock::now();
+        
+        // contexts are made in parallel too. A transaction which cannot 
+        // be read or which has the wrong number of spent outputs has none. 
+        std::vector<std::unique_ptr<transaction_context>> contexts(txs.size());
+        pool.run(txs.size(), [&txs, &contexts](size_t i) {
+            if (!transaction_view{txs[i].Transaction}.valid()) return;
+            try {
+                auto x = std::make_unique<transaction_context>(txs[i].Transaction);
+                if (x->View.Inputs.size() == txs[i].Spent.size()) contexts[i] = std::move(x);
+            } catch (const std::exception&) {}
+        });
+        
+        // the inputs of all transactions are numbered together 
+        // so that large and small transactions are balanced. 
+        std::vector<size_t> offsets(txs.size() + 1);
+        offsets[0] = 0;
+        for (size_t i = 0; i < txs.size(); i++) 
+            offsets[i + 1] = offsets[i] + (contexts[i] == nullptr ? std::max(txs[i].Spent.size(), size_t{1}) : txs[i].Spent.size());
+        
+        script_validation result{};
+        result.Inputs.resize(offsets.back());
+        pool.run(offsets.back(), [&txs, &contexts, &offsets, &result, &cache, flags](size_t i) {
+            size_t tx = std::upper_bound(offsets.begin(), offsets.end(), i) - offsets.begin() - 1;
+            if (contexts[tx] == nullptr) {
+                result.Inputs[i] = evaluated{SCRIPT_ERR_UNKNOWN_ERROR};
+                return;
+            }
+            
+            uint32 index = i - offsets[tx];
+            const transaction_view::output& spent = txs[tx].Spent[index];
+            digest256 key = cache.key(contexts[tx]->ID, index, spent, flags);
+            if (cache.contains(key)) {
+                result.Inputs[i].Return = true;
+                return;
+            }
+            
+            try {
+                evaluated e = evaluate_input(*contexts[tx], spent, index, flags);
+                if (e.valid() && e.Return) cache.insert(key);
+                result.Inputs[i] = e;
+            } catch (const std::exception&) {
+                result.Inputs[i] = evaluated{SCRIPT_ERR_UNKNOWN_ERROR};
+            }
+        });
+        
+        result.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return result;
+    }
+    
+    script_validation validate_scripts(const ledger::vertex& v, work_stealing_pool& pool, uint32 flags, script_cache& cache) {
+        if (!v.double_entry::valid()) return script_validation::failed();
+        
+        transaction_view tx{*v};
+        if (!tx.valid()) return script_validation::failed();
+        
+        // each previous transaction is read once. The views point into 
+        // transactions which are held by the vertex. 
+        std::map<txid, transaction_view> previous;
+        spending x{*v, {}};
+        for (const transaction_view::input& in : tx.Inputs) {
+            txid id = outpoint::reference(slice<36>(const_cast<byte*>(in.Outpoint.data())));
+            index i = outpoint::index(slice<36>(const_cast<byte*>(in.Outpoint.data())));
+            
+            auto p = previous.find(id);
+            if (p == previous.end()) {
+                ledger::double_entry d = v.Previous[id];
+                if (!d.valid()) return script_validation::failed();
+                p = previous.emplace(id, transaction_view{*d}).first;
+            }
+            
+            if (p->second.Outputs.size() <= i) return script_validation::failed();
+            x.Spent.push_back(p->second.Outputs[i]);
+        }
+        
+        return validate_scripts(x, pool, flags, cache);
+    }
+    
+    script_validation validate_block_scripts(bytes_view block, const std::vector<std::vector<transaction_view::output>>& spent, 
+        work_stealing_pool& pool, uint32 flags, script_cache& cache) {
+        std::vector<bytes_view> transactions = block::transactions(block);
+        if (transactions.size() == 0 || transactions.size() - 1 != spent.size()) return script_validation::failed();
+        
+        std::vector<spending> txs(spent.size());
+        for (size_t i = 0; i < spent.size(); i++) txs[i] = spending{transactions[i + 1], spent[i]};
+        
+        return validate_scripts(txs, pool, flags, cache);
+    }
+    
+}
@@ -1,4 +1,5 @@
 #include <gigamonkey/accounts.hpp>
+#include <algorithm>
     
 namespace Gigamonkey::Bitcoin {
     
@@ -64,5 +65,109 @@ namespace Gigamonkey::Bitcoin {
         
         return x;
     }*/
+    
+    bool balance_engine::ingest(bytes_view tx, timestamp t, const std::vector<uint32>& mine) {
+        transaction_view v{tx};
+        if (!v.valid()) return false;
+        for (uint32 i : mine) if (i >= v.Outputs.size()) return false;
+        
+        txid id = v.id();
+        if (!Transactions.insert(id).second) return false;
+        
+        int64 change = 0;
+        
+        // an input which spends an output of mine is a debit. Other 
+        // inputs might spend an output of an event that comes later. 
+        for (const transaction_view::input& in : v.Inputs) {
+            slice<36> x(const_cast<byte*>(in.Outpoint.data()));
+            outpoint o{outpoint::reference(x), outpoint::index(x)};
+            const satoshi* value = Unspent.find(o);
+            if (value == nullptr) {
+                // if we have the previous transaction, the output is not mine. 
+                if (!Transactions.count(o.Reference)) Spends.insert(o, uint32(t));
+                continue;
+            }
+            
+            change -= int64(*value);
+            Spent = Spent + *value;
+            Unspent.erase(o);
+        }
+        
+        std::vector<uint32> outputs{mine};
+        std::sort(outputs.begin(), outputs.end());
+        outputs.erase(std::unique(outputs.begin(), outputs.end()), outputs.end());
+        
+        // an output of mine is a credit. If it was spent by an 
+        // event that we already have, that is a debit then. 
+        std::vector<point> debits;
+        for (uint32 i : outputs) {
+            outpoint o{id, i};
+            satoshi value = v.Outputs[i].Value;
+            change += int64(value);
+            Received = Received + value;
+            
+            const uint32* spent_at = Spends.find(o);
+            if (spent_at == nullptr) {
+                Unspent.insert(o, value);
+                continue;
+            }
+            
+            debits.push_back(point{*spent_at, -int64(value)});
+            Spent = Spent + value;
+            Spends.erase(o);
+        }
+        
+        record(uint32(t), change);
+        for (const point& p : debits) record(p.Time, p.Balance);
+        return true;
+    }
+    
+    bool balance_engine::ingest(const account::event& e) {
+        if (!e.double_entry::valid()) return false;
+        std::vector<uint32> mine;
+        for (uint32 i : e.Mine) mine.push_back(i);
+        return ingest(*e, e.time(), mine);
+    }
+    
+    size_t balance_engine::prune(timestamp before) {
+        std::vector<outpoint> old;
+        Spends.for_each([&old, before](const outpoint& o, uint32 t) -> void {
+            if (t < uint32(before)) old.push_back(o);
+        });
+        
+        for (const outpoint& o : old) Spends.erase(o);
+        return old.size();
+    }
+    
+    void balance_engine::record(uint32 time, int64 change) {
+        if (History.size() == 0 || History.back().Time < time) {
+            History.push_back(point{time, int64(balance()) + change});
+            return;
+        }
+        
+        if (History.back().Time == time) {
+            History.back().Balance += change;
+            return;
+        }
+        
+        // an earlier event changes every balance after it. 
+        auto it = std::upper_bound(History.begin(), History.end(), time, [](uint32 t, const point& p) -> bool {
+            return t < p.Time;
+        });
+        
+        if (it == History.begin() || std::prev(it)->Time != time) 
+            it = History.insert(it, point{time, it == History.begin() ? 0 : std::prev(it)->Balance});
+        else it--;
+        
+        for (; it != History.end(); it++) it->Balance += change;
+    }
+    
+    satoshi balance_engine::balance(timestamp t) const {
+        auto it = std::upper_bound(History.begin(), History.end(), uint32(t), [](uint32 t, const point& p) -> bool {
+            return t < p.Time;
+        });
+        
+        return it == History.begin() ? satoshi{0} : satoshi{std::prev(it)->Balance};
+    }
 }
 
@@ -7,7 +7,15 @@
 namespace Gigamonkey::base58 {
     
     string check::encode() const {
-        bytes data = Bitcoin::append_checksum(static_cast<bytes>(*this));
+        // addresses and WIF keys have their own encoders. 
+        switch (size()) {
+            case 21: return fixed<21>::encode(data());
+            case 33: return fixed<33>::encode(data());
+            case 34: return fixed<34>::encode(data());
+            default: break;
+        }
+        
+        bytes data = Bitcoin::append_checksum(*this);
         size_t leading_zeros = 0;
         while (leading_zeros < data.size() && data[leading_zeros] == 0) leading_zeros++;
         string b58 = data::encoding::base58::write(bytes_view(data).substr(leading_zeros));
@@ -45,13 +53,21 @@ namespace Gigamonkey::Bitcoin {
         return without;
     }
     
-   address::address(string_view s) : address{} {
+    address::address(string_view s) : address{} {
         if (s.size() > 35 || s.size() < 5) return;
-        base58::check b58(s);
-        if (!b58.valid()) return;
-        Prefix = type(b58.version());
-        if (!valid_prefix(Prefix)) return;
-        if (b58.payload().size() > 20) return;
-        std::copy(b58.payload().begin(), b58.payload().end(), Digest.Value.begin());
+        byte data[21];
+        if (!base58::fixed<21>::read(s, data) || !valid_prefix(type(data[0]))) return;
+        Prefix = type(data[0]);
+        std::copy(data + 1, data + 21, Digest.Value.begin());
+    }
+    
+    std::vector<string> address::write(const std::vector<address>& a) {
+        bytes data(a.size() * 21);
+        auto x = data.begin();
+        for (const address& b : a) {
+            *x++ = byte(b.Prefix);
+            x = std::copy(b.Digest.Value.begin(), b.Digest.Value.end(), x);
+        }
+        return base58::fixed<21>::encode_all(data);
     }
 }
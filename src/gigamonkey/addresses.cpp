@@ -0,0 +1,65 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include <gigamonkey/addresses.hpp>
+
+namespace Gigamonkey::Bitcoin {
+    
+    namespace {
+        
+        // enough that the pool is not asked for each key. 
+        constexpr size_t BlockSize = 256;
+        
+    }
+    
+    addresses addresses::write(address::type t, const pubkey* keys, size_t size, work_stealing_pool& pool) {
+        addresses x{size};
+        
+        pool.run((size + BlockSize - 1) / BlockSize, [&x, t, keys, size](size_t block) {
+            size_t begin = block * BlockSize;
+            size_t end = std::min(size, begin + BlockSize);
+            
+            bytes_view valid[BlockSize];
+            size_t index[BlockSize];
+            size_t n = 0;
+            for (size_t i = begin; i < end; i++) {
+                const bytes& key = keys[i].Value;
+                if (key.size() != secp256k1::CompressedPubkeySize && key.size() != secp256k1::UncompressedPubkeySize) {
+                    x.Sizes[i] = 0;
+                    continue;
+                }
+                
+                valid[n] = key;
+                index[n++] = i;
+            }
+            
+            digest160 digests[BlockSize];
+            hash160_batch(valid, digests, n);
+            
+            byte data[21];
+            data[0] = byte(t);
+            for (size_t j = 0; j < n; j++) {
+                std::copy(digests[j].begin(), digests[j].end(), data + 1);
+                x.Sizes[index[j]] = byte(base58::fixed<21>::write(data, x.Characters.get() + index[j] * Stride));
+            }
+        });
+        
+        return x;
+    }
+    
+    std::string addresses::join(char separator) const {
+        size_t total = 0;
+        for (byte s : Sizes) total += s + 1;
+        
+        std::string joined;
+        joined.reserve(total);
+        for (size_t i = 0; i < size(); i++) {
+            joined.append(Characters.get() + i * Stride, Sizes[i]);
+            joined.push_back(separator);
+        }
+        
+        return joined;
+    }
+    
+}
+
@@ -398,6 +398,18 @@ namespace Gigamonkey::Boost {
         return o << "}";
     }
         
+    // the signature, the pubkey, the nonce, the timestamp and both extra nonces, 
+    // then the general purpose bits and the miner address if they are used. 
+    uint32 redeem_boost::expected_size() const {
+        return Bitcoin::estimate::MaxSignaturePushSize + Pubkey.size() + 1 + 5 + 5 + 9 + 5 + 
+            (UseGeneralPurposeBits ? 5 : 0) + (Type == bounty ? 21 : 0);
+    }
+    
+    // the output script ends with OP_CHECKSIG. 
+    uint32 redeem_boost::sigops() const {
+        return 1;
+    }
+    
     proof::proof(const Boost::output_script& out, const Boost::input_script& in) : proof{} {
         if (out.Type == invalid || in.Type != out.Type) return;
         if (out.UseGeneralPurposeBits && bool(in.GeneralPurposeBits)) {
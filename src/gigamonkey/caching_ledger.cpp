@@ -0,0 +1,97 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include <gigamonkey/caching_ledger.hpp>
+
+namespace Gigamonkey::Bitcoin {
+    
+    bool caching_ledger::find(const txid& id, double_entry& d) const {
+        auto it = Index.find(id);
+        if (it == Index.end()) {
+            Misses++;
+            return false;
+        }
+        
+        Hits++;
+        Recent.splice(Recent.begin(), Recent, it->second);
+        d = it->second->Value;
+        return true;
+    }
+    
+    void caching_ledger::remember(const data::entry<txid, double_entry>& x) const {
+        if (Capacity == 0 || !x.Value.valid() || Index.find(x.Key) != Index.end()) return;
+        
+        Recent.push_front(x);
+        Index[x.Key] = Recent.begin();
+        
+        if (Recent.size() > Capacity) {
+            Index.erase(Recent.back().Key);
+            Recent.pop_back();
+        }
+    }
+    
+    data::entry<txid, double_entry> caching_ledger::transaction(const txid& id) const {
+        {
+            std::lock_guard<std::mutex> lock{Mutex};
+            double_entry d;
+            if (find(id, d)) return data::entry<txid, double_entry>{id, d};
+        }
+        
+        // the lock is not held while the other ledger is asked. 
+        data::entry<txid, double_entry> x = Ledger->transaction(id);
+        std::lock_guard<std::mutex> lock{Mutex};
+        remember(x);
+        return x;
+    }
+    
+    std::vector<data::entry<txid, double_entry>> caching_ledger::transactions(const std::vector<txid>& ids) const {
+        std::vector<data::entry<txid, double_entry>> x;
+        x.reserve(ids.size());
+        
+        // positions of the results that are not known yet. 
+        std::unordered_map<txid, std::vector<size_t>, salted_hasher> missing;
+        std::vector<txid> ask;
+        {
+            std::lock_guard<std::mutex> lock{Mutex};
+            for (const txid& id : ids) {
+                double_entry d;
+                if (!find(id, d)) {
+                    std::vector<size_t>& positions = missing[id];
+                    if (positions.empty()) ask.push_back(id);
+                    positions.push_back(x.size());
+                }
+                
+                x.push_back(data::entry<txid, double_entry>{id, d});
+            }
+        }
+        
+        if (ask.empty()) return x;
+        
+        std::vector<data::entry<txid, double_entry>> found = Ledger->transactions(ask);
+        std::lock_guard<std::mutex> lock{Mutex};
+        for (const data::entry<txid, double_entry>& f : found) {
+            auto it = missing.find(f.Key);
+            if (it == missing.end()) continue;
+            for (size_t i : it->second) x[i] = f;
+            remember(f);
+        }
+        
+        return x;
+    }
+    
+    size_t caching_ledger::size() const {
+        std::lock_guard<std::mutex> lock{Mutex};
+        return Recent.size();
+    }
+    
+    uint64 caching_ledger::hits() const {
+        std::lock_guard<std::mutex> lock{Mutex};
+        return Hits;
+    }
+    
+    uint64 caching_ledger::misses() const {
+        std::lock_guard<std::mutex> lock{Mutex};
+        return Misses;
+    }
+    
+}
@@ -0,0 +1,85 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include <gigamonkey/change_pool.hpp>
+
+namespace Gigamonkey::Bitcoin {
+    
+    change_pool::change_pool(ptr<output_pattern> pattern, ptr<keysource> keys, uint32 size) : 
+        Pattern{pattern}, Keys{keys}, Queue{size == 0 ? 1 : size}, LowWater{Queue.capacity() / 2}, 
+        Mutex{}, Error{}, Refill{}, Ready{}, Stop{false}, Worker{} {
+        Worker = std::thread{[this]() {
+            fill();
+        }};
+    }
+    
+    change_pool::~change_pool() {
+        {
+            std::lock_guard<std::mutex> lock{Mutex};
+            Stop = true;
+        }
+        
+        Refill.notify_all();
+        Worker.join();
+    }
+    
+    change_pool::made change_pool::take() const {
+        made c{};
+        if (Queue.pop(c)) {
+            if (Queue.size() <= LowWater) {
+                // taking the lock ensures that the worker is either 
+                // waiting or has not yet looked at the size. 
+                { std::lock_guard<std::mutex> lock{Mutex}; }
+                Refill.notify_one();
+            }
+            
+            return c;
+        }
+        
+        // the pool is empty, so wait for the worker. 
+        std::unique_lock<std::mutex> lock{Mutex};
+        Refill.notify_one();
+        bool popped = false;
+        Ready.wait(lock, [this, &c, &popped]() {
+            popped = Queue.pop(c);
+            return popped || Error != nullptr;
+        });
+        
+        if (!popped) std::rethrow_exception(Error);
+        return c;
+    }
+    
+    void change_pool::fill() {
+        std::optional<made> next{};
+        while (!Stop) {
+            // an exception cannot be allowed to leave the thread, 
+            // so it is kept to be thrown to whoever waits for change. 
+            if (!next) try {
+                change c = Pattern->create_redeemable(Keys);
+                next = made{std::move(c), Keys};
+            } catch (...) {
+                {
+                    std::lock_guard<std::mutex> lock{Mutex};
+                    Error = std::current_exception();
+                }
+                
+                Ready.notify_all();
+                return;
+            }
+            
+            if (Queue.push(std::move(*next))) {
+                next.reset();
+                { std::lock_guard<std::mutex> lock{Mutex}; }
+                Ready.notify_all();
+                continue;
+            }
+            
+            // the queue is full. 
+            std::unique_lock<std::mutex> lock{Mutex};
+            Refill.wait(lock, [this]() {
+                return Stop || Queue.size() <= LowWater;
+            });
+        }
+    }
+    
+}
@@ -0,0 +1,232 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include <gigamonkey/coin_selection.hpp>
+#include <random>
+#include <limits>
+
+namespace Gigamonkey::Bitcoin {
+    
+    size_t coin_selection::input_size(const spendable& s) {
+        return estimate::input_size(s.Redeemer->expected_size());
+    }
+    
+    satoshi coin_selection::fee(const std::vector<spendable>& inputs, bool change) const {
+        // the base size counts one byte for the number of inputs. 
+        size_t size = BaseSize - 1 + writer::var_int_size(inputs.size()) + (change ? ChangeOutputSize : 0);
+        uint32 sigops = BaseSigops;
+        for (const spendable& s : inputs) {
+            size += input_size(s);
+            sigops += s.Redeemer->sigops();
+        }
+        
+        return Fee.calculate(size, sigops);
+    }
+    
+    namespace {
+        
+        // an output together with its value less the fee to spend it. 
+        struct candidate {
+            const spendable* Spendable;
+            int64 Effective;
+        };
+        
+        // from largest to smallest effective value. 
+        std::vector<candidate> candidates(const utxo_set& u, const fee& f) {
+            std::vector<candidate> x;
+            x.reserve(u.size());
+            u.by_value([&x, &f](const spendable& s) {
+                if (s.Redeemer == nullptr) return;
+                int64 effective = int64(s.Value) - int64(f.calculate(coin_selection::input_size(s), s.Redeemer->sigops()));
+                if (effective > 0) x.push_back(candidate{&s, effective});
+            });
+            
+            std::stable_sort(x.begin(), x.end(), [](const candidate& a, const candidate& b) -> bool {
+                return a.Effective > b.Effective;
+            });
+            
+            return x;
+        }
+        
+        // fill in the fee and change once the inputs are chosen. The fee is 
+        // calculated again for the whole transaction in case the effective 
+        // values of the inputs were rounded differently. 
+        coin_selection::result complete(const coin_selection& c, std::vector<spendable> inputs, coin_selection::method m, bool change) {
+            coin_selection::result r{};
+            for (const spendable& s : inputs) r.Value = r.Value + s.Value;
+            
+            if (change) {
+                satoshi f = c.fee(inputs, true);
+                int64 left = int64(r.Value) - int64(c.Target) - int64(f);
+                if (left >= int64(c.Dust)) {
+                    r.Fee = f;
+                    r.Change = satoshi{left};
+                    r.Inputs = std::move(inputs);
+                    r.Method = m;
+                    return r;
+                }
+            }
+            
+            // without change, anything left over goes to the fee. 
+            satoshi f = c.fee(inputs, false);
+            if (int64(r.Value) < int64(c.Target) + int64(f)) return {};
+            r.Fee = satoshi{int64(r.Value) - int64(c.Target)};
+            r.Inputs = std::move(inputs);
+            r.Method = m;
+            return r;
+        }
+        
+    }
+    
+    coin_selection::result coin_selection::select(const utxo_set& u) const {
+        result r = select_branch_and_bound(u);
+        if (r.valid()) return r;
+        r = select_knapsack(u);
+        if (r.valid()) return r;
+        return select_largest_first(u);
+    }
+    
+    // Depth-first search over including or excluding each candidate, from 
+    // the largest, as in Bitcoin Core. A branch is abandoned if it has gone 
+    // over the window or if what is left cannot reach it. 
+    coin_selection::result coin_selection::select_branch_and_bound(const utxo_set& u) const {
+        std::vector<candidate> pool = candidates(u, Fee);
+        
+        int64 target = int64(Target) + int64(Fee.calculate(BaseSize, BaseSigops));
+        int64 cost_of_change = int64(Fee.calculate(ChangeOutputSize + ChangeInputSize, 0));
+        
+        int64 available = 0;
+        for (const candidate& c : pool) available += c.Effective;
+        if (available < target) return {};
+        
+        std::vector<bool> selection;
+        std::vector<bool> best;
+        int64 value = 0;
+        int64 best_waste = std::numeric_limits<int64>::max();
+        
+        for (uint32 tries = 0; tries < MaxTries; tries++) {
+            bool backtrack = false;
+            if (value + available < target || value > target + cost_of_change) backtrack = true;
+            else if (value >= target) {
+                if (value - target <= best_waste) {
+                    best = selection;
+                    best_waste = value - target;
+                }
+                
+                backtrack = true;
+            }
+            
+            if (backtrack) {
+                // go back to the last candidate that was included and exclude it. 
+                while (!selection.empty() && !selection.back()) {
+                    selection.pop_back();
+                    available += pool[selection.size()].Effective;
+                }
+                
+                if (selection.empty()) break;
+                
+                selection.back() = false;
+                value -= pool[selection.size() - 1].Effective;
+            } else {
+                const candidate& next = pool[selection.size()];
+                available -= next.Effective;
+                
+                // excluding a candidate equal to the last excluded one gives the same results. 
+                if (!selection.empty() && !selection.back() && next.Effective == pool[selection.size() - 1].Effective) 
+                    selection.push_back(false);
+                else {
+                    selection.push_back(true);
+                    value += next.Effective;
+                }
+            }
+        }
+        
+        if (best_waste == std::numeric_limits<int64>::max()) return {};
+        
+        std::vector<spendable> inputs;
+        for (size_t i = 0; i < best.size(); i++) if (best[i]) inputs.push_back(*pool[i].Spendable);
+        return complete(*this, std::move(inputs), branch_and_bound, false);
+    }
+    
+    // Random subsets of the candidates smaller than the target with change are 
+    // tried, looking for the smallest total that reaches it, as in Bitcoin Core. 
+    // This is compared with the smallest candidate that reaches it alone. 
+    coin_selection::result coin_selection::select_knapsack(const utxo_set& u) const {
+        std::vector<candidate> pool = candidates(u, Fee);
+        
+        int64 target = int64(Target) + int64(Fee.calculate(BaseSize + ChangeOutputSize, BaseSigops)) + int64(Dust);
+        
+        const candidate* lowest_larger = nullptr;
+        std::vector<candidate> smaller;
+        int64 total = 0;
+        for (const candidate& c : pool) {
+            if (c.Effective >= target) lowest_larger = &c;
+            else {
+                smaller.push_back(c);
+                total += c.Effective;
+            }
+        }
+        
+        // the target may be reached without any smaller candidates 
+        // if it is not positive. 
+        if (smaller.empty() || total < target) {
+            if (lowest_larger == nullptr) return {};
+            return complete(*this, std::vector<spendable>{*lowest_larger->Spendable}, knapsack, true);
+        }
+        
+        // the number of passes is limited so that large wallets do not take too long. 
+        uint32 repetitions = std::max(size_t{1}, std::min(size_t{1000}, size_t{10000000} / smaller.size()));
+        
+        static thread_local std::mt19937_64 Random{std::random_device{}()};
+        std::vector<bool> best(smaller.size(), true);
+        int64 best_value = total;
+        std::vector<bool> included(smaller.size());
+        
+        for (uint32 rep = 0; rep < repetitions && best_value != target; rep++) {
+            std::fill(included.begin(), included.end(), false);
+            int64 value = 0;
+            bool reached = false;
+            for (int pass = 0; pass < 2 && !reached; pass++) for (size_t i = 0; i < smaller.size(); i++) {
+                if (pass == 0 ? (Random() & 1) == 0 : included[i]) continue;
+                value += smaller[i].Effective;
+                included[i] = true;
+                if (value >= target) {
+                    reached = true;
+                    if (value < best_value) {
+                        best_value = value;
+                        best = included;
+                    }
+                    
+                    value -= smaller[i].Effective;
+                    included[i] = false;
+                }
+            }
+        }
+        
+        // a single larger candidate is better if it is closer. 
+        if (lowest_larger != nullptr && lowest_larger->Effective <= best_value) 
+            return complete(*this, std::vector<spendable>{*lowest_larger->Spendable}, knapsack, true);
+        
+        std::vector<spendable> inputs;
+        for (size_t i = 0; i < smaller.size(); i++) if (best[i]) inputs.push_back(*smaller[i].Spendable);
+        return complete(*this, std::move(inputs), knapsack, true);
+    }
+    
+    coin_selection::result coin_selection::select_largest_first(const utxo_set& u) const {
+        std::vector<candidate> pool = candidates(u, Fee);
+        
+        int64 target = int64(Target) + int64(Fee.calculate(BaseSize + ChangeOutputSize, BaseSigops)) + int64(Dust);
+        
+        std::vector<spendable> inputs;
+        int64 value = 0;
+        for (const candidate& c : pool) {
+            inputs.push_back(*c.Spendable);
+            value += c.Effective;
+            if (value >= target) break;
+        }
+        
+        // if change cannot be made, complete will try without it. 
+        return complete(*this, std::move(inputs), largest_first, true);
+    }
+    
+}
@@ -2,15 +2,113 @@
 // Distributed under the Open BSV software license, see the accompanying file LICENSE.
 
 #include <gigamonkey/ecies/bitcore.hpp>
+#include <gigamonkey/schema/random.hpp>
+#include <cryptopp/hmac.h>
+#include <cryptopp/sha.h>
+#include <stdexcept>
 
 namespace Gigamonkey::ECIES::bitcore {
     
-    bytes encrypt(const bytes message, const secp256k1::pubkey& to) {
-        throw method::unimplemented{"bitcore::encrypt"};
-    }
+    namespace {
+        
+        constexpr size_t HeaderSize = secp256k1::CompressedPubkeySize + IVSize;
+        
+        // the IV is not derived. 
+        keys derive_keys(const secp256k1::pubkey& shared) {
+            // the x coordinate, which follows the first byte. 
+            bytes p = shared.compress().Value;
+            digest512 k = sha512(bytes_view{p.data() + 1, p.size() - 1});
+            return keys{bytes(k.Value.begin(), k.Value.begin() + 32), bytes{}, bytes(k.Value.begin() + 32, k.Value.end())};
+        }
+        
+        keys with_iv(keys k, bytes_view iv) {
+            if (iv.size() != IVSize) throw std::invalid_argument{"IV must be 16 bytes"};
+            k.IV = bytes{iv};
+            return k;
+        }
+        
+        bytes header(const secp256k1::pubkey& from, bytes_view iv) {
+            bytes h = from.compress().Value;
+            h.insert(h.end(), iv.begin(), iv.end());
+            return h;
+        }
+        
+        bytes random_iv() {
+            bytes iv(IVSize);
+            bitcoind_random{}.get(iv.data(), iv.size());
+            return iv;
+        }
+        
+        // bitcore's IV is from an HMAC of the message with the private key. 
+        bytes message_iv(const secp256k1::secret& s, bytes_view message) {
+            byte mac[CryptoPP::HMAC<CryptoPP::SHA256>::DIGESTSIZE];
+            bytes_view key{s.Value};
+            CryptoPP::HMAC<CryptoPP::SHA256> hmac{key.data(), key.size()};
+            hmac.Update(message.data(), message.size());
+            hmac.Final(mac);
+            return bytes(mac, mac + IVSize);
+        }
+        
+        template <typename stream> bytes all(stream&& s, bytes_view message) {
+            bytes b = s.update(message);
+            bytes end = s.finalize();
+            b.insert(b.end(), end.begin(), end.end());
+            return b;
+        }
         
-    bytes decrypt(const bytes message, const secp256k1::secret& to) {
-        throw method::unimplemented{"bitcore::decrypt"};
+    }
+    
+    encryptor::encryptor(const secp256k1::pubkey& to) : encryptor{to, ephemeral(), random_iv()} {}
+    
+    encryptor::encryptor(const secp256k1::pubkey& to, const secp256k1::secret& ephemeral, bytes_view iv) : 
+        encryptor{derive_keys(to * ephemeral), ephemeral.to_public(), iv} {}
+    
+    encryptor::encryptor(keys k, const secp256k1::pubkey& from, bytes_view iv) : 
+        ECIES::encryptor{with_iv(std::move(k), iv), header(from, iv), secp256k1::CompressedPubkeySize} {}
+    
+    decryptor::decryptor(const secp256k1::secret& to) : 
+        ECIES::decryptor{HeaderSize, secp256k1::CompressedPubkeySize}, To{to}, Cache{} {}
+    
+    decryptor::decryptor(ptr<const key_cache> c) : 
+        ECIES::decryptor{HeaderSize, secp256k1::CompressedPubkeySize}, To{c->secret()}, Cache{c} {}
+    
+    keys decryptor::derive(bytes_view h) const {
+        secp256k1::pubkey ephemeral{h.substr(0, secp256k1::CompressedPubkeySize)};
+        bytes_view iv = h.substr(secp256k1::CompressedPubkeySize);
+        if (Cache != nullptr) return with_iv(Cache->get(ephemeral), iv);
+        if (!ephemeral.valid()) throw std::invalid_argument{"invalid ephemeral public key"};
+        return with_iv(derive_keys(ephemeral * To), iv);
+    }
+    
+    bytes encrypt(bytes_view message, const secp256k1::pubkey& to) {
+        return encrypt(message, to, ephemeral());
+    }
+    
+    bytes encrypt(bytes_view message, const secp256k1::pubkey& to, const secp256k1::secret& ephemeral) {
+        return all(encryptor{to, ephemeral, message_iv(ephemeral, message)}, message);
+    }
+    
+    bytes decrypt(bytes_view message, const secp256k1::secret& to) {
+        return all(decryptor{to}, message);
+    }
+    
+    session::session(const secp256k1::secret& ours, size_t capacity) : 
+        Cache{std::make_shared<key_cache>(ours, derive_keys, capacity)} {}
+    
+    encryptor session::encrypting(const secp256k1::pubkey& to) const {
+        return encryptor{Cache->get(to), Cache->pubkey(), random_iv()};
+    }
+    
+    decryptor session::decrypting() const {
+        return decryptor{Cache};
+    }
+    
+    bytes session::encrypt(bytes_view message, const secp256k1::pubkey& to) const {
+        return all(encrypting(to), message);
+    }
+    
+    bytes session::decrypt(bytes_view message) const {
+        return all(decrypting(), message);
     }
     
 }
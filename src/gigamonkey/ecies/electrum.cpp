@@ -2,18 +2,77 @@
 // Distributed under the Open BSV software license, see the accompanying file LICENSE.
 
 #include <gigamonkey/ecies/electrum.hpp>
+#include <stdexcept>
 
 namespace Gigamonkey::ECIES::electrum {
     
-    bytes encrypt(const bytes message, const secp256k1::pubkey& to) {
-        throw method::unimplemented{"electrum::encrypt"};
-    }
+    namespace {
+        
+        constexpr size_t MagicSize = 4;
+        const byte Magic[MagicSize] = {'B', 'I', 'E', '1'};
+        
+        constexpr size_t HeaderSize = MagicSize + secp256k1::CompressedPubkeySize;
+        
+        keys derive_keys(const secp256k1::pubkey& shared) {
+            digest512 k = sha512(shared.compress().Value);
+            return keys{bytes(k.Value.begin() + 16, k.Value.begin() + 32), 
+                bytes(k.Value.begin(), k.Value.begin() + 16), 
+                bytes(k.Value.begin() + 32, k.Value.end())};
+        }
+        
+        bytes header(const secp256k1::pubkey& from) {
+            bytes h(Magic, Magic + MagicSize);
+            bytes p = from.compress().Value;
+            h.insert(h.end(), p.begin(), p.end());
+            return h;
+        }
+        
+        template <typename stream> bytes all(stream&& s, bytes_view message) {
+            bytes b = s.update(message);
+            bytes end = s.finalize();
+            b.insert(b.end(), end.begin(), end.end());
+            return b;
+        }
         
-    bytes decrypt(const bytes message, const secp256k1::secret& to) {
-        throw method::unimplemented{"electrum::decrypt"};
+    }
+    
+    encryptor::encryptor(const secp256k1::pubkey& to, const secp256k1::secret& ephemeral) : 
+        ECIES::encryptor{derive_keys(to * ephemeral), header(ephemeral.to_public()), 0} {}
+    
+    decryptor::decryptor(const secp256k1::secret& to) : ECIES::decryptor{HeaderSize, 0}, To{to}, Cache{} {}
+    
+    decryptor::decryptor(ptr<const key_cache> c) : ECIES::decryptor{HeaderSize, 0}, To{c->secret()}, Cache{c} {}
+    
+    keys decryptor::derive(bytes_view h) const {
+        if (!std::equal(Magic, Magic + MagicSize, h.begin())) throw std::invalid_argument{"not an electrum ECIES message"};
+        secp256k1::pubkey ephemeral{h.substr(MagicSize)};
+        if (Cache != nullptr) return Cache->get(ephemeral);
+        if (!ephemeral.valid()) throw std::invalid_argument{"invalid ephemeral public key"};
+        return derive_keys(ephemeral * To);
+    }
+    
+    bytes encrypt(bytes_view message, const secp256k1::pubkey& to) {
+        return encrypt(message, to, ephemeral());
+    }
+    
+    bytes encrypt(bytes_view message, const secp256k1::pubkey& to, const secp256k1::secret& ephemeral) {
+        return all(encryptor{to, ephemeral}, message);
+    }
+    
+    bytes decrypt(bytes_view message, const secp256k1::secret& to) {
+        return all(decryptor{to}, message);
+    }
+    
+    session::session(const secp256k1::secret& ours, size_t capacity) : 
+        Cache{std::make_shared<key_cache>(ours, derive_keys, capacity)} {}
+    
+    decryptor session::decrypting() const {
+        return decryptor{Cache};
+    }
+    
+    bytes session::decrypt(bytes_view message) const {
+        return all(decrypting(), message);
     }
     
 }
 
-
-
@@ -0,0 +1,56 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include <gigamonkey/ecies/session.hpp>
+#include <stdexcept>
+
+namespace Gigamonkey::ECIES {
+    
+    keys key_cache::get(const secp256k1::pubkey& theirs) const {
+        {
+            std::lock_guard<std::mutex> lock{Mutex};
+            auto it = Index.find(theirs.Value);
+            if (it != Index.end()) {
+                Hits++;
+                Recent.splice(Recent.begin(), Recent, it->second);
+                return it->second->second;
+            }
+            
+            Misses++;
+        }
+        
+        // the lock is not held while the keys are derived. 
+        if (!theirs.valid()) throw std::invalid_argument{"invalid public key"};
+        keys k = Derive(theirs * Secret);
+        
+        std::lock_guard<std::mutex> lock{Mutex};
+        if (Capacity == 0 || Index.find(theirs.Value) != Index.end()) return k;
+        
+        Recent.emplace_front(theirs.Value, k);
+        Index[theirs.Value] = Recent.begin();
+        
+        if (Recent.size() > Capacity) {
+            Index.erase(Recent.back().first);
+            Recent.pop_back();
+        }
+        
+        return k;
+    }
+    
+    size_t key_cache::size() const {
+        std::lock_guard<std::mutex> lock{Mutex};
+        return Recent.size();
+    }
+    
+    uint64 key_cache::hits() const {
+        std::lock_guard<std::mutex> lock{Mutex};
+        return Hits;
+    }
+    
+    uint64 key_cache::misses() const {
+        std::lock_guard<std::mutex> lock{Mutex};
+        return Misses;
+    }
+    
+}
+
@@ -0,0 +1,163 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include <gigamonkey/ecies/stream.hpp>
+#include <gigamonkey/schema/random.hpp>
+#include <cryptopp/aes.h>
+#include <cryptopp/modes.h>
+#include <cryptopp/filters.h>
+#include <cryptopp/hmac.h>
+#include <cryptopp/sha.h>
+#include <cryptopp/misc.h>
+#include <stdexcept>
+
+namespace Gigamonkey::ECIES {
+    
+    namespace {
+        
+        constexpr size_t MACSize = CryptoPP::HMAC<CryptoPP::SHA256>::DIGESTSIZE;
+        
+        // everything the filter has written so far. 
+        bytes retrieve(CryptoPP::BufferedTransformation& f) {
+            bytes b(f.MaxRetrievable());
+            if (b.size() > 0) f.Get(b.data(), b.size());
+            return b;
+        }
+        
+        void append(bytes& to, bytes_view b) {
+            to.insert(to.end(), b.begin(), b.end());
+        }
+        
+    }
+    
+    struct encryptor::state {
+        CryptoPP::CBC_Mode<CryptoPP::AES>::Encryption Cipher;
+        CryptoPP::StreamTransformationFilter Filter;
+        CryptoPP::HMAC<CryptoPP::SHA256> MAC;
+        
+        // written with the first ciphertext. 
+        bytes Header;
+        
+        state(const keys& k, bytes header, size_t unauthenticated) :
+            Cipher{k.Encryption.data(), k.Encryption.size(), k.IV.data()},
+            Filter{Cipher, nullptr, CryptoPP::StreamTransformationFilter::PKCS_PADDING},
+            MAC{k.Authentication.data(), k.Authentication.size()}, Header{std::move(header)} {
+            MAC.Update(Header.data() + unauthenticated, Header.size() - unauthenticated);
+        }
+        
+        bytes output() {
+            bytes b = retrieve(Filter);
+            MAC.Update(b.data(), b.size());
+            if (Header.size() == 0) return b;
+            append(Header, b);
+            return std::move(Header);
+        }
+    };
+    
+    encryptor::encryptor(const keys& k, bytes header, size_t unauthenticated) :
+        State{new state{k, std::move(header), unauthenticated}} {}
+    
+    encryptor::encryptor(encryptor&&) = default;
+    encryptor& encryptor::operator=(encryptor&&) = default;
+    encryptor::~encryptor() = default;
+    
+    bytes encryptor::update(bytes_view b) {
+        if (State == nullptr) throw std::logic_error{"encryption is finished"};
+        State->Filter.Put(b.data(), b.size());
+        return State->output();
+    }
+    
+    bytes encryptor::finalize() {
+        if (State == nullptr) throw std::logic_error{"encryption is finished"};
+        State->Filter.MessageEnd();
+        bytes b = State->output();
+        b.resize(b.size() + MACSize);
+        State->MAC.Final(b.data() + b.size() - MACSize);
+        State.reset();
+        return b;
+    }
+    
+    struct decryptor::state {
+        CryptoPP::CBC_Mode<CryptoPP::AES>::Decryption Cipher;
+        CryptoPP::StreamTransformationFilter Filter;
+        CryptoPP::HMAC<CryptoPP::SHA256> MAC;
+        
+        state(const keys& k) :
+            Cipher{k.Encryption.data(), k.Encryption.size(), k.IV.data()},
+            Filter{Cipher, nullptr, CryptoPP::StreamTransformationFilter::PKCS_PADDING},
+            MAC{k.Authentication.data(), k.Authentication.size()} {}
+    };
+    
+    decryptor::decryptor(size_t header_size, size_t unauthenticated) :
+        State{}, HeaderSize{header_size}, Unauthenticated{unauthenticated}, Header{}, Tail{} {
+        Header.reserve(HeaderSize);
+        Tail.reserve(MACSize);
+    }
+    
+    decryptor::decryptor(decryptor&&) = default;
+    decryptor& decryptor::operator=(decryptor&&) = default;
+    decryptor::~decryptor() = default;
+    
+    bytes decryptor::feed(bytes_view b) {
+        State->MAC.Update(b.data(), b.size());
+        State->Filter.Put(b.data(), b.size());
+        return retrieve(State->Filter);
+    }
+    
+    bytes decryptor::update(bytes_view b) {
+        if (State == nullptr) {
+            size_t n = std::min(HeaderSize - Header.size(), b.size());
+            append(Header, b.substr(0, n));
+            b = b.substr(n);
+            if (Header.size() < HeaderSize) return {};
+            
+            State = std::make_unique<state>(derive(Header));
+            State->MAC.Update(Header.data() + Unauthenticated, HeaderSize - Unauthenticated);
+        }
+        
+        // the last bytes are held back because they may be the MAC. 
+        if (Tail.size() + b.size() <= MACSize) {
+            append(Tail, b);
+            return {};
+        }
+        
+        size_t release = Tail.size() + b.size() - MACSize;
+        size_t from_tail = std::min(release, Tail.size());
+        bytes out = feed(bytes_view{Tail.data(), from_tail});
+        append(out, feed(b.substr(0, release - from_tail)));
+        
+        Tail.erase(Tail.begin(), Tail.begin() + from_tail);
+        append(Tail, b.substr(release - from_tail));
+        return out;
+    }
+    
+    bytes decryptor::finalize() {
+        if (State == nullptr || Tail.size() != MACSize) throw std::invalid_argument{"ECIES message is too short"};
+        
+        byte mac[MACSize];
+        State->MAC.Final(mac);
+        if (!CryptoPP::VerifyBufsEqual(mac, Tail.data(), MACSize)) throw std::invalid_argument{"ECIES message is not authentic"};
+        
+        try {
+            State->Filter.MessageEnd();
+        } catch (const CryptoPP::Exception&) {
+            throw std::invalid_argument{"ECIES message has invalid padding"};
+        }
+        
+        bytes b = retrieve(State->Filter);
+        State.reset();
+        return b;
+    }
+    
+    secp256k1::secret ephemeral() {
+        bitcoind_random random{};
+        bytes b(secp256k1::secret::Size);
+        secp256k1::secret s{};
+        do {
+            random.get(b.data(), b.size());
+            std::copy(b.begin(), b.end(), s.Value.begin());
+        } while (!s.valid());
+        return s;
+    }
+
+}
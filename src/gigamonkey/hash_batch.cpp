@@ -0,0 +1,260 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include <gigamonkey/hash.hpp>
+#include <utility>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define GIGAMONKEY_HASH_AVX2
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define GIGAMONKEY_ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define GIGAMONKEY_ALWAYS_INLINE inline
+#endif
+
+namespace Gigamonkey::Bitcoin {
+    
+    namespace {
+        
+        // Eight messages are hashed together. Every array below is indexed 
+        // by word and then by lane, so each step is a loop over the lanes 
+        // which the compiler turns into vector instructions. 
+        constexpr size_t Lanes = 8;
+        
+        // the longest message which fits in one SHA-256 block with its padding. 
+        constexpr size_t MaxSingleBlock = 55;
+        
+        constexpr uint32 SHA256Init[8] = {
+            0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+        
+        constexpr uint32 SHA256K[64] = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+        
+        constexpr uint32 RIPEMD160Init[5] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0};
+        
+        // the word of the message, the rotation and the constant for each step 
+        // of the left and right lines. 
+        constexpr byte RIPEMD160Left[80] = {
+            0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+            7, 4, 13, 1, 10, 6, 15, 3, 12, 0, 9, 5, 2, 14, 11, 8,
+            3, 10, 14, 4, 9, 15, 8, 1, 2, 7, 0, 6, 13, 11, 5, 12,
+            1, 9, 11, 10, 0, 8, 12, 4, 13, 3, 7, 15, 14, 5, 6, 2,
+            4, 0, 5, 9, 7, 12, 2, 10, 14, 1, 3, 8, 11, 6, 15, 13};
+        
+        constexpr byte RIPEMD160Right[80] = {
+            5, 14, 7, 0, 9, 2, 11, 4, 13, 6, 15, 8, 1, 10, 3, 12,
+            6, 11, 3, 7, 0, 13, 5, 10, 14, 15, 8, 12, 4, 9, 1, 2,
+            15, 5, 1, 3, 7, 14, 6, 9, 11, 8, 12, 2, 10, 0, 4, 13,
+            8, 6, 4, 1, 3, 11, 15, 0, 5, 12, 2, 13, 9, 7, 10, 14,
+            12, 15, 10, 4, 1, 5, 8, 7, 6, 2, 13, 14, 0, 3, 9, 11};
+        
+        constexpr byte RIPEMD160LeftRotation[80] = {
+            11, 14, 15, 12, 5, 8, 7, 9, 11, 13, 14, 15, 6, 7, 9, 8,
+            7, 6, 8, 13, 11, 9, 7, 15, 7, 12, 15, 9, 11, 7, 13, 12,
+            11, 13, 6, 7, 14, 9, 13, 15, 14, 8, 13, 6, 5, 12, 7, 5,
+            11, 12, 14, 15, 14, 15, 9, 8, 9, 14, 5, 6, 8, 6, 5, 12,
+            9, 15, 5, 11, 6, 8, 13, 12, 5, 12, 13, 14, 11, 8, 5, 6};
+        
+        constexpr byte RIPEMD160RightRotation[80] = {
+            8, 9, 9, 11, 13, 15, 15, 5, 7, 7, 8, 11, 14, 14, 12, 6,
+            9, 13, 15, 7, 12, 8, 9, 11, 7, 7, 12, 7, 6, 15, 13, 11,
+            9, 7, 15, 11, 8, 6, 6, 14, 12, 13, 5, 14, 13, 13, 7, 5,
+            15, 5, 8, 11, 14, 14, 6, 14, 6, 9, 12, 9, 12, 5, 15, 8,
+            8, 5, 12, 9, 12, 5, 14, 6, 8, 13, 6, 5, 15, 13, 11, 11};
+        
+        constexpr uint32 RIPEMD160LeftK[5] = {0x00000000, 0x5a827999, 0x6ed9eba1, 0x8f1bbcdc, 0xa953fd4e};
+        constexpr uint32 RIPEMD160RightK[5] = {0x50a28be6, 0x5c4dd124, 0x6d703ef3, 0x7a6d76e9, 0x00000000};
+        
+        GIGAMONKEY_ALWAYS_INLINE uint32 rotr(uint32 x, int n) {
+            return (x >> n) | (x << (32 - n));
+        }
+        
+        GIGAMONKEY_ALWAYS_INLINE uint32 rotl(uint32 x, int n) {
+            return (x << n) | (x >> (32 - n));
+        }
+        
+        using lane = uint32[Lanes];
+        
+        // one step of SHA-256, which changes only d and h. 
+        GIGAMONKEY_ALWAYS_INLINE void sha256_step(const lane& a, const lane& b, const lane& c, lane& d,
+            const lane& e, const lane& f, const lane& g, lane& h, uint32 k, const lane& w) {
+            for (size_t l = 0; l < Lanes; l++) {
+                uint32 t1 = h[l] + (rotr(e[l], 6) ^ rotr(e[l], 11) ^ rotr(e[l], 25)) + ((e[l] & f[l]) ^ (~e[l] & g[l])) + k + w[l];
+                uint32 t2 = (rotr(a[l], 2) ^ rotr(a[l], 13) ^ rotr(a[l], 22)) + ((a[l] & b[l]) ^ (a[l] & c[l]) ^ (b[l] & c[l]));
+                d[l] += t1;
+                h[l] = t1 + t2;
+            }
+        }
+        
+        // the five functions of RIPEMD-160. 
+        GIGAMONKEY_ALWAYS_INLINE uint32 ripemd160_f(int round, uint32 x, uint32 y, uint32 z) {
+            switch (round) {
+                case 0: return x ^ y ^ z;
+                case 1: return (x & y) | (~x & z);
+                case 2: return (x | ~y) ^ z;
+                case 3: return (x & z) | (y & ~z);
+                default: return x ^ (y | ~z);
+            }
+        }
+        
+        // step j of one line of RIPEMD-160, which changes only a and c. Every 
+        // step is a separate function so that the word, the rotation and the 
+        // names of the variables are known when it is compiled. 
+        template <size_t j, bool right>
+        GIGAMONKEY_ALWAYS_INLINE void ripemd160_step(lane (&v)[5], const lane (&x)[16]) {
+            // the right line uses the functions in reverse order. 
+            constexpr int round = right ? 4 - j / 16 : j / 16;
+            constexpr uint32 k = right ? RIPEMD160RightK[j / 16] : RIPEMD160LeftK[j / 16];
+            constexpr int word = right ? RIPEMD160Right[j] : RIPEMD160Left[j];
+            constexpr int rotation = right ? RIPEMD160RightRotation[j] : RIPEMD160LeftRotation[j];
+            
+            lane& a = v[(5 - j % 5) % 5];
+            const lane& b = v[(6 - j % 5) % 5];
+            lane& c = v[(7 - j % 5) % 5];
+            const lane& d = v[(8 - j % 5) % 5];
+            const lane& e = v[(9 - j % 5) % 5];
+            for (size_t l = 0; l < Lanes; l++) {
+                a[l] = rotl(a[l] + ripemd160_f(round, b[l], c[l], d[l]) + x[word][l] + k, rotation) + e[l];
+                c[l] = rotl(c[l], 10);
+            }
+        }
+        
+        template <bool right, size_t... j>
+        GIGAMONKEY_ALWAYS_INLINE void ripemd160_line(lane (&v)[5], const lane (&x)[16], std::index_sequence<j...>) {
+            (ripemd160_step<j, right>(v, x), ...);
+        }
+        
+        // hash160 of Lanes messages which are each no longer than MaxSingleBlock. 
+        GIGAMONKEY_ALWAYS_INLINE void hash160_lanes(const bytes_view* in, digest160* out) {
+            
+            // SHA-256 of a single padded block. 
+            lane w[64];
+            for (size_t l = 0; l < Lanes; l++) {
+                byte block[64] = {};
+                std::copy(in[l].begin(), in[l].end(), block);
+                block[in[l].size()] = 0x80;
+                uint64 bits = uint64(in[l].size()) * 8;
+                for (int i = 0; i < 8; i++) block[63 - i] = byte(bits >> (8 * i));
+                for (int i = 0; i < 16; i++) w[i][l] =
+                    (uint32(block[4 * i]) << 24) | (uint32(block[4 * i + 1]) << 16) |
+                    (uint32(block[4 * i + 2]) << 8) | uint32(block[4 * i + 3]);
+            }
+            
+            for (int i = 16; i < 64; i++) for (size_t l = 0; l < Lanes; l++) {
+                uint32 s0 = rotr(w[i - 15][l], 7) ^ rotr(w[i - 15][l], 18) ^ (w[i - 15][l] >> 3);
+                uint32 s1 = rotr(w[i - 2][l], 17) ^ rotr(w[i - 2][l], 19) ^ (w[i - 2][l] >> 10);
+                w[i][l] = w[i - 16][l] + s0 + w[i - 7][l] + s1;
+            }
+            
+            lane s[8];
+            for (int j = 0; j < 8; j++) for (size_t l = 0; l < Lanes; l++) s[j][l] = SHA256Init[j];
+            
+            // the variables are renamed instead of moved after every step. 
+            for (int i = 0; i < 64; i += 8) {
+                sha256_step(s[0], s[1], s[2], s[3], s[4], s[5], s[6], s[7], SHA256K[i], w[i]);
+                sha256_step(s[7], s[0], s[1], s[2], s[3], s[4], s[5], s[6], SHA256K[i + 1], w[i + 1]);
+                sha256_step(s[6], s[7], s[0], s[1], s[2], s[3], s[4], s[5], SHA256K[i + 2], w[i + 2]);
+                sha256_step(s[5], s[6], s[7], s[0], s[1], s[2], s[3], s[4], SHA256K[i + 3], w[i + 3]);
+                sha256_step(s[4], s[5], s[6], s[7], s[0], s[1], s[2], s[3], SHA256K[i + 4], w[i + 4]);
+                sha256_step(s[3], s[4], s[5], s[6], s[7], s[0], s[1], s[2], SHA256K[i + 5], w[i + 5]);
+                sha256_step(s[2], s[3], s[4], s[5], s[6], s[7], s[0], s[1], SHA256K[i + 6], w[i + 6]);
+                sha256_step(s[1], s[2], s[3], s[4], s[5], s[6], s[7], s[0], SHA256K[i + 7], w[i + 7]);
+            }
+            
+            // RIPEMD-160 of the 32 byte digest, which is also a single block. 
+            // SHA-256 is big endian and RIPEMD-160 is little endian. 
+            lane x[16];
+            for (size_t l = 0; l < Lanes; l++) {
+                for (int j = 0; j < 8; j++) {
+                    uint32 v = s[j][l] + SHA256Init[j];
+                    x[j][l] = (v >> 24) | ((v >> 8) & 0xff00) | ((v << 8) & 0xff0000) | (v << 24);
+                }
+                
+                x[8][l] = 0x80;
+                for (int j = 9; j < 14; j++) x[j][l] = 0;
+                x[14][l] = 256;
+                x[15][l] = 0;
+            }
+            
+            lane left[5];
+            lane right[5];
+            for (int j = 0; j < 5; j++) for (size_t l = 0; l < Lanes; l++) left[j][l] = right[j][l] = RIPEMD160Init[j];
+            
+            ripemd160_line<false>(left, x, std::make_index_sequence<80>{});
+            ripemd160_line<true>(right, x, std::make_index_sequence<80>{});
+            
+            for (size_t l = 0; l < Lanes; l++) {
+                uint32 h[5] = {
+                    RIPEMD160Init[1] + left[2][l] + right[3][l],
+                    RIPEMD160Init[2] + left[3][l] + right[4][l],
+                    RIPEMD160Init[3] + left[4][l] + right[0][l],
+                    RIPEMD160Init[4] + left[0][l] + right[1][l],
+                    RIPEMD160Init[0] + left[1][l] + right[2][l]};
+                
+                byte* o = out[l].begin();
+                for (int j = 0; j < 5; j++) for (int k = 0; k < 4; k++) o[4 * j + k] = byte(h[j] >> (8 * k));
+            }
+        }
+        
+        using kernel = void (*)(const bytes_view*, digest160*);
+        
+        void hash160_generic(const bytes_view* in, digest160* out) {
+            hash160_lanes(in, out);
+        }
+
+#ifdef GIGAMONKEY_HASH_AVX2
+        // the same code compiled for eight lanes in one register. 
+        __attribute__((target("avx2"))) void hash160_avx2(const bytes_view* in, digest160* out) {
+            hash160_lanes(in, out);
+        }
+#endif
+        
+        kernel select_kernel() {
+#ifdef GIGAMONKEY_HASH_AVX2
+            if (__builtin_cpu_supports("avx2")) return hash160_avx2;
+#endif
+            return hash160_generic;
+        }
+        
+    }
+    
+    void hash160_batch(const bytes_view* in, digest160* out, size_t size) {
+        static const kernel Kernel = select_kernel();
+        
+        bytes_view group[Lanes];
+        size_t index[Lanes];
+        digest160 digests[Lanes];
+        size_t n = 0;
+        
+        auto run = [&]() {
+            // empty lanes are filled with the first message. 
+            for (size_t l = n; l < Lanes; l++) group[l] = group[0];
+            Kernel(group, digests);
+            for (size_t l = 0; l < n; l++) out[index[l]] = digests[l];
+            n = 0;
+        };
+        
+        for (size_t i = 0; i < size; i++) {
+            if (in[i].size() > MaxSingleBlock) {
+                out[i] = hash160(in[i]);
+                continue;
+            }
+            
+            group[n] = in[i];
+            index[n] = i;
+            if (++n == Lanes) run();
+        }
+        
+        if (n > 0) run();
+    }
+
+}
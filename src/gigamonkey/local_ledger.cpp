@@ -0,0 +1,371 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include <gigamonkey/local_ledger.hpp>
+#include <gigamonkey/merkle/server.hpp>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <limits>
+#include <stdexcept>
+
+namespace Gigamonkey::Bitcoin {
+    
+    namespace {
+        
+        std::string segment_name(const std::string& directory, uint32 index) {
+            char name[32];
+            std::snprintf(name, sizeof(name), "/segment.%06u", index);
+            return directory + name;
+        }
+        
+        void write_uint32(byte* b, uint32 x) {
+            for (int i = 0; i < 4; i++) b[i] = byte(x >> (8 * i));
+        }
+        
+        uint32 read_uint32(const byte* b) {
+            uint32 x = 0;
+            for (int i = 0; i < 4; i++) x |= uint32(b[i]) << (8 * i);
+            return x;
+        }
+        
+        digest256 read_digest(const byte* b) {
+            digest256 d;
+            std::copy(b, b + 32, d.begin());
+            return d;
+        }
+        
+    }
+    
+    local_ledger::local_ledger(const std::string& directory, size_t segment_size) : 
+        Directory{directory}, 
+        SegmentSize{std::min(segment_size, size_t(std::numeric_limits<uint32>::max()))}, 
+        Segments{}, Mutex{}, Transactions{}, Proofs{}, Blocks{}, Headers{}, ByHash{}, ByRoot{} {
+        if (::mkdir(Directory.c_str(), 0755) != 0 && errno != EEXIST) 
+            throw std::runtime_error{"could not create directory " + Directory};
+        
+        std::lock_guard<std::mutex> lock{Mutex};
+        uint32 i = 0;
+        do {
+            if (!open(i++)) throw std::runtime_error{"could not open ledger in " + Directory};
+        } while (::access(segment_name(Directory, i).c_str(), F_OK) == 0);
+    }
+    
+    local_ledger::~local_ledger() {
+        flush();
+        for (const std::unique_ptr<segment>& s : Segments) {
+            ::munmap(s->Data, s->Size);
+            ::close(s->File);
+        }
+    }
+    
+    bool local_ledger::open(uint32 segment_index) {
+        int file = ::open(segment_name(Directory, segment_index).c_str(), O_RDWR | O_CREAT, 0644);
+        if (file < 0) return false;
+        
+        struct stat st;
+        if (::fstat(file, &st) != 0) {
+            ::close(file);
+            return false;
+        }
+        
+        // new segments are filled with zeros, which mark where the records end. 
+        size_t size = size_t(st.st_size);
+        if (size < SegmentSize) {
+            if (::ftruncate(file, SegmentSize) != 0) {
+                ::close(file);
+                return false;
+            }
+            size = SegmentSize;
+        }
+        
+        void* data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+        if (data == MAP_FAILED) {
+            ::close(file);
+            return false;
+        }
+        
+        Segments.push_back(std::unique_ptr<segment>{new segment{file, static_cast<byte*>(data), size, 0}});
+        segment& s = *Segments.back();
+        
+        while (s.Used + RecordHeaderSize <= s.Size) {
+            byte k = s.Data[s.Used];
+            if (k == none || k > block_record) break;
+            uint32 length = read_uint32(s.Data + s.Used + 1);
+            if (s.Used + RecordHeaderSize + length > s.Size) break;
+            index(kind(k), location{segment_index, uint32(s.Used + RecordHeaderSize), length});
+            s.Used += RecordHeaderSize + length;
+        }
+        
+        return true;
+    }
+    
+    bool local_ledger::append(kind k, std::initializer_list<bytes_view> parts, location& l) {
+        size_t length = 0;
+        for (bytes_view b : parts) length += b.size();
+        if (RecordHeaderSize + length > SegmentSize) return false;
+        
+        if (Segments.back()->Used + RecordHeaderSize + length > Segments.back()->Size && !open(Segments.size())) return false;
+        
+        segment& s = *Segments.back();
+        byte* b = s.Data + s.Used;
+        write_uint32(b + 1, length);
+        byte* x = b + RecordHeaderSize;
+        for (bytes_view part : parts) x = std::copy(part.begin(), part.end(), x);
+        
+        // the kind is written last so that a record which was 
+        // cut off is not read when the ledger is opened again. 
+        b[0] = k;
+        
+        l = location{uint32(Segments.size() - 1), uint32(s.Used + RecordHeaderSize), uint32(length)};
+        s.Used += RecordHeaderSize + length;
+        return true;
+    }
+    
+    void local_ledger::index(kind k, const location& l) {
+        bytes_view b = read(l);
+        switch (k) {
+            case transaction_record : {
+                Transactions.emplace(Bitcoin::transaction::id(b), l);
+                return;
+            }
+            case header_record : {
+                if (b.size() != 80) return;
+                Bitcoin::header h = Bitcoin::header::read(slice<80>(const_cast<byte*>(b.data())));
+                digest256 hash = h.hash();
+                work::difficulty cumulative = Headers.empty() ? h.Target.difficulty() : Headers.back().Cumulative + h.Target.difficulty();
+                ByHash[hash] = Headers.size();
+                ByRoot[h.MerkleRoot] = Headers.size();
+                Headers.push_back(stored_header{hash, h, cumulative});
+                return;
+            }
+            case proof_record : {
+                if (b.size() < 68) return;
+                Proofs.insert_or_assign(read_digest(b.data()), l);
+                return;
+            }
+            case block_record : {
+                if (b.size() < 32) return;
+                Blocks.insert_or_assign(read_digest(b.data()), l);
+                return;
+            }
+            default : return;
+        }
+    }
+    
+    bytes_view local_ledger::read(const location& l) const {
+        return bytes_view{Segments[l.Segment]->Data + l.Offset, l.Length};
+    }
+    
+    const local_ledger::stored_header* local_ledger::find_header(const digest256& d) const {
+        auto it = ByHash.find(d);
+        if (it != ByHash.end()) return &Headers[it->second];
+        it = ByRoot.find(d);
+        if (it != ByRoot.end()) return &Headers[it->second];
+        return nullptr;
+    }
+    
+    ledger::block_header local_ledger::make_header(uint32 height) const {
+        const stored_header& h = Headers[height];
+        return block_header{h.Hash, h.Header, N{uint64(height)}, h.Cumulative};
+    }
+    
+    // a txid, a block hash, an index and then the digests of the branch. 
+    Merkle::proof local_ledger::make_proof(const location& l, Bitcoin::header& h) const {
+        bytes_view b = read(l);
+        const stored_header* x = find_header(read_digest(b.data() + 32));
+        if (x == nullptr) return {};
+        h = x->Header;
+        
+        std::vector<digest256> path;
+        for (size_t i = 68; i + 32 <= b.size(); i += 32) path.push_back(read_digest(b.data() + i));
+        
+        Merkle::digests digests{};
+        for (auto it = path.rbegin(); it != path.rend(); it++) digests = digests << *it;
+        
+        return Merkle::proof{Merkle::branch{Merkle::leaf{read_digest(b.data()), read_uint32(b.data() + 64)}, digests}, h.MerkleRoot};
+    }
+    
+    bool local_ledger::insert_transaction(bytes_view tx) {
+        if (!transaction_view{tx}.valid()) return false;
+        txid id = Bitcoin::transaction::id(tx);
+        if (Transactions.find(id) != Transactions.end()) return false;
+        
+        location l;
+        if (!append(transaction_record, {tx}, l)) return false;
+        Transactions.emplace(id, l);
+        return true;
+    }
+    
+    bool local_ledger::insert_header(const Bitcoin::header& h) {
+        if (!h.valid() || ByHash.find(h.hash()) != ByHash.end()) return false;
+        if (!Headers.empty() && h.Previous != Headers.back().Hash) return false;
+        
+        uint<80> w = h.write();
+        location l;
+        if (!append(header_record, {bytes_view{w.data(), w.size()}}, l)) return false;
+        index(header_record, l);
+        return true;
+    }
+    
+    bool local_ledger::insert_proof(const Merkle::proof& p) {
+        if (!p.valid()) return false;
+        auto it = ByRoot.find(p.Root);
+        if (it == ByRoot.end()) return false;
+        
+        bytes b(68 + 32 * p.Branch.Digests.size());
+        std::copy(p.Branch.Leaf.Digest.begin(), p.Branch.Leaf.Digest.end(), b.begin());
+        std::copy(Headers[it->second].Hash.begin(), Headers[it->second].Hash.end(), b.begin() + 32);
+        write_uint32(b.data() + 64, p.Branch.Leaf.Index);
+        auto x = b.begin() + 68;
+        for (const digest256& d : p.Branch.Digests) x = std::copy(d.begin(), d.end(), x);
+        
+        location l;
+        if (!append(proof_record, {b}, l)) return false;
+        index(proof_record, l);
+        return true;
+    }
+    
+    bool local_ledger::add_transaction(bytes_view tx) {
+        std::lock_guard<std::mutex> lock{Mutex};
+        return insert_transaction(tx);
+    }
+    
+    bool local_ledger::add_header(const Bitcoin::header& h) {
+        std::lock_guard<std::mutex> lock{Mutex};
+        return insert_header(h);
+    }
+    
+    bool local_ledger::add_proof(const Merkle::proof& p) {
+        std::lock_guard<std::mutex> lock{Mutex};
+        return insert_proof(p);
+    }
+    
+    bool local_ledger::add_block(bytes_view b) {
+        if (!Bitcoin::block::valid(b)) return false;
+        
+        Bitcoin::header h = Bitcoin::header::read(Bitcoin::block::header(b));
+        std::vector<bytes_view> txs = Bitcoin::block::transactions(b);
+        
+        std::vector<txid> ids;
+        ids.reserve(txs.size());
+        Merkle::leaf_digests leaves{};
+        for (bytes_view tx : txs) {
+            ids.push_back(Bitcoin::transaction::id(tx));
+            leaves = leaves << ids.back();
+        }
+        
+        Merkle::server tree{leaves};
+        if (tree.root() != h.MerkleRoot) return false;
+        
+        std::lock_guard<std::mutex> lock{Mutex};
+        digest256 hash = h.hash();
+        if (ByHash.find(hash) == ByHash.end() && !insert_header(h)) return false;
+        
+        for (bytes_view tx : txs) insert_transaction(tx);
+        for (const Merkle::proof& p : tree.proofs()) if (!insert_proof(p)) return false;
+        
+        bytes record(32 * (ids.size() + 1));
+        auto x = std::copy(hash.begin(), hash.end(), record.begin());
+        for (const txid& id : ids) x = std::copy(id.begin(), id.end(), x);
+        
+        location l;
+        if (!append(block_record, {record}, l)) return false;
+        index(block_record, l);
+        return true;
+    }
+    
+    bytes_view local_ledger::view(const txid& id) const {
+        std::lock_guard<std::mutex> lock{Mutex};
+        auto it = Transactions.find(id);
+        if (it == Transactions.end()) return {};
+        return read(it->second);
+    }
+    
+    list<ledger::block_header> local_ledger::headers(uint64 since_height) {
+        std::lock_guard<std::mutex> lock{Mutex};
+        list<block_header> x{};
+        for (uint64 i = since_height; i < Headers.size(); i++) x = x << make_header(i);
+        return x;
+    }
+    
+    data::entry<txid, ledger::double_entry> local_ledger::transaction(const txid& id) const {
+        std::lock_guard<std::mutex> lock{Mutex};
+        return find_transaction(id);
+    }
+    
+    std::vector<data::entry<txid, ledger::double_entry>> local_ledger::transactions(const std::vector<txid>& ids) const {
+        std::vector<data::entry<txid, double_entry>> x;
+        x.reserve(ids.size());
+        std::lock_guard<std::mutex> lock{Mutex};
+        for (const txid& id : ids) x.push_back(find_transaction(id));
+        return x;
+    }
+    
+    data::entry<txid, ledger::double_entry> local_ledger::find_transaction(const txid& id) const {
+        auto it = Transactions.find(id);
+        if (it == Transactions.end()) return data::entry<txid, double_entry>{id, double_entry{}};
+        
+        ptr<bytes> tx = std::make_shared<bytes>(read(it->second));
+        
+        auto p = Proofs.find(id);
+        if (p == Proofs.end()) return data::entry<txid, double_entry>{id, double_entry{tx}};
+        
+        Bitcoin::header h;
+        Merkle::proof proof = make_proof(p->second, h);
+        return data::entry<txid, double_entry>{id, double_entry{tx, proof, h}};
+    }
+    
+    ledger::block_header local_ledger::header(const digest256& d) const {
+        std::lock_guard<std::mutex> lock{Mutex};
+        const stored_header* h = find_header(d);
+        if (h == nullptr) return {};
+        return make_header(h - Headers.data());
+    }
+    
+    bytes local_ledger::block(const digest256& d) const {
+        std::lock_guard<std::mutex> lock{Mutex};
+        const stored_header* h = find_header(d);
+        if (h == nullptr) return {};
+        
+        auto it = Blocks.find(h->Hash);
+        if (it == Blocks.end()) return {};
+        
+        bytes_view record = read(it->second);
+        std::vector<bytes_view> txs;
+        size_t size = 80;
+        for (size_t i = 32; i + 32 <= record.size(); i += 32) {
+            auto t = Transactions.find(read_digest(record.data() + i));
+            if (t == Transactions.end()) return {};
+            txs.push_back(read(t->second));
+            size += txs.back().size();
+        }
+        
+        size += writer::var_int_size(txs.size());
+        bytes b(size);
+        uint<80> w = h->Header.write();
+        bytes_writer x{b.begin(), b.end()};
+        x = writer::write_var_int(x << bytes_view{w.data(), w.size()}, txs.size());
+        for (bytes_view tx : txs) x = x << tx;
+        return b;
+    }
+    
+    size_t local_ledger::size() const {
+        std::lock_guard<std::mutex> lock{Mutex};
+        return Transactions.size();
+    }
+    
+    uint64 local_ledger::height() const {
+        std::lock_guard<std::mutex> lock{Mutex};
+        return Headers.size();
+    }
+    
+    void local_ledger::flush() const {
+        std::lock_guard<std::mutex> lock{Mutex};
+        for (const std::unique_ptr<segment>& s : Segments) ::msync(s->Data, s->Used, MS_SYNC);
+    }
+    
+}
@@ -0,0 +1,158 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include <gigamonkey/parallel.hpp>
+
+namespace Gigamonkey {
+    
+    namespace {
+        // whether this thread is running a loop for some pool. 
+        thread_local bool InPool = false;
+        
+        struct in_pool {
+            bool Was;
+            in_pool() : Was{InPool} {
+                InPool = true;
+            }
+            
+            ~in_pool() {
+                InPool = Was;
+            }
+        };
+    }
+    
+    work_stealing_pool::work_stealing_pool(uint32 threads) : 
+        Shares(threads == 0 ? 1 : threads), Workers{}, Job{nullptr}, Generation{0}, Working{0}, Stop{false} {
+        for (uint32 i = 1; i < Shares.size(); i++) Workers.emplace_back([this, i]() {
+            work(i);
+        });
+    }
+    
+    work_stealing_pool::~work_stealing_pool() {
+        {
+            std::lock_guard<std::mutex> lock{Mutex};
+            Stop = true;
+        }
+        
+        Start.notify_all();
+        for (std::thread& t : Workers) t.join();
+    }
+    
+    work_stealing_pool& work_stealing_pool::common() {
+        static work_stealing_pool Pool{};
+        return Pool;
+    }
+    
+    void work_stealing_pool::run(size_t n, const std::function<void(size_t)>& f) {
+        if (n == 0) return;
+        
+        // waiting for the workers from inside a loop would deadlock. 
+        if (InPool) {
+            for (size_t i = 0; i < n; i++) f(i);
+            return;
+        }
+        
+        in_pool inside{};
+        std::lock_guard<std::mutex> running{Running};
+        
+        uint32 threads = Shares.size();
+        for (uint32 i = 0; i < threads; i++) {
+            std::lock_guard<std::mutex> lock{Shares[i].Mutex};
+            Shares[i].Begin = n * i / threads;
+            Shares[i].End = n * (i + 1) / threads;
+        }
+        
+        {
+            std::lock_guard<std::mutex> lock{Mutex};
+            Job = &f;
+            Working = threads - 1;
+            Generation++;
+        }
+        
+        Start.notify_all();
+        
+        size_t i;
+        while (next(0, i)) f(i);
+        
+        std::unique_lock<std::mutex> lock{Mutex};
+        Done.wait(lock, [this]() {
+            return Working == 0;
+        });
+        
+        Job = nullptr;
+    }
+    
+    void work_stealing_pool::work(uint32 thread) {
+        InPool = true;
+        uint64 generation = 0;
+        while (true) {
+            const std::function<void(size_t)>* job;
+            {
+                std::unique_lock<std::mutex> lock{Mutex};
+                Start.wait(lock, [this, generation]() {
+                    return Stop || Generation != generation;
+                });
+                
+                if (Stop) return;
+                generation = Generation;
+                job = Job;
+            }
+            
+            size_t i;
+            while (next(thread, i)) (*job)(i);
+            
+            std::lock_guard<std::mutex> lock{Mutex};
+            if (--Working == 0) Done.notify_one();
+        }
+    }
+    
+    bool work_stealing_pool::next(uint32 thread, size_t& i) {
+        share& mine = Shares[thread];
+        {
+            std::lock_guard<std::mutex> lock{mine.Mutex};
+            if (mine.Begin < mine.End) {
+                i = mine.Begin++;
+                return true;
+            }
+        }
+        
+        while (true) {
+            uint32 victim = thread;
+            size_t most = 0;
+            for (uint32 j = 0; j < Shares.size(); j++) {
+                if (j == thread) continue;
+                std::lock_guard<std::mutex> lock{Shares[j].Mutex};
+                size_t left = Shares[j].End - Shares[j].Begin;
+                if (left > most) {
+                    most = left;
+                    victim = j;
+                }
+            }
+            
+            // items being moved by another thief belong to that thief, 
+            // so if every share is empty then there is nothing left to take. 
+            if (most == 0) return false;
+            
+            size_t begin;
+            size_t end;
+            {
+                std::lock_guard<std::mutex> lock{Shares[victim].Mutex};
+                share& v = Shares[victim];
+                if (v.End <= v.Begin) continue;
+                end = v.End;
+                begin = v.End - (v.End - v.Begin + 1) / 2;
+                v.End = begin;
+            }
+            
+            {
+                std::lock_guard<std::mutex> lock{mine.Mutex};
+                mine.Begin = begin + 1;
+                mine.End = end;
+            }
+            
+            i = begin;
+            return true;
+        }
+    }
+    
+}
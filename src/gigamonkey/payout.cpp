@@ -0,0 +1,203 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include <gigamonkey/payout.hpp>
+#include <gigamonkey/coin_selection.hpp>
+#include <atomic>
+#include <optional>
+
+namespace Gigamonkey::Bitcoin {
+    
+    namespace {
+        
+        // a transaction before it is built. 
+        struct planned {
+            // the range of payments. 
+            size_t First;
+            size_t Last;
+            
+            // size of the outputs, version and locktime, and 
+            // then of the whole transaction once inputs are chosen. 
+            size_t Size;
+            satoshi Sent;
+            
+            std::vector<const spendable*> Inputs;
+            satoshi Value;
+            satoshi Fee;
+            
+            std::optional<change> Change;
+            satoshi ChangeValue;
+            
+            planned(size_t first) : First{first}, Last{first}, Size{8}, Sent{0},
+                Inputs{}, Value{0}, Fee{0}, Change{}, ChangeValue{0} {}
+        };
+        
+        // payments first through last - 1 without any inputs. 
+        planned plan_payments(const std::vector<payment>& payments, size_t first, size_t last) {
+            planned b{first};
+            for (; b.Last < last; b.Last++) {
+                b.Size += estimate::output_size(payments[b.Last].Script.size());
+                b.Sent = b.Sent + payments[b.Last].Value;
+            }
+            return b;
+        }
+        
+        // an input that is waiting to be signed. 
+        struct signing {
+            uint32 Batch;
+            uint32 Input;
+            const spendable* Spent;
+            redemption::incomplete Script;
+        };
+        
+    }
+    
+    payout::result payout::pay(const std::vector<payment>& payments, const funds& f, ptr<keysource>& keys, work_stealing_pool& pool) const {
+        if (Change == nullptr || keys == nullptr || payments.size() == 0 || MaxSize < 100) return {};
+        
+        // split up the payments. Room is left for a change output, 
+        // which is not likely to be larger than a pay to pubkey. 
+        size_t limit = MaxSize - MaxSize / 10 - estimate::output_size(estimate::pay_to_pubkey_script_size(true));
+        std::vector<planned> plan{planned{0}};
+        for (size_t i = 0; i < payments.size(); i++) {
+            const payment& p = payments[i];
+            if (p.Value < Dust) return {};
+            
+            size_t size = estimate::output_size(p.Script.size());
+            planned* b = &plan.back();
+            if (b->Last > b->First &&
+                b->Size + size + writer::var_int_size(b->Last - b->First + 2) > limit)
+                b = &plan.emplace_back(i);
+            
+            b->Size += size;
+            b->Sent = b->Sent + p.Value;
+            b->Last++;
+            
+            if (b->Size + writer::var_int_size(2) > limit) return {};
+        }
+        
+        // outputs are taken from largest to smallest, leaving 
+        // out any that would cost more to spend than they are worth. 
+        std::vector<const spendable*> candidates;
+        candidates.reserve(f.Entries.size());
+        f.Entries.by_value([this, &candidates](const spendable& s) {
+            if (s.Redeemer == nullptr) return;
+            if (int64(s.Value) > int64(Fee.calculate(coin_selection::input_size(s), s.Redeemer->sigops())))
+                candidates.push_back(&s);
+        });
+        
+        // change is not made until every transaction is planned, 
+        // so keys are only taken for change that is really made. 
+        size_t change_size = estimate::output_size(Change->expected_size());
+        size_t next = 0;
+        result r{};
+        for (size_t k = 0; k < plan.size();) {
+            planned& b = plan[k];
+            size_t outputs = b.Last - b.First;
+            size_t size = b.Size;
+            uint32 sigops = 0;
+            
+            auto required = [&](bool with_change) -> int64 {
+                return int64(b.Sent) + int64(Fee.calculate(size + writer::var_int_size(b.Inputs.size()) +
+                    (with_change ? change_size + writer::var_int_size(outputs + 1) : writer::var_int_size(outputs)), sigops));
+            };
+            
+            auto too_large = [&]() -> bool {
+                return size + writer::var_int_size(b.Inputs.size()) + writer::var_int_size(outputs) > MaxSize;
+            };
+            
+            while (int64(b.Value) < required(false) && !too_large()) {
+                if (next == candidates.size()) return {};
+                const spendable* x = candidates[next++];
+                size += coin_selection::input_size(*x);
+                sigops += x->Redeemer->sigops();
+                b.Inputs.push_back(x);
+                b.Value = b.Value + x->Value;
+            }
+            
+            // more inputs were needed than there was room for, so the inputs 
+            // are given back and the payments are split in two again. 
+            if (too_large()) {
+                if (outputs < 2) return {};
+                next -= b.Inputs.size();
+                size_t middle = b.First + outputs / 2;
+                planned rest = plan_payments(payments, middle, b.Last);
+                b = plan_payments(payments, b.First, middle);
+                plan.insert(plan.begin() + k + 1, std::move(rest));
+                continue;
+            }
+            
+            int64 left = int64(b.Value) - required(true);
+            bool with_change = left > 0 && left >= int64(Dust) && size + change_size + writer::var_int_size(b.Inputs.size()) +
+                writer::var_int_size(outputs + 1) <= MaxSize;
+            if (with_change) b.ChangeValue = satoshi{left};
+            
+            b.Size = size + writer::var_int_size(b.Inputs.size()) + 
+                (with_change ? change_size + writer::var_int_size(outputs + 1) : writer::var_int_size(outputs));
+            b.Fee = satoshi{int64(b.Value) - int64(b.Sent) - int64(b.ChangeValue)};
+            r.Fee = r.Fee + b.Fee;
+            k++;
+        }
+        
+        // the caller's keysource is only moved on if the payout is made. 
+        ptr<keysource> k = keys;
+        for (planned& b : plan) if (int64(b.ChangeValue) > 0) b.Change = Change->create_redeemable(k);
+        
+        // write the transactions with space reserved for the input scripts. 
+        std::vector<transaction_builder> builders(plan.size());
+        std::vector<signing> inputs;
+        for (uint32 i = 0; i < plan.size(); i++) {
+            const planned& b = plan[i];
+            transaction_builder& t = builders[i];
+            t.reserve(b.Size);
+            
+            for (const spendable* x : b.Inputs) {
+                redemption::incomplete script = x->Redeemer->redeem(Directive);
+                inputs.push_back(signing{i, t.add_input(x->Outpoint, redemption::expected_size(script), x->Sequence), x, script});
+            }
+            
+            for (size_t j = b.First; j < b.Last; j++) t.add_output(payments[j].Value, payments[j].Script);
+            if (b.Change) t.add_output(b.ChangeValue, b.Change->OutputScript);
+        }
+        
+        // the builders are only read while the signatures are made. 
+        std::vector<bytes> scripts(inputs.size());
+        std::atomic<bool> failed{false};
+        pool.run(inputs.size(), [&](size_t i) {
+            const signing& x = inputs[i];
+            try {
+                scripts[i] = redemption::redeem(x.Script, builders[x.Batch].incomplete(), x.Input, *x.Spent);
+            } catch (...) {
+                failed = true;
+            }
+        });
+        
+        if (failed) return {};
+        
+        for (size_t i = 0; i < inputs.size(); i++)
+            if (!builders[inputs[i].Batch].set_script(inputs[i].Input, scripts[i])) return {};
+        
+        std::vector<bytes> transactions(plan.size());
+        std::vector<txid> ids(plan.size());
+        pool.run(plan.size(), [&](size_t i) {
+            transactions[i] = builders[i].complete();
+            ids[i] = hash256(transactions[i]);
+        });
+        
+        r.Batches.reserve(plan.size());
+        for (uint32 i = 0; i < plan.size(); i++) r.Batches.push_back(batch{std::move(transactions[i]), ids[i], 
+            uint32(plan[i].Last - plan[i].First), plan[i].Fee, plan[i].ChangeValue});
+        
+        r.Remainder = f;
+        for (uint32 i = 0; i < plan.size(); i++) {
+            const planned& b = plan[i];
+            for (const spendable* x : b.Inputs) r.Remainder.remove(x->Outpoint);
+            if (b.Change) r.Remainder.add(spendable{output{b.ChangeValue, b.Change->OutputScript},
+                b.Change->Redeemer, outpoint{r.Batches[i].ID, r.Batches[i].Payments}});
+        }
+        
+        keys = k;
+        return r;
+    }
+
+}
@@ -1,14 +1,16 @@
 #include <gigamonkey/redeem.hpp>
+#include <gigamonkey/script/validation.hpp>
 
 namespace Gigamonkey::Bitcoin::redemption {
     
-    bytes redeem(incomplete x, bytes_view tx, index i, bool dummy_signature) {
+    bytes redeem(incomplete x, bytes_view tx, index i, const output& spent, bool dummy_signature) {
         list<bytes> parts{};
         uint32 size = 0;
         while(!x.empty()) {
-            bytes b = x.first().redeem(tx, i, dummy_signature);
+            bytes b = x.first().redeem(tx, i, spent, dummy_signature);
             size += b.size();
             parts = parts << b;
+            x = x.rest();
         }
         bytes b(size);
         bytes_writer w{b.begin(), b.end()};
@@ -41,34 +43,38 @@ namespace Gigamonkey::Bitcoin {
             return s + o.Value;
         }, 0, out);
         
-        if (spent > sent) return {};
+        if (spent < sent) return {};
+        
+        // space is reserved for each input script, which is written 
+        // in once the transaction has been signed. 
+        transaction_builder b{1, locktime};
+        list<redemption::incomplete> scripts;
+        for (const data::entry<spendable, sighash::directive>& entry : prev) {
+            redemption::incomplete x = entry.Key.Redeemer->redeem(entry.Value);
+            b.add_input(entry.Key.Outpoint, redemption::expected_size(x), entry.Key.Sequence);
+            scripts = scripts << x;
+        }
         
-        bytes incomplete = transaction{data::for_each([](data::entry<spendable, sighash::directive> s) -> input {
-            return input{s.Key.Outpoint, {}, s.Key.Sequence};
-        }, prev), out, locktime}.write();
+        for (const output& o : out) b.add_output(o.Value, o.Script);
         
         uint32 ind{0};
-        list<input> in;
-        list<data::entry<spendable, sighash::directive>> p = prev;
-        
-        while (!p.empty()) {
-            data::entry<spendable, sighash::directive> entry = p.first();
-            in = in << input{entry.Key.Outpoint, 
-                redemption::redeem(entry.Key.Redeemer->redeem(entry.Value), incomplete, ind++), 
-                entry.Key.Sequence};
+        for (const data::entry<spendable, sighash::directive>& entry : prev) {
+            if (!b.set_script(ind, redemption::redeem(scripts.first(), b.incomplete(), ind, entry.Key))) return {};
+            scripts = scripts.rest();
+            ind++;
         }
         
-        return ledger::double_entry{std::make_shared<bytes>(transaction{in, out, locktime}.write())};
+        return ledger::double_entry{std::make_shared<bytes>(b.complete())};
     }
     
     bool ledger::vertex::valid() const {
-        if (!double_entry::valid() || prevouts().valid()) return false; 
+        if (!double_entry::valid()) return false; 
         list<prevout> p = prevouts();
+        for (const prevout& x : p) if (!x.valid()) return false;
         
-        if (spent() > sent()) return false;
+        if (spent() < sent()) return false;
         
-        // TODO run scripts
-        return true;
+        return Bitcoin::validate_scripts(*this).valid();
     }
     
     uint32 ledger::vertex::sigops() const {
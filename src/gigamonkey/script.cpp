@@ -6,59 +6,135 @@
 
 namespace Gigamonkey::Bitcoin {
     
-    bool valid_program(program p, stack<op> x) {
-        if (p.empty()) return false;
-        if (!p.first().valid()) return false;
-        op o = p.first().Op;
-        if (o == OP_ENDIF) {
-            if (x.empty()) return false;
-            op prev = x.first();
-            x = x.rest();
+    // keeps track of IF, NOTIF, ELSE and ENDIF as a program is read. 
+    struct control_stack {
+        std::vector<op> Stack;
+        
+        // returns false if the op code does not fit with what came before. 
+        bool push(op o) {
+            if (o == OP_IF || o == OP_NOTIF || o == OP_ELSE) {
+                Stack.push_back(o);
+                return true;
+            }
+            
+            if (o != OP_ENDIF) return true;
+            
+            if (Stack.empty()) return false;
+            op prev = Stack.back();
+            Stack.pop_back();
             if (prev == OP_ELSE) {
-                if (x.empty()) return false;
-                prev = x.first();
-                x = x.rest();
+                if (Stack.empty()) return false;
+                prev = Stack.back();
+                Stack.pop_back();
             }
-            if (prev != OP_IF && prev != OP_NOTIF) return false;
-        } else if (o == OP_ELSE || o == OP_IF || o == OP_NOTIF) x = x << o;
-        if (p.size() == 1) return x.empty();
-        if (o == OP_RETURN && p.first().Data.size() != 0) return false;
-        return valid_program(p.rest(), x);
-    }
+            
+            return prev == OP_IF || prev == OP_NOTIF;
+        }
+        
+        bool empty() const {
+            return Stack.empty();
+        }
+    };
     
     bool valid(program p) {
-        return valid_program(p, {});
+        if (p.empty()) return false;
+        control_stack x{};
+        size_t remaining = p.size();
+        for (const instruction& i : p) {
+            if (!i.valid() || !x.push(i.Op)) return false;
+            if (--remaining == 0) break;
+            if (i.Op == OP_RETURN && i.Data.size() != 0) return false;
+        }
+        
+        return x.empty();
     }
     
-    bool provably_prunable_recurse(program p) {
-        if (p.size() < 2) return false;
-        if (p.size() == 2) return p.first().Op == OP_FALSE && p.rest().first() == OP_RETURN;
-        return provably_prunable_recurse(p);
+    bool valid_program(bytes_view script) {
+        if (script.size() == 0) return false;
+        control_stack x{};
+        for (const instruction_view& i : instructions{script}) {
+            if (!i.valid() || !x.push(i.Op)) return false;
+            // decompile stops at OP_RETURN. 
+            if (i.Op == OP_RETURN) return x.empty();
+        }
+        
+        return x.empty();
     }
     
     bool provably_prunable(program p) {
-        if (!p.valid()) return false;
-        return provably_prunable_recurse(p);
+        if (p.size() < 2 || !valid(p)) return false;
+        return p.first() == OP_FALSE && p.rest().first().Op == OP_RETURN;
     }
     
-    // We already know that o has size at least 1 
-    // when we call this function. 
+    // returns zero if the instruction at the start of
+    // the script is invalid or runs past the end. 
     uint32 next_instruction_size(bytes_view o) {
-        opcodetype op = opcodetype(o[0]);
-        if (op == OP_INVALIDOPCODE) return 0;
-        if (!is_push_data(opcodetype(op))) return 1;
-        if (op <= OP_PUSHSIZE75) return (op + 1);
-        if (op == OP_PUSHDATA1) {
-            if (o.size() < 2) return 0;
-            return o[1] + 2;
+        return instruction_view::read(o).length();
+    }
+    
+    instruction_view instruction_view::read(bytes_view b) {
+        if (b.size() == 0) return {};
+        op o = op(b[0]);
+        if (o == OP_INVALIDOPCODE) return {};
+        if (!is_push_data(o)) return instruction_view{o};
+        
+        size_t header;
+        size_t size;
+        if (o <= OP_PUSHSIZE75) {
+            header = 1;
+            size = o;
+        } else if (o == OP_PUSHDATA1) {
+            if (b.size() < 2) return {};
+            header = 2;
+            size = b[1];
+        } else if (o == OP_PUSHDATA2) {
+            if (b.size() < 3) return {};
+            header = 3;
+            size = boost::endian::load_little_u16(&b[1]);
+        } else {
+            if (b.size() < 5) return {};
+            header = 5;
+            size = boost::endian::load_little_u32(&b[1]);
+        }
+        
+        if (b.size() - header < size) return {};
+        return instruction_view{o, b.substr(header, size)};
+    }
+    
+    bytes_view instruction_view::data() const {
+        static const byte SmallNumbers[] {0x81, 
+            0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 
+            0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10};
+        if (is_push_data(Op) || Op == OP_RETURN) return Data;
+        if (!is_push(Op)) return {};
+        if (Op == OP_1NEGATE) return bytes_view{SmallNumbers, 1};
+        return bytes_view{SmallNumbers + (Op - 0x50), 1};
+    }
+    
+    bool instruction_view::number(int64& n) const {
+        if (!is_push(Op)) return false;
+        bytes_view d = data();
+        if (d.size() > 8) return false;
+        if (d.size() == 0) {
+            n = 0;
+            return true;
         }
-        if (op == OP_PUSHDATA2) {
-            if (o.size() < 3) return 0;
-            return boost::endian::load_little_u16(&o[1]) + 3;
+        
+        // little endian, with the sign in the highest bit.
+        uint64 x = 0;
+        for (int i = d.size() - 1; i >= 0; i--) x = (x << 8) | d[i];
+        uint64 sign = uint64{0x80} << (8 * (d.size() - 1));
+        n = x & sign ? -static_cast<int64>(x & ~sign) : static_cast<int64>(x);
+        return true;
+    }
+    
+    bool instructions::valid() const {
+        if (Script.size() == 0) return false;
+        for (const instruction_view& i : *this) {
+            if (!i.valid()) return false;
+            if (i.Op == OP_RETURN) return true;
         }
-        // otherwise it's OP_PUSHDATA4
-        if (o.size() < 5) return 0;
-        return boost::endian::load_little_u32(&o[1]) + 5;
+        return true;
     }
     
     // Inefficient: extra copying. 
@@ -86,77 +162,32 @@ namespace Gigamonkey::Bitcoin {
         }
         
         script_writer operator<<(program p) const {
-            return p.size() == 0 ? script_writer{Writer} : (script_writer{Writer} << p.first() << p.rest());
+            bytes_writer w = Writer;
+            for (const instruction& i : p) w = write(w, i);
+            return script_writer{w};
         }
         
         script_writer(bytes_writer w) : Writer{w} {}
     };
     
-    bytes_reader read_push(bytes_reader read, instruction& rest) {
-        uint32 size;
-        bytes_reader r = read;
-        if (rest.Op <= OP_PUSHSIZE75) size = rest.Op;
-        if (rest.Op == OP_PUSHDATA1) {
-            byte x;
-            r = r >> x;
-            size = x;
-        }
-        if (rest.Op == OP_PUSHDATA2) {
-            uint16_little x;
-            r = r >> x;
-            size = x;
-        }
-        if (rest.Op == OP_PUSHDATA4) {
-            uint32_little x;
-            r = r >> x;
-            size = x;
-        }
-        
-        if ((r.Reader.End - r.Reader.Begin) < size) {
-            rest = {};
-            return read;
-        }
-        
-        rest.Data = bytes(size);
-        r = r >> rest.Data;
-        return r;
-    }
-    
-    struct script_reader {
-        bytes_reader Reader;
-        script_reader operator>>(instruction& i) const {
-            if ((Reader.Reader.End - Reader.Reader.Begin) == 0) {
-                i = {};
-                return *this;
-            }
-            
-            byte next;
-            bytes_reader r = Reader >> next;
-            i.Op = static_cast<op>(next);
-            if (is_push_data(i.Op)) return read_push(r, i);
-            return r;
-        }
-        
-        bool empty() const {
-            return Reader.empty();
-        }
-        
-        script_reader(bytes_reader r) : Reader{r} {}
-        script_reader(bytes_view b) : Reader{b.data(), b.data() + b.size()} {}
-    };
-    
     instruction instruction::read(bytes_view b) {
-        instruction i;
-        script_reader{b} >> i;
-        return i;
+        return instruction(instruction_view::read(b));
     }
     
+    // the exact size is computed first so that the 
+    // script is written into a single allocation. 
     bytes compile(program p) {
         bytes compiled(length(p));
         script_writer{bytes_writer{compiled.begin(), compiled.end()}} << p;
         return compiled;
     }
     
+    size_t length(program p) {
+        size_t size = 0;
+        for (const instruction& i : p) size += i.length();
+        return size;
+    }
+    
     bytes compile(instruction i) {
         bytes compiled(length(i));
         script_writer{bytes_writer{compiled.begin(), compiled.end()}} << i;
@@ -165,30 +196,10 @@ namespace Gigamonkey::Bitcoin {
     
     program decompile(bytes_view b) {
         program p{};
-        script_reader r{bytes_reader{b.data(), b.data() + b.size()}};
-        bool first_false = false;
-        while(!r.empty()) {
-            instruction i{};
-            r = r >> i;
-            if(!i.valid()) return {};
-            p = p << i;
-            if (i == OP_RETURN) return p;
-            if (i == OP_FALSE) first_false = true;
-        }
-        
-        while(!r.empty()) {
-            instruction i{};
-            r = r >> i;
-            if(!i.valid()) return {};
-            p = p << i;
-            if (first_false && i == OP_RETURN) return p;
-        }
-        
-        while(!r.empty()) {
-            instruction i{};
-            r = r >> i;
-            if(!i.valid()) return {};
-            p = p << i;
+        for (const instruction_view& i : instructions{b}) {
+            if (!i.valid()) return {};
+            p = p << instruction(i);
+            if (i.Op == OP_RETURN) return p;
         }
         
         return p;
@@ -197,9 +208,9 @@ namespace Gigamonkey::Bitcoin {
     bytes_view pattern::atom::scan(bytes_view p) const {
         if (p.size() == 0) throw fail{};
         if (p[0] != Instruction.Op) throw fail{};
-        uint32 size = next_instruction_size(p);
-        if (p.size() < size || Instruction != instruction::read(p.substr(0, size))) throw fail{};
-        return p.substr(size);
+        instruction_view i = instruction_view::read(p);
+        if (!i.valid() || i != Instruction) throw fail{};
+        return p.substr(i.length());
     }
     
     bytes_view pattern::string::scan(bytes_view p) const {
@@ -209,23 +220,23 @@ namespace Gigamonkey::Bitcoin {
     }
     
     bytes_view any::scan(bytes_view p) const {
-        if (p.size() == 0) throw fail{};
         uint32 size = next_instruction_size(p);
-        if (p.size() < size) throw fail{};
+        if (size == 0) throw fail{};
         return p.substr(size);
     }
     
-    bool push::match(const instruction& i) const {
+    bool push::match(const instruction_view& i) const {
         switch (Type) {
             case any : 
                 return is_push(i.Op);
             case value : 
-                return is_push(i.Op) && Value == Z{data::math::number::Z_bytes<data::endian::little>{i.data()}};
+                int64 n;
+                return i.number(n) && n == Value;
             case data : 
-                return is_push(i.Op) && Data == i.data();
+                return is_push(i.Op) && bytes_view(Data) == i.data();
             case read : 
                 if (!is_push(i.Op)) return false;
-                Read = i.data();
+                Read = bytes(i.data());
                 return true;
             default: 
                 return false;
@@ -233,25 +244,23 @@ namespace Gigamonkey::Bitcoin {
     }
     
     bytes_view push::scan(bytes_view p) const {
-        if (p.size() == 0) throw fail{};
-        uint32 size = next_instruction_size(p);
-        if (size == 0) throw fail{};
-        if (!match(instruction::read(p.substr(0, size)))) throw fail{};
-        return p.substr(size);
+        instruction_view i = instruction_view::read(p);
+        if (!i.valid() || !match(i)) throw fail{};
+        return p.substr(i.length());
     }
     
-    bool push_size::match(const instruction& i) const {
-        bytes Data = i.data();
-        if (Data.size() != Size) return false;
-        if (Reader) Read = Data;
+    bool push_size::match(const instruction_view& i) const {
+        if (!is_push(i.Op)) return false;
+        bytes_view data = i.data();
+        if (data.size() != Size) return false;
+        if (Reader) Read = bytes(data);
         return true;
     }
     
     bytes_view push_size::scan(bytes_view p) const {
-        if (p.size() == 0) throw fail{};
-        uint32 size = next_instruction_size(p);
-        if (!match(instruction::read(p.substr(0, size)))) throw fail{};
-        return p.substr(size);
+        instruction_view i = instruction_view::read(p);
+        if (!i.valid() || !match(i)) throw fail{};
+        return p.substr(i.length());
     }
     
     bytes_view pattern::sequence::scan(bytes_view p) const {
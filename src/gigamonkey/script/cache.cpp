@@ -0,0 +1,91 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include <gigamonkey/script/cache.hpp>
+#include <gigamonkey/schema/random.hpp>
+
+namespace Gigamonkey::Bitcoin {
+    
+    script_cache::script_cache(size_t capacity) : Capacity{capacity}, Salt{}, Shard{}, Hits{0}, Misses{0} {
+        bitcoind_random{}.get(Salt.data(), 32);
+    }
+    
+    script_cache& script_cache::common() {
+        static script_cache Cache{};
+        return Cache;
+    }
+    
+    namespace {
+        
+        byte* write_little(byte* b, uint64 x, uint32 size) {
+            for (uint32 i = 0; i < size; i++) *b++ = byte(x >> (8 * i));
+            return b;
+        }
+        
+    }
+    
+    // salt, txid, index, value, script hash and flags. 
+    digest256 script_cache::key(const txid& id, index i, const transaction_view::output& spent, uint32 flags) const {
+        std::array<byte, 112> b;
+        byte* w = std::copy(Salt.begin(), Salt.end(), b.data());
+        w = std::copy(id.begin(), id.end(), w);
+        w = write_little(w, i, 4);
+        w = write_little(w, uint64(int64(spent.Value)), 8);
+        digest256 script = sha256(spent.Script);
+        w = std::copy(script.begin(), script.end(), w);
+        write_little(w, flags, 4);
+        return sha256(bytes_view{b.data(), b.size()});
+    }
+    
+    bool script_cache::contains(const digest256& d) {
+        if (Capacity == 0) return false;
+        
+        shard& s = get(d);
+        bool found;
+        {
+            std::lock_guard<std::mutex> lock{s.Mutex};
+            found = s.Keys.count(d) != 0;
+        }
+        
+        (found ? Hits : Misses)++;
+        return found;
+    }
+    
+    void script_cache::insert(const digest256& d) {
+        if (Capacity == 0) return;
+        
+        // each shard holds an equal part of the capacity. 
+        size_t max = std::max(Capacity / Shards, size_t{1});
+        shard& s = get(d);
+        std::lock_guard<std::mutex> lock{s.Mutex};
+        if (!s.Keys.insert(d).second) return;
+        s.Order.push_back(d);
+        
+        while (s.Order.size() > max) {
+            s.Keys.erase(s.Order.front());
+            s.Order.pop_front();
+        }
+    }
+    
+    void script_cache::clear() {
+        for (shard& s : Shard) {
+            std::lock_guard<std::mutex> lock{s.Mutex};
+            s.Keys.clear();
+            s.Order.clear();
+        }
+        
+        Hits = 0;
+        Misses = 0;
+    }
+    
+    size_t script_cache::size() const {
+        size_t n = 0;
+        for (const shard& s : Shard) {
+            std::lock_guard<std::mutex> lock{s.Mutex};
+            n += s.Keys.size();
+        }
+        
+        return n;
+    }
+    
+}
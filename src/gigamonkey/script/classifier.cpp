@@ -0,0 +1,103 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include <gigamonkey/script/classifier.hpp>
+#include <gigamonkey/boost/boost.hpp>
+
+namespace Gigamonkey::Bitcoin {
+    
+    namespace {
+        
+        // Boost output scripts begin by pushing "boostpow" and dropping it. 
+        const byte BoostPrefix[] {0x08, 0x62, 0x6F, 0x6F, 0x73, 0x74, 0x70, 0x6F, 0x77, OP_DROP};
+        
+        bool only_pushes(bytes_view b) {
+            for (const instruction_view& i : instructions{b}) if (!i.valid() || !is_push(i.Op)) return false;
+            return true;
+        }
+        
+        // the pubkeys of a multisig script, each of which must be 33 or 65 bytes. 
+        uint32 count_pubkeys(bytes_view b) {
+            uint32 count = 0;
+            for (const instruction_view& i : instructions{b}) {
+                if (i.Op != OP_PUSHSIZE33 && i.Op != OP_PUSHSIZE65) return 0;
+                count++;
+            }
+            return count;
+        }
+        
+    }
+    
+    script_classifier::classification script_classifier::classify(bytes_view b) {
+        classification x{};
+        size_t size = b.size();
+        if (size == 0) return x;
+        
+        switch (b[0]) {
+            // OP_DUP OP_HASH160 <20 bytes> OP_EQUALVERIFY OP_CHECKSIG
+            case OP_DUP : {
+                if (size == 25 && b[1] == OP_HASH160 && b[2] == OP_PUSHSIZE20 && 
+                    b[23] == OP_EQUALVERIFY && b[24] == OP_CHECKSIG) {
+                    x.Type = pay_to_address;
+                    x.Hash160 = b.substr(3, 20);
+                }
+                return x;
+            }
+            
+            // <pubkey> OP_CHECKSIG
+            case OP_PUSHSIZE33 : 
+            case OP_PUSHSIZE65 : {
+                if (size == b[0] + 2 && b[size - 1] == OP_CHECKSIG) {
+                    x.Type = pay_to_pubkey;
+                    x.Pubkey = b.substr(1, b[0]);
+                }
+                return x;
+            }
+            
+            case OP_FALSE : {
+                if (size < 2 || b[1] != OP_RETURN || !only_pushes(b.substr(2))) return x;
+                x.Type = op_return_data;
+                x.Pushes = b.substr(2);
+                return x;
+            }
+            
+            case OP_RETURN : {
+                if (!only_pushes(b.substr(1))) return x;
+                x.Type = op_return_data;
+                x.Pushes = b.substr(1);
+                return x;
+            }
+            
+            // the whole script must be read to know whether it is Boost.
+            case OP_PUSHSIZE8 : {
+                if (size < sizeof(BoostPrefix) || b.substr(0, sizeof(BoostPrefix)) != bytes_view{BoostPrefix, sizeof(BoostPrefix)}) return x;
+                if (!Boost::output_script::valid(bytes(b))) return x;
+                x.Type = boost;
+                if (b[sizeof(BoostPrefix)] == OP_PUSHSIZE20) x.Hash160 = b.substr(sizeof(BoostPrefix) + 1, 20);
+                return x;
+            }
+            
+            default : break;
+        }
+        
+        // OP_m <pubkey> ... <pubkey> OP_n OP_CHECKMULTISIG
+        if (b[0] >= OP_1 && b[0] <= OP_16 && size >= 3 && b[size - 1] == OP_CHECKMULTISIG) {
+            byte m = b[0] - 0x50;
+            byte n = b[size - 2] - 0x50;
+            if (b[size - 2] < OP_1 || b[size - 2] > OP_16 || m > n) return x;
+            bytes_view pubkeys = b.substr(1, size - 3);
+            if (count_pubkeys(pubkeys) != n) return x;
+            x.Type = multisig;
+            x.Pushes = pubkeys;
+            x.Required = m;
+        }
+        
+        return x;
+    }
+    
+    void script_classifier::classify(const transaction_view& t, std::vector<classification>& x) {
+        x.resize(t.Outputs.size());
+        for (size_t i = 0; i < t.Outputs.size(); i++) x[i] = classify(t.Outputs[i].Script);
+    }
+    
+}
@@ -0,0 +1,283 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include <gigamonkey/script/pattern.hpp>
+
+namespace Gigamonkey::Bitcoin {
+    
+    void pattern::compile(compiled_pattern& c) const {
+        if (Pattern != nullptr) Pattern->compile(c);
+    }
+    
+    void any::compile(compiled_pattern& c) const {
+        c.add(compiled_pattern::step::any);
+    }
+    
+    void pattern::atom::compile(compiled_pattern& c) const {
+        c.add(compiled_pattern::step::instruction, Instruction.Op, c.constant(Instruction.Data), Instruction.Data.size());
+    }
+    
+    void pattern::string::compile(compiled_pattern& c) const {
+        c.add(compiled_pattern::step::string, OP_INVALIDOPCODE, c.constant(Program), Program.size());
+    }
+    
+    void push::compile(compiled_pattern& c) const {
+        switch (Type) {
+            case any :
+                return c.add(compiled_pattern::step::push);
+            case value :
+                return c.add(compiled_pattern::step{compiled_pattern::step::push_value, OP_INVALIDOPCODE, -1, 0, 0, Value});
+            case data :
+                return c.add(compiled_pattern::step::push_data, OP_INVALIDOPCODE, c.constant(Data), Data.size());
+            case read :
+                return c.add(compiled_pattern::step{compiled_pattern::step::push, OP_INVALIDOPCODE, c.capture(Read), 0, 0, 0});
+        }
+    }
+    
+    void push_size::compile(compiled_pattern& c) const {
+        c.add(compiled_pattern::step{compiled_pattern::step::push_size, OP_INVALIDOPCODE,
+            Reader ? c.capture(Read) : int16(-1), 0, static_cast<uint32>(Size), 0});
+    }
+    
+    void pattern::sequence::compile(compiled_pattern& c) const {
+        for (const ptr<pattern>& p : Patterns) p->compile(c);
+    }
+    
+    // choice End; Pattern; commit End; End:
+    void optional::compile(compiled_pattern& c) const {
+        c.open();
+        uint32 choice = c.next();
+        c.add(compiled_pattern::step::choice);
+        pattern::Pattern->compile(c);
+        c.add(compiled_pattern::step::commit, OP_INVALIDOPCODE, c.next() + 1);
+        c.target(choice, c.next());
+        c.close();
+    }
+    
+    // The required matches are written out in full. After that, an
+    // unbounded pattern loops with partial_commit and a bounded one
+    // is written as a chain of optional patterns.
+    void repeated::compile(compiled_pattern& c) const {
+        uint32 min = Second == -1 && Directive == or_less ? 0 : First;
+        int64 max = Second != -1 ? Second : Directive == or_more ? -1 : First;
+        
+        for (uint32 i = 0; i < min; i++) pattern::Pattern->compile(c);
+        
+        c.open();
+        if (max == -1) {
+            uint32 choice = c.next();
+            c.add(compiled_pattern::step::choice);
+            pattern::Pattern->compile(c);
+            c.add(compiled_pattern::step::partial_commit, OP_INVALIDOPCODE, choice + 1);
+            c.target(choice, c.next());
+        } else {
+            std::vector<uint32> choices;
+            for (int64 i = min; i < max; i++) {
+                choices.push_back(c.next());
+                c.add(compiled_pattern::step::choice);
+                pattern::Pattern->compile(c);
+                c.add(compiled_pattern::step::commit, OP_INVALIDOPCODE, c.next() + 1);
+            }
+            
+            for (uint32 choice : choices) c.target(choice, c.next());
+        }
+        c.close();
+    }
+    
+    // each alternative but the last is tried with a backtrack
+    // point to the next one and commits to the end if it matches.
+    void alternatives::compile(compiled_pattern& c) const {
+        std::vector<uint32> commits;
+        list<ptr<pattern>> patt = Patterns;
+        c.open();
+        while (!data::empty(patt)) {
+            if (data::empty(patt.rest())) {
+                patt.first()->compile(c);
+                break;
+            }
+            
+            uint32 choice = c.next();
+            c.add(compiled_pattern::step::choice);
+            patt.first()->compile(c);
+            commits.push_back(c.next());
+            c.add(compiled_pattern::step::commit);
+            c.target(choice, c.next());
+            patt = patt.rest();
+        }
+        
+        for (uint32 commit : commits) c.target(commit, c.next());
+        c.close();
+    }
+    
+    compiled_pattern::compiled_pattern(const pattern& p) :
+        Steps{}, Constants{}, Targets{}, Depth{0}, MaxOpen{0}, Valid{true} {
+        p.compile(*this);
+        add(step::end);
+        if (MaxOpen > MaxDepth || Targets.size() > MaxCaptures) Valid = false;
+    }
+    
+    void compiled_pattern::add(step x) {
+        Steps.push_back(x);
+    }
+    
+    void compiled_pattern::add(step::code c, op o, uint32 offset, uint32 size) {
+        Steps.push_back(step{c, o, -1, offset, size, 0});
+    }
+    
+    uint32 compiled_pattern::constant(bytes_view b) {
+        uint32 offset = Constants.size();
+        Constants.resize(offset + b.size());
+        std::copy(b.begin(), b.end(), Constants.begin() + offset);
+        return offset;
+    }
+    
+    int16 compiled_pattern::capture(bytes& r) {
+        Targets.push_back(&r);
+        return Targets.size() - 1;
+    }
+    
+    void compiled_pattern::target(uint32 step, uint32 target) {
+        Steps[step].Offset = target;
+    }
+    
+    void compiled_pattern::open() {
+        if (++Depth > MaxOpen) MaxOpen = Depth;
+    }
+    
+    void compiled_pattern::close() {
+        Depth--;
+    }
+    
+    namespace {
+        
+        // a capture as it is stored during a match. Unlike bytes_view,
+        // arrays of these are not initialized when they are declared.
+        struct span {
+            const byte* Data;
+            size_t Size;
+        };
+        
+        bool match_step(const compiled_pattern::step& x, const instruction_view& i, bytes_view constant) {
+            switch (x.Code) {
+                case compiled_pattern::step::instruction :
+                    return i.Op == x.Op && i.Data == constant;
+                case compiled_pattern::step::any :
+                    return true;
+                case compiled_pattern::step::push :
+                    return is_push(i.Op);
+                case compiled_pattern::step::push_value : {
+                    int64 n;
+                    return i.number(n) && n == x.Value;
+                }
+                case compiled_pattern::step::push_data :
+                    return is_push(i.Op) && i.data() == constant;
+                case compiled_pattern::step::push_size :
+                    return is_push(i.Op) && i.data().size() == x.Size;
+                default :
+                    return false;
+            }
+        }
+        
+    }
+    
+    bool compiled_pattern::match(bytes_view script, bytes_view* captures) const {
+        if (!Valid) return false;
+        
+        struct frame {
+            uint32 Next;
+            size_t Position;
+            span Captures[MaxCaptures];
+        };
+        
+        frame stack[MaxDepth];
+        span captured[MaxCaptures];
+        uint32 slots = Targets.size();
+        for (uint32 i = 0; i < slots; i++) captured[i] = span{nullptr, 0};
+        
+        uint32 depth = 0;
+        uint32 pc = 0;
+        size_t position = 0;
+        
+        while (true) {
+            const step& x = Steps[pc];
+            bytes_view rest = script.substr(position);
+            bool matched;
+            size_t length = 0;
+            
+            switch (x.Code) {
+                case step::end : {
+                    if (rest.size() != 0) return false;
+                    for (uint32 i = 0; i < slots; i++) captures[i] = bytes_view{captured[i].Data, captured[i].Size};
+                    return true;
+                }
+                case step::choice : {
+                    frame& f = stack[depth++];
+                    f.Next = x.Offset;
+                    f.Position = position;
+                    std::copy(captured, captured + slots, f.Captures);
+                    pc++;
+                    continue;
+                }
+                case step::commit : {
+                    depth--;
+                    pc = x.Offset;
+                    continue;
+                }
+                case step::partial_commit : {
+                    frame& f = stack[depth - 1];
+                    // a repetition that reads nothing would loop forever.
+                    if (f.Position == position) {
+                        depth--;
+                        pc++;
+                        continue;
+                    }
+                    
+                    f.Position = position;
+                    std::copy(captured, captured + slots, f.Captures);
+                    pc = x.Offset;
+                    continue;
+                }
+                case step::string : {
+                    matched = rest.size() >= x.Size && rest.substr(0, x.Size) == constant(x);
+                    length = x.Size;
+                    break;
+                }
+                default : {
+                    if (x.Code == step::instruction && (rest.size() == 0 || rest[0] != x.Op)) {
+                        matched = false;
+                        break;
+                    }
+                    
+                    instruction_view i = instruction_view::read(rest);
+                    matched = i.valid() && match_step(x, i, constant(x));
+                    if (matched && x.Capture >= 0) {
+                        bytes_view d = i.data();
+                        captured[x.Capture] = span{d.data(), d.size()};
+                    }
+                    length = i.length();
+                }
+            }
+            
+            if (matched) {
+                position += length;
+                pc++;
+                continue;
+            }
+            
+            // backtrack.
+            if (depth == 0) return false;
+            frame& f = stack[--depth];
+            position = f.Position;
+            std::copy(f.Captures, f.Captures + slots, captured);
+            pc = f.Next;
+        }
+    }
+    
+    bool compiled_pattern::match(bytes_view script) const {
+        bytes_view captured[MaxCaptures];
+        if (!match(script, captured)) return false;
+        for (uint32 i = 0; i < Targets.size(); i++) if (captured[i].data() != nullptr) *Targets[i] = bytes(captured[i]);
+        return true;
+    }
+
+}
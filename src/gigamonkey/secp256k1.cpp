@@ -2,6 +2,7 @@
 // Distributed under the Open BSV software license, see the accompanying file LICENSE.
 
 #include <gigamonkey/secp256k1.hpp>
+#include <gigamonkey/signature_cache.hpp>
 #include <data/encoding/integer.hpp>
 #include <secp256k1.h>
 
@@ -122,6 +123,10 @@ namespace Gigamonkey::secp256k1 {
             verify_signature(context, pubkey, d, parsed);
     }
     
+    bool pubkey::verify(const digest& d, const signature& s) const {
+        return signature_cache::common().verify(Value, d, s);
+    }
+    
     coordinate secret::negate(const coordinate& sk) {
         coordinate out{sk};
         return secp256k1_ec_privkey_negate(Verification(), out.data()) == 1 ? out : 0;
@@ -0,0 +1,103 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include <gigamonkey/signature_cache.hpp>
+#include <gigamonkey/schema/random.hpp>
+
+namespace Gigamonkey::secp256k1 {
+    
+    signature_cache::signature_cache(size_t bytes) : Salt{}, Hash{}, 
+        Slots(bytes / (sizeof(digest256) * Ways) * Ways), Stripe{}, Hits{0}, Misses{0} {
+        bitcoind_random random{};
+        random.get(Salt.data(), 32);
+        for (stripe& s : Stripe) random.get(reinterpret_cast<byte*>(&s.Random), sizeof(uint64));
+    }
+    
+    signature_cache& signature_cache::common() {
+        static signature_cache Cache{};
+        return Cache;
+    }
+    
+    digest256 signature_cache::key(bytes_view pubkey, const digest& d, bytes_view signature) const {
+        bytes b(64 + pubkey.size() + signature.size());
+        auto w = std::copy(Salt.begin(), Salt.end(), b.begin());
+        w = std::copy(pubkey.begin(), pubkey.end(), w);
+        w = std::copy(d.begin(), d.end(), w);
+        std::copy(signature.begin(), signature.end(), w);
+        return sha256(b);
+    }
+    
+    size_t signature_cache::bucket(const digest256& d) const {
+        return Hash(d) % (Slots.size() / Ways);
+    }
+    
+    bool signature_cache::contains(const digest256& d) {
+        if (Slots.size() == 0) return false;
+        
+        size_t b = bucket(d);
+        bool found = false;
+        {
+            std::lock_guard<std::mutex> lock{Stripe[b % Stripes].Mutex};
+            for (uint32 i = 0; i < Ways; i++) if (Slots[b * Ways + i] == d) {
+                found = true;
+                break;
+            }
+        }
+        
+        (found ? Hits : Misses)++;
+        return found;
+    }
+    
+    void signature_cache::insert(const digest256& d) {
+        if (Slots.size() == 0) return;
+        
+        size_t b = bucket(d);
+        stripe& s = Stripe[b % Stripes];
+        std::lock_guard<std::mutex> lock{s.Mutex};
+        
+        digest256* slots = Slots.data() + b * Ways;
+        for (uint32 i = 0; i < Ways; i++) if (slots[i] == d) return;
+        for (uint32 i = 0; i < Ways; i++) if (!slots[i].valid()) {
+            slots[i] = d;
+            return;
+        }
+        
+        // xorshift. 
+        s.Random ^= s.Random << 13;
+        s.Random ^= s.Random >> 7;
+        s.Random ^= s.Random << 17;
+        slots[s.Random % Ways] = d;
+    }
+    
+    bool signature_cache::verify(bytes_view p, const digest& d, const signature& s) {
+        digest256 k = key(p, d, s);
+        if (contains(k)) return true;
+        if (!pubkey::verify(p, d, s)) return false;
+        insert(k);
+        return true;
+    }
+    
+    bool signature_cache::verify(const std::vector<verification>& x, work_stealing_pool& pool) {
+        std::atomic<bool> valid{true};
+        pool.run(x.size(), [this, &x, &valid](size_t i) {
+            if (!valid) return;
+            signature s{};
+            s.resize(x[i].Signature.size());
+            std::copy(x[i].Signature.begin(), x[i].Signature.end(), s.begin());
+            if (!verify(x[i].Pubkey, x[i].Digest, s)) valid = false;
+        });
+        
+        return valid;
+    }
+    
+    void signature_cache::clear() {
+        for (size_t b = 0; b < Slots.size() / Ways; b++) {
+            std::lock_guard<std::mutex> lock{Stripe[b % Stripes].Mutex};
+            for (uint32 i = 0; i < Ways; i++) Slots[b * Ways + i] = digest256{};
+        }
+        
+        Hits = 0;
+        Misses = 0;
+    }
+    
+}
@@ -88,6 +88,21 @@ namespace Gigamonkey::Bitcoin {
         return n;
     }
     
+    bool outpoint::valid(slice<36>) {
+        return true;
+    }
+    
+    Bitcoin::txid outpoint::reference(slice<36> x) {
+        return digest256(x.range<0, 32>());
+    }
+    
+    Gigamonkey::index outpoint::index(slice<36> x) {
+        Gigamonkey::index n;
+        slice<4> v = x.range<32, 36>();
+        std::copy(v.begin(), v.end(), n.data());
+        return n;
+    }
+    
     bool header::valid(const slice<80> h) {
         return header_valid(Bitcoin::header::read(h)) && header_valid_work(h);
     }
@@ -122,15 +137,15 @@ namespace Gigamonkey::Bitcoin {
     }
     
     bool input::valid() const {
-        return decompile(Script) != program{};
+        return instructions{Script}.valid();
     }
     
     bool output::valid() const {
-        return Value < 2100000000000000 && decompile(Script) != program{};
+        return Value < 2100000000000000 && instructions{Script}.valid();
     }
     
     size_t transaction::serialized_size() const {
-        return 8 + writer::var_int_size(Inputs.size()) + writer::var_int_size(Inputs.size()) + 
+        return 8 + writer::var_int_size(Inputs.size()) + writer::var_int_size(Outputs.size()) + 
             data::fold([](size_t size, const Bitcoin::input& i) -> size_t {
                 return size + i.serialized_size();
             }, 0, Inputs) + 
@@ -139,6 +154,13 @@ namespace Gigamonkey::Bitcoin {
             }, 0, Outputs);
     }
     
+    size_t indexed_transaction::serialized_size() const {
+        size_t size = 8 + writer::var_int_size(Inputs.size()) + writer::var_int_size(Outputs.size());
+        for (const Bitcoin::input& i : Inputs) size += i.serialized_size();
+        for (const Bitcoin::output& o : Outputs) size += o.serialized_size();
+        return size;
+    }
+    
     size_t block::serialized_size() const {
         return 80 + writer::var_int_size(Transactions.size()) + 
         data::fold([](size_t size, transaction x)->size_t{
@@ -164,6 +186,39 @@ namespace Gigamonkey::Bitcoin {
         }
     }
     
+    indexed_transaction indexed_transaction::read(bytes_view b) {
+        try {
+            indexed_transaction t;
+            reader{b} >> t;
+            return t;
+        } catch (data::end_of_stream n) {
+            return {};
+        }
+    }
+    
+    bytes indexed_transaction::write() const {
+        bytes b(serialized_size());
+        writer w{b};
+        w = w << *this;
+        return b;
+    }
+    
+    indexed_transaction::indexed_transaction(const transaction& t) : 
+        Version{t.Version}, Inputs{}, Outputs{}, Locktime{t.Locktime} {
+        Inputs.reserve(t.Inputs.size());
+        Outputs.reserve(t.Outputs.size());
+        for (const Bitcoin::input& i : t.Inputs) Inputs.push_back(i);
+        for (const Bitcoin::output& o : t.Outputs) Outputs.push_back(o);
+    }
+    
+    indexed_transaction::operator transaction() const {
+        list<Bitcoin::input> i;
+        list<Bitcoin::output> o;
+        for (const Bitcoin::input& x : Inputs) i = i << x;
+        for (const Bitcoin::output& x : Outputs) o = o << x;
+        return transaction{Version, i, o, Locktime};
+    }
+    
     bytes transaction::write() const {
         bytes b(serialized_size());
         writer w{b};
@@ -276,6 +331,203 @@ namespace Gigamonkey::Bitcoin {
         }
     }
 
+    // reads a serialized transaction without copying. 
+    // A read fails if it would run past the end. 
+    struct view_reader {
+        bytes_view Rest;
+        
+        bool read(size_t size, bytes_view& x) {
+            if (Rest.size() < size) return false;
+            x = Rest.substr(0, size);
+            Rest = Rest.substr(size);
+            return true;
+        }
+        
+        bool read_var_int(uint64& x) {
+            bytes_view b;
+            if (!read(1, b)) return false;
+            if (b[0] <= 0xfc) {
+                x = b[0];
+                return true;
+            }
+            
+            size_t size = b[0] == 0xfd ? 2 : b[0] == 0xfe ? 4 : 8;
+            if (!read(size, b)) return false;
+            x = 0;
+            for (int i = size - 1; i >= 0; i--) x = (x << 8) | b[i];
+            return true;
+        }
+        
+        bool read_script(bytes_view& x) {
+            uint64 size;
+            return read_var_int(size) && read(size, x);
+        }
+    };
+    
+    transaction_view::transaction_view(bytes_view b) : 
+        Transaction{b}, Version{}, Inputs{}, Outputs{}, Locktime{}, Valid{false} {
+        Valid = read();
+        if (Valid) return;
+        Inputs.clear();
+        Outputs.clear();
+    }
+    
+    bool transaction_view::read() {
+        view_reader r{Transaction};
+        bytes_view x;
+        
+        uint64 num_inputs;
+        if (!r.read(4, x) || !r.read_var_int(num_inputs)) return false;
+        Version = int32_little{boost::endian::load_little_s32(x.data())};
+        
+        // inputs are at least 41 bytes and outputs at least 9, so  
+        // a bad count cannot make us reserve too much memory. 
+        if (num_inputs > r.Rest.size() / 41) return false;
+        Inputs.resize(num_inputs);
+        for (input& in : Inputs) {
+            if (!r.read(36, in.Outpoint) || !r.read_script(in.Script) || !r.read(4, x)) return false;
+            in.Sequence = uint32_little{boost::endian::load_little_u32(x.data())};
+        }
+        
+        uint64 num_outputs;
+        if (!r.read_var_int(num_outputs) || num_outputs > r.Rest.size() / 9) return false;
+        Outputs.resize(num_outputs);
+        for (output& out : Outputs) {
+            if (!r.read(8, x) || !r.read_script(out.Script)) return false;
+            out.Value = satoshi{boost::endian::load_little_s64(x.data())};
+        }
+        
+        if (!r.read(4, x) || r.Rest.size() != 0) return false;
+        Locktime = uint32_little{boost::endian::load_little_u32(x.data())};
+        return true;
+    }
+    
+    bool transaction_view::find_input(bytes_view tx, uint32 index, input& in) {
+        view_reader r{tx};
+        bytes_view x;
+        
+        uint64 num_inputs;
+        if (!r.read(4, x) || !r.read_var_int(num_inputs) || num_inputs <= index) return false;
+        for (uint32 i = 0; i <= index; i++) 
+            if (!r.read(36, in.Outpoint) || !r.read_script(in.Script) || !r.read(4, x)) return false;
+        
+        in.Sequence = uint32_little{boost::endian::load_little_u32(x.data())};
+        return true;
+    }
+    
+    bool transaction_view::find_output(bytes_view tx, uint32 index, output& out) {
+        view_reader r{tx};
+        bytes_view x;
+        
+        uint64 num_inputs;
+        if (!r.read(4, x) || !r.read_var_int(num_inputs)) return false;
+        for (uint64 i = 0; i < num_inputs; i++) 
+            if (!r.read(36, x) || !r.read_script(x) || !r.read(4, x)) return false;
+        
+        uint64 num_outputs;
+        if (!r.read_var_int(num_outputs) || num_outputs <= index) return false;
+        for (uint32 i = 0; i <= index; i++) 
+            if (!r.read(8, x) || !r.read_script(out.Script)) return false;
+        
+        out.Value = satoshi{boost::endian::load_little_s64(x.data())};
+        return true;
+    }
+    
+    transaction_builder::transaction_builder(int32_little version, uint32_little locktime) : 
+        Transaction(10), Slots{}, Outputs{0}, InputsEnd{5} {
+        writer{Transaction} << version << byte(0) << byte(0) << locktime;
+    }
+    
+    int64 transaction_builder::count(size_t offset, uint64 previous, uint64 next) {
+        int64 moved = int64(writer::var_int_size(next)) - int64(writer::var_int_size(previous));
+        if (moved > 0) Transaction.insert(Transaction.begin() + offset, moved, 0);
+        writer::write_var_int(bytes_writer{Transaction.begin() + offset, Transaction.end()}, next);
+        return moved;
+    }
+    
+    uint32 transaction_builder::add_input(const outpoint& op, bytes_view script, size_t reserved, uint32_little sequence) {
+        size_t at = InputsEnd;
+        size_t size = 40 + writer::var_int_size(reserved) + reserved;
+        Transaction.insert(Transaction.begin() + at, size, 0);
+        
+        bytes_writer w{Transaction.begin() + at, Transaction.begin() + at + size};
+        w = (writer{w} << op).Writer;
+        w = writer::write_var_int(w, reserved) << script;
+        bytes_writer{Transaction.begin() + at + size - 4, Transaction.begin() + at + size} << sequence;
+        
+        Slots.push_back(slot{at + 36, uint32(reserved), uint32(script.size()), script.size() != reserved});
+        InputsEnd += size;
+        
+        // the number of inputs comes after the version. 
+        int64 moved = count(4, Slots.size() - 1, Slots.size());
+        if (moved != 0) {
+            for (slot& x : Slots) x.Offset += moved;
+            InputsEnd += moved;
+        }
+        
+        return Slots.size() - 1;
+    }
+    
+    uint32 transaction_builder::add_input(const outpoint& op, bytes_view script, uint32_little sequence) {
+        return add_input(op, script, script.size(), sequence);
+    }
+    
+    uint32 transaction_builder::add_input(const outpoint& op, size_t reserved, uint32_little sequence) {
+        return add_input(op, bytes_view{}, reserved, sequence);
+    }
+    
+    uint32 transaction_builder::add_output(satoshi value, bytes_view script) {
+        size_t at = Transaction.size() - 4;
+        size_t size = 8 + writer::var_int_size(script.size()) + script.size();
+        Transaction.insert(Transaction.begin() + at, size, 0);
+        writer{bytes_writer{Transaction.begin() + at, Transaction.begin() + at + size}} << value << script;
+        count(InputsEnd, Outputs, Outputs + 1);
+        return Outputs++;
+    }
+    
+    bool transaction_builder::set_script(uint32 input, bytes_view script) {
+        if (input >= Slots.size()) return false;
+        slot& x = Slots[input];
+        if (!x.Open || script.size() > x.Reserved) return false;
+        
+        std::copy(script.begin(), script.end(), Transaction.begin() + x.Offset + writer::var_int_size(x.Reserved));
+        std::fill(Transaction.begin() + x.Offset + writer::var_int_size(x.Reserved) + script.size(), 
+            Transaction.begin() + x.Offset + writer::var_int_size(x.Reserved) + x.Reserved, 0);
+        x.Size = script.size();
+        return true;
+    }
+    
+    // Scripts that are smaller than their reserved space are moved back 
+    // over it, along with everything between them, in one pass. 
+    bytes transaction_builder::complete() {
+        auto begin = Transaction.begin();
+        size_t removed = 0;
+        size_t from = 0;
+        for (const slot& x : Slots) {
+            if (x.Size == x.Reserved) continue;
+            
+            size_t script = x.Offset + writer::var_int_size(x.Reserved);
+            std::copy(begin + from, begin + x.Offset, begin + from - removed);
+            size_t at = x.Offset - removed;
+            
+            writer::write_var_int(bytes_writer{begin + at, Transaction.end()}, x.Size);
+            std::copy(begin + script, begin + script + x.Size, begin + at + writer::var_int_size(x.Size));
+            
+            removed += (script - x.Offset) + x.Reserved - writer::var_int_size(x.Size) - x.Size;
+            from = script + x.Reserved;
+        }
+        
+        if (removed != 0) {
+            std::copy(begin + from, Transaction.end(), begin + from - removed);
+            Transaction.resize(Transaction.size() - removed);
+        }
+        
+        Slots.clear();
+        Outputs = 0;
+        InputsEnd = 0;
+        return std::move(Transaction);
+    }
+    
     writer operator<<(writer w, const input& in) {
         return w << in.Outpoint << in.Script << in.Sequence;
     }
@@ -296,6 +548,13 @@ namespace Gigamonkey::Bitcoin {
         return x;
     }
     
+    bool indexed_transaction::valid() const {
+        if (Inputs.size() == 0 || Outputs.size() == 0) return false;
+        for (const Bitcoin::input& i : Inputs) if (!i.valid()) return false; 
+        for (const Bitcoin::output& o : Outputs) if (!o.valid()) return false; 
+        return true;
+    }
+    
     bool transaction::valid() const {
         if (Inputs.size() == 0 || Outputs.size() == 0) return false;
         for (const Bitcoin::input& i : Inputs) if (!i.valid()) return false; 
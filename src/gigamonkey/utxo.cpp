@@ -0,0 +1,80 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include <gigamonkey/utxo.hpp>
+
+namespace Gigamonkey::Bitcoin {
+    
+    // the indices point into the other set, so they are built again. 
+    utxo_set::utxo_set(const utxo_set& u) : utxo_set{} {
+        for (const auto& x : u.ByOrder) insert(x.second->second.Spendable);
+    }
+    
+    utxo_set& utxo_set::operator=(const utxo_set& u) {
+        if (this != &u) *this = utxo_set{u};
+        return *this;
+    }
+    
+    bool utxo_set::insert(const spendable& s) {
+        auto x = ByOutpoint.emplace(s.Outpoint, entry{s, Next, Positions.size()});
+        if (!x.second) return false;
+        
+        ByOrder.emplace(Next, x.first);
+        ByValue.emplace(std::pair<int64, uint64>{int64(s.Value), Next}, x.first);
+        Positions.push_back(x.first);
+        Next++;
+        Value = Value + s.Value;
+        return true;
+    }
+    
+    bool utxo_set::remove(const outpoint& o) {
+        auto x = ByOutpoint.find(o);
+        if (x == ByOutpoint.end()) return false;
+        
+        const entry& e = x->second;
+        ByOrder.erase(e.Order);
+        ByValue.erase(std::pair<int64, uint64>{int64(e.Spendable.Value), e.Order});
+        
+        // the last position is moved into the one that is removed. 
+        Positions[e.Position] = Positions.back();
+        Positions[e.Position]->second.Position = e.Position;
+        Positions.pop_back();
+        
+        Value = Value - e.Spendable.Value;
+        ByOutpoint.erase(x);
+        return true;
+    }
+    
+    const spendable* utxo_set::find(const outpoint& o) const {
+        auto x = ByOutpoint.find(o);
+        return x == ByOutpoint.end() ? nullptr : &x->second.Spendable;
+    }
+    
+    const spendable* utxo_set::oldest() const {
+        return ByOrder.empty() ? nullptr : &ByOrder.begin()->second->second.Spendable;
+    }
+    
+    const spendable* utxo_set::largest() const {
+        return ByValue.empty() ? nullptr : &ByValue.rbegin()->second->second.Spendable;
+    }
+    
+    const spendable* utxo_set::smallest() const {
+        return ByValue.empty() ? nullptr : &ByValue.begin()->second->second.Spendable;
+    }
+    
+    const spendable* utxo_set::at_least(satoshi v) const {
+        auto x = ByValue.lower_bound(std::pair<int64, uint64>{int64(v), 0});
+        return x == ByValue.end() ? nullptr : &x->second->second.Spendable;
+    }
+    
+    const spendable* utxo_set::random(uint64 r) const {
+        return Positions.empty() ? nullptr : &Positions[r % Positions.size()]->second.Spendable;
+    }
+    
+    list<spendable> utxo_set::entries() const {
+        list<spendable> x;
+        for (const auto& e : ByOrder) x = x << e.second->second.Spendable;
+        return x;
+    }
+    
+}
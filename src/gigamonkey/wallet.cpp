@@ -1,7 +1,33 @@
-#include <gigamonkey/wallet.hpp>
+#include <gigamonkey/coin_selection.hpp>
+#include <optional>
+#include <random>
 
 namespace Gigamonkey::Bitcoin {
     
+    namespace {
+        
+        spendable take(funds& f, const spendable* x) {
+            if (x == nullptr) throw std::out_of_range{"funds are empty"};
+            spendable s = *x;
+            f.remove(s.Outpoint);
+            return s;
+        }
+        
+    }
+    
+    spendable funds::take_next() {
+        return take(*this, Entries.oldest());
+    }
+    
+    spendable funds::take_random() {
+        static thread_local std::mt19937_64 Random{std::random_device{}()};
+        return take(*this, Entries.random(Random()));
+    }
+    
+    spendable funds::take_largest() {
+        return take(*this, Entries.largest());
+    }
+    
     wallet::spent wallet::spend(list<payment> payments) const {
         
         if (!valid()) return {};
@@ -12,91 +38,124 @@ namespace Gigamonkey::Bitcoin {
         
         // check if any payment is below dust threshhold. 
         satoshi to_spend = 0;
-        size_t outputs_size = 0;
-        {
-            list<output> op = outputs;
-            do {
-                satoshi value = op.first().Value;
-                if (value < Dust) return {};
-                to_spend += value;
-                outputs_size += op.first().serialized_size();
-            } while (!op.empty());
+        estimate size{};
+        for (const output& op : outputs) {
+            if (op.Value < Dust) return {};
+            to_spend += op.Value;
+            size.add_output(op.Script.size());
         }
         
         // can't spend more than we have. 
         if (to_spend > Funds.Value) return {};
         
-        ptr<keysource> keys = Keys;
-        uint32 num_change_outputs = std::min(21, std::max(1, static_cast<int>(outputs.size()) / 2));
+        // keys are only taken for change that is really made, so 
+        // the wallet's keys are kept if there is no change. 
+        size_t change_size = Change->expected_size();
+        uint32 max_change_outputs = std::min(21, std::max(1, static_cast<int>(outputs.size()) / 2));
         
-        // generate change scripts
-        list<change> change{};
-        for (int i = 0; i < num_change_outputs; i++) 
-            change = change << Change->create_redeemable(keys);
+        // the fee with some number of change outputs. 
+        auto fee_with = [this, &size, change_size](uint32 change_outputs) -> satoshi {
+            estimate e = size;
+            for (uint32 i = 0; i < change_outputs; i++) e.add_output(change_size);
+            return Fee.calculate(e);
+        };
         
         // select outputs to redeem. 
         funds to_redeem;
         funds remainder;
-        size_t inputs_size = 0;
-        uint32 inputs_sigops = 0;
-        satoshi fee;
+        
+        // best decides the change itself. 
+        std::optional<satoshi> best_change{};
+        satoshi fee{0};
         switch (Policy) {
             case all: {
                 to_redeem = Funds;
-                remainder = funds{};
-                list<spendable> entries = to_redeem.Entries;
-                while (!entries.empty()) {
-                    inputs_size += entries.first().Redeemer->expected_size();
-                    inputs_sigops += entries.first().Redeemer->sigops();
-                    entries = entries.rest();
-                }
+                for (const spendable& entry : to_redeem.Entries.entries()) 
+                    size.add_input(entry.Redeemer->expected_size(), entry.Redeemer->sigops());
                 break;
             }
-            case fifo: {
+            case fifo: 
+            case random: {
                 remainder = Funds;
-                do {
-                    funds::selected x = remainder.select_next();
-                    inputs_size += x.Selected.Redeemer->expected_size();
-                    inputs_sigops += x.Selected.Redeemer->sigops();
-                    to_redeem = to_redeem.insert(x.Selected);
-                    remainder = x.Remainder;
-                    fee = Fee.calculate(inputs_size + outputs_size + 8, inputs_sigops);
-                } while (to_redeem.Value < to_spend + fee);
+                while (to_redeem.Value < to_spend + fee_with(0)) {
+                    if (remainder.Entries.empty()) return {};
+                    spendable x = Policy == fifo ? remainder.take_next() : remainder.take_random();
+                    size.add_input(x.Redeemer->expected_size(), x.Redeemer->sigops());
+                    to_redeem.add(x);
+                }
                 break;
             }
-            case random: {
+            case best: {
+                coin_selection selection{to_spend, Fee, size.size(), size.Sigops, Dust};
+                selection.ChangeOutputSize = estimate::output_size(change_size);
+                coin_selection::result selected = selection.select(Funds.Entries);
+                if (!selected.valid()) return {};
                 remainder = Funds;
-                do {
-                    funds::selected x = remainder.select_random();
-                    inputs_size += x.Selected.Redeemer->expected_size();
-                    inputs_sigops += x.Selected.Redeemer->sigops();
-                    to_redeem = to_redeem.insert(x.Selected);
-                    fee = Fee.calculate(inputs_size + outputs_size + 8, inputs_sigops);
-                } while (to_redeem.Value < to_spend + fee);
+                for (const spendable& x : selected.Inputs) {
+                    remainder.remove(x.Outpoint);
+                    to_redeem.add(x);
+                }
+                
+                fee = selected.Fee;
+                best_change = selected.Change;
                 break;
             }
             case unset:
                 return {}; // can't really happen.
         }
         
-        // determine fee.
-        satoshi to_keep = to_redeem.Value - to_spend - fee;
+        // determine fee and change. Change is divided among as many outputs 
+        // as it can be without any of them being below the dust threshhold. 
+        uint32 change_outputs = 0;
+        satoshi to_keep{0};
+        if (best_change) {
+            to_keep = *best_change;
+            if (int64(to_keep) > 0) change_outputs = 1;
+        } else {
+            if (to_redeem.Value < to_spend + fee_with(0)) return {};
+            for (uint32 n = max_change_outputs; n > 0; n--) {
+                satoshi left = to_redeem.Value - to_spend - fee_with(n);
+                if (int64(left) >= int64(Dust) * n && int64(left) > 0) {
+                    change_outputs = n;
+                    to_keep = left;
+                    break;
+                }
+            }
+            
+            fee = to_redeem.Value - to_spend - to_keep;
+        }
         
-        // setup outputs.
-        // TODO
+        // setup outputs. 
+        ptr<keysource> keys = Keys;
+        std::vector<change> change;
+        while (change.size() < change_outputs) change.push_back(Change->create_redeemable(keys));
+        
+        list<output> all_outputs = outputs;
+        std::vector<satoshi> change_values;
+        for (uint32 i = 0; i < change_outputs; i++) {
+            change_values.push_back(satoshi{int64(to_keep) / change_outputs + (i == 0 ? int64(to_keep) % change_outputs : 0)});
+            all_outputs = all_outputs << output{change_values[i], change[i].OutputScript};
+        }
         
-        // add sighash directives (we just use all)
+        // add sighash directives (we just use all) 
+        list<spendable> spent_outputs = to_redeem.Entries.entries();
         list<data::entry<spendable, sighash::directive>> redeem_orders = for_each(
             [](spendable s) -> data::entry<spendable, sighash::directive> {
-                return {s, sighash::all};
-            }, to_redeem.Entries);
+                return {s, directive(sighash::all)};
+            }, spent_outputs);
         
-        // create tx
-        ledger::double_entry vx = redeem(redeem_orders, outputs);
+        // create tx 
+        ledger::double_entry vx = redeem(redeem_orders, all_outputs);
         if (!vx.valid()) return {};
-        throw 0;
-        //return spent{ledger::vertex{vx, }, wallet{remainder, Policy, keys, Fee, Change, Dust}}; // TODO
+        
+        // the change can be spent from the remainder. 
+        txid id = vx.id();
+        uint32 first_change = data::size(outputs);
+        for (uint32 i = 0; i < change_outputs; i++) 
+            remainder.add(spendable{output{change_values[i], change[i].OutputScript}, 
+                change[i].Redeemer, outpoint{id, first_change + i}});
+        
+        return spent{vx, spent_outputs, fee, wallet{std::move(remainder), Policy, keys, Fee, Change, Dust}};
     }
     
 }
-
@@ -8,31 +8,27 @@
 namespace Gigamonkey::Bitcoin {
     
     secret secret::read(string_view s) {
-        base58::check b58(s);
-        if (!b58.valid()) return secret{};
+        byte data[CompressedSize];
         secret w{};
-        if (b58.size() == 33) {
-            w.Compressed = false;
-        } else if (b58.size() == 34) {
+        if (base58::fixed<CompressedSize>::read(s, data)) {
+            if (data[CompressedSize - 1] != CompressedSuffix) return secret{};
             w.Compressed = true;
+        } else if (base58::fixed<UncompressedSize>::read(s, data)) {
+            w.Compressed = false;
         } else return {};
-        bytes_reader r = (bytes_reader(b58.data(), b58.data() + b58.size()) >> (byte&)(w.Prefix) >> w.Secret); 
-        
-        if (w.Compressed) {
-            byte suffix;
-            r >> suffix;
-            if (suffix != CompressedSuffix) return secret{};
-        } 
         
+        w.Prefix = type(data[0]);
+        std::copy(data + 1, data + 1 + secp256k1::secret::Size, w.Secret.Value.begin());
         return w;
     }
     
     string secret::write(byte prefix, const secp256k1::secret& s, bool compressed) {
-        bytes data(compressed ? CompressedSize - 1: UncompressedSize - 1);
-        bytes_writer w = bytes_writer(data.begin(), data.end()) << s.Value; 
-        if (compressed) w << CompressedSuffix;
-        return base58::check{prefix, data}.encode();
+        byte data[CompressedSize];
+        data[0] = prefix;
+        std::copy(s.Value.begin(), s.Value.end(), data + 1);
+        if (!compressed) return base58::fixed<UncompressedSize>::encode(data);
+        data[CompressedSize - 1] = CompressedSuffix;
+        return base58::fixed<CompressedSize>::encode(data);
     }
     
 }
-
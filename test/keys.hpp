@@ -0,0 +1,36 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#ifndef GIGAMONKEY_TEST_KEYS
+#define GIGAMONKEY_TEST_KEYS
+
+#include <gigamonkey/spendable.hpp>
+
+namespace Gigamonkey::Bitcoin {
+    
+    // keys 1, 2, 3, ... 
+    struct counting_keysource final : keysource {
+        uint64 Index;
+        
+        counting_keysource(uint64 i) : Index{i} {}
+        
+        secret first() const override {
+            return secret{secret::test, secp256k1::secret{secp256k1::coordinate{Index}}};
+        }
+        
+        ptr<keysource> rest() const override {
+            return std::make_shared<counting_keysource>(Index + 1);
+        }
+    };
+    
+    // a pay to address output to the next key, with a made up outpoint. 
+    inline spendable pay_to_address_spendable(ptr<keysource>& keys, uint32 i, satoshi value) {
+        secret s = keys->first();
+        keys = keys->rest();
+        return spendable{output{value, pay_to_address::script(s.address().Digest)},
+            std::make_shared<redeem_pay_to_address>(s, s.to_public()), outpoint{txid{uint256{i + 1}}, i}};
+    }
+    
+}
+
+#endif
@@ -0,0 +1,108 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include <gigamonkey/accounts.hpp>
+#include "gtest/gtest.h"
+
+namespace Gigamonkey::Bitcoin {
+    
+    TEST(AccountsTest, TestBalanceEngine) {
+        bytes script(25, 0);
+        
+        bytes first = transaction{1, 
+            list<input>{input{outpoint{txid{uint256{1}}, 0}, bytes{}, 0}}, 
+            list<output>{output{satoshi{1000}, script}, output{satoshi{2000}, script}}, 0}.write();
+        txid first_id = transaction::id(first);
+        
+        // spends the first output of the first transaction and pays 300 back to me. 
+        bytes second = transaction{1, 
+            list<input>{input{outpoint{first_id, 0}, bytes{}, 0}}, 
+            list<output>{output{satoshi{600}, script}, output{satoshi{300}, script}}, 0}.write();
+        
+        bytes third = transaction{1, 
+            list<input>{input{outpoint{txid{uint256{2}}, 0}, bytes{}, 0}}, 
+            list<output>{output{satoshi{500}, script}}, 0}.write();
+        
+        balance_engine b{};
+        EXPECT_EQ(b.balance(), satoshi{0});
+        
+        EXPECT_TRUE(b.ingest(first, timestamp{100}, {0}));
+        EXPECT_FALSE(b.ingest(first, timestamp{100}, {0}));
+        EXPECT_FALSE(b.ingest(third, timestamp{100}, {1}));
+        EXPECT_TRUE(b.unspent(outpoint{first_id, 0}));
+        EXPECT_FALSE(b.unspent(outpoint{first_id, 1}));
+        
+        EXPECT_TRUE(b.ingest(second, timestamp{200}, {1}));
+        EXPECT_FALSE(b.unspent(outpoint{first_id, 0}));
+        EXPECT_EQ(b.unspent(), 1);
+        
+        EXPECT_EQ(b.balance(), satoshi{300});
+        EXPECT_EQ(b.balance(timestamp{50}), satoshi{0});
+        EXPECT_EQ(b.balance(timestamp{100}), satoshi{1000});
+        EXPECT_EQ(b.balance(timestamp{150}), satoshi{1000});
+        EXPECT_EQ(b.balance(timestamp{200}), satoshi{300});
+        EXPECT_EQ(b.balance(timestamp{250}), satoshi{300});
+        
+        // an earlier event changes the balance after it. 
+        EXPECT_TRUE(b.ingest(third, timestamp{150}, {0}));
+        EXPECT_EQ(b.balance(timestamp{100}), satoshi{1000});
+        EXPECT_EQ(b.balance(timestamp{150}), satoshi{1500});
+        EXPECT_EQ(b.balance(timestamp{200}), satoshi{800});
+        EXPECT_EQ(b.balance(), satoshi{800});
+        
+        EXPECT_EQ(b.received(), satoshi{1800});
+        EXPECT_EQ(b.spent(), satoshi{1000});
+        EXPECT_EQ(b.received() - b.spent(), b.balance());
+        EXPECT_EQ(b.events(), 3);
+        
+        // the second event comes in before the first, which made the output it spends. 
+        balance_engine c{};
+        EXPECT_TRUE(c.ingest(second, timestamp{200}, {1}));
+        EXPECT_EQ(c.balance(), satoshi{300});
+        
+        EXPECT_TRUE(c.ingest(first, timestamp{100}, {0}));
+        EXPECT_FALSE(c.unspent(outpoint{first_id, 0}));
+        EXPECT_EQ(c.unspent(), 1);
+        EXPECT_EQ(c.balance(timestamp{100}), satoshi{1000});
+        EXPECT_EQ(c.balance(timestamp{200}), satoshi{300});
+        EXPECT_EQ(c.balance(), satoshi{300});
+        EXPECT_EQ(c.received(), satoshi{1300});
+        EXPECT_EQ(c.spent(), satoshi{1000});
+    }
+    
+    TEST(AccountsTest, TestBalanceEnginePrune) {
+        bytes script(25, 0);
+        
+        bytes first = transaction{1, 
+            list<input>{input{outpoint{txid{uint256{1}}, 0}, bytes{}, 0}}, 
+            list<output>{output{satoshi{1000}, script}, output{satoshi{2000}, script}}, 0}.write();
+        txid first_id = transaction::id(first);
+        
+        // spends an output of the first transaction which is not mine. 
+        bytes second = transaction{1, 
+            list<input>{input{outpoint{first_id, 1}, bytes{}, 0}}, 
+            list<output>{output{satoshi{1900}, script}}, 0}.write();
+        
+        bytes third = transaction{1, 
+            list<input>{input{outpoint{txid{uint256{2}}, 0}, bytes{}, 0}}, 
+            list<output>{output{satoshi{500}, script}}, 0}.write();
+        
+        balance_engine b{};
+        EXPECT_TRUE(b.ingest(first, timestamp{100}, {0}));
+        EXPECT_EQ(b.pending(), 1);
+        
+        // we have the first transaction, so there is nothing to remember. 
+        EXPECT_TRUE(b.ingest(second, timestamp{200}, {}));
+        EXPECT_EQ(b.pending(), 1);
+        
+        EXPECT_TRUE(b.ingest(third, timestamp{150}, {0}));
+        EXPECT_EQ(b.pending(), 2);
+        
+        EXPECT_EQ(b.prune(timestamp{120}), 1);
+        EXPECT_EQ(b.pending(), 1);
+        EXPECT_EQ(b.prune(timestamp{200}), 1);
+        EXPECT_EQ(b.pending(), 0);
+        EXPECT_EQ(b.balance(), satoshi{1500});
+    }
+    
+}
@@ -9,6 +9,7 @@
 #include <gigamonkey/types.hpp>
 #include <gigamonkey/spendable.hpp>
 #include <gigamonkey/address.hpp>
+#include <gigamonkey/addresses.hpp>
 #include <gigamonkey/signature.hpp>
 #include <gigamonkey/script/pattern.hpp>
 #include "gtest/gtest.h"
@@ -69,6 +70,33 @@ namespace Gigamonkey::Bitcoin {
         
     }
 
+    TEST(AddressTest, TestManyAddresses) {
+        std::vector<pubkey> keys;
+        for (uint64 i = 1; i <= 1000; i++) {
+            pubkey p = secp256k1::secret{secp256k1::coordinate{i}}.to_public();
+            keys.push_back(i % 2 == 0 ? p : p.decompress());
+        }
+        
+        // not a public key. 
+        keys.push_back(pubkey{bytes(10, 1)});
+        
+        work_stealing_pool pool{3};
+        addresses written = addresses::write(address::test, keys, pool);
+        ASSERT_EQ(written.size(), keys.size());
+        
+        std::string expected;
+        for (size_t i = 0; i < 1000; i++) {
+            std::string a = address{address::test, keys[i]}.write();
+            EXPECT_EQ(written[i], a);
+            expected += a + "\n";
+        }
+        
+        EXPECT_EQ(written[1000], "");
+        EXPECT_EQ(written.join(), expected + "\n");
+        
+        EXPECT_EQ(addresses::write(address::main, std::vector<pubkey>{}, pool).size(), 0);
+    }
+    
 }
 
 #pragma clang diagnostic pop
@@ -3,6 +3,7 @@
 
 #include <gigamonkey/address.hpp>
 #include "gtest/gtest.h"
+#include <random>
 
 namespace Gigamonkey::base58 {
 
@@ -18,4 +19,61 @@ namespace Gigamonkey::base58 {
         
     }
 
+    // the way that works for any size. 
+    std::string generic_encode(bytes_view b) {
+        bytes data = Bitcoin::append_checksum(b);
+        size_t zeros = 0;
+        while (zeros < data.size() && data[zeros] == 0) zeros++;
+        return std::string(zeros, '1') + encoding::base58::write(bytes_view(data).substr(zeros));
+    }
+    
+    template <size_t size> void test_fixed(std::mt19937& random) {
+        bytes all;
+        std::vector<std::string> expected;
+        for (int i = 0; i < 100; i++) {
+            bytes b(size);
+            for (byte& x : b) x = byte(random());
+            
+            // leading zeros are written as ones. 
+            for (int j = 0; j < i % 4; j++) b[j] = 0;
+            
+            std::string encoded = fixed<size>::encode(b);
+            EXPECT_EQ(encoded, generic_encode(b));
+            EXPECT_EQ(check::decode(encoded), check{b});
+            
+            byte decoded[size];
+            EXPECT_TRUE(fixed<size>::read(encoded, decoded));
+            EXPECT_EQ(bytes(decoded, decoded + size), b);
+            
+            // a change to any character is noticed. 
+            std::string changed = encoded;
+            changed[i % changed.size()] = changed[i % changed.size()] == 'z' ? 'y' : 'z';
+            EXPECT_FALSE(fixed<size>::read(changed, decoded));
+            
+            // so is an extra leading one. 
+            EXPECT_FALSE(fixed<size>::read("1" + encoded, decoded));
+            
+            all.insert(all.end(), b.begin(), b.end());
+            expected.push_back(encoded);
+        }
+        
+        EXPECT_EQ(fixed<size>::encode_all(all), expected);
+        
+        byte decoded[size];
+        EXPECT_FALSE(fixed<size>::read("", decoded));
+        EXPECT_FALSE(fixed<size>::read("0OIl", decoded));
+        EXPECT_EQ(fixed<size>::encode(bytes(size + 1, 1)), "");
+    }
+    
+    TEST(Base58Test, TestFixed) {
+        std::mt19937 random{1};
+        test_fixed<21>(random);
+        test_fixed<33>(random);
+        test_fixed<34>(random);
+        
+        // data of other sizes is not read. 
+        byte decoded[21];
+        EXPECT_FALSE(fixed<21>::read(fixed<33>::encode(bytes(33, 7)), decoded));
+    }
+
 }
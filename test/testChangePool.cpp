@@ -0,0 +1,115 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include <gigamonkey/change_pool.hpp>
+#include <set>
+#include "gtest/gtest.h"
+#include "keys.hpp"
+
+namespace Gigamonkey::Bitcoin {
+    
+    TEST(ChangePoolTest, TestBoundedQueue) {
+        bounded_queue<uint32> q{5};
+        EXPECT_EQ(q.capacity(), 8);
+        
+        uint32 x;
+        EXPECT_FALSE(q.pop(x));
+        for (uint32 i = 0; i < 8; i++) EXPECT_TRUE(q.push(uint32{i}));
+        EXPECT_FALSE(q.push(8));
+        EXPECT_EQ(q.size(), 8);
+        
+        for (uint32 i = 0; i < 8; i++) {
+            EXPECT_TRUE(q.pop(x));
+            EXPECT_EQ(x, i);
+        }
+        EXPECT_FALSE(q.pop(x));
+        
+        // every value is taken once when several threads push and pop. 
+        bounded_queue<uint32> shared{64};
+        std::vector<std::atomic<uint32>> taken(4000);
+        for (std::atomic<uint32>& t : taken) t = 0;
+        
+        std::vector<std::thread> threads;
+        for (uint32 t = 0; t < 2; t++) threads.emplace_back([&shared, t]() {
+            for (uint32 i = t * 2000; i < (t + 1) * 2000; i++) while (!shared.push(uint32{i})) std::this_thread::yield();
+        });
+        
+        std::atomic<uint32> count{0};
+        for (uint32 t = 0; t < 2; t++) threads.emplace_back([&shared, &taken, &count]() {
+            uint32 y;
+            while (count < 4000) if (shared.pop(y)) {
+                taken[y]++;
+                count++;
+            } else std::this_thread::yield();
+        });
+        
+        for (std::thread& t : threads) t.join();
+        for (const std::atomic<uint32>& t : taken) EXPECT_EQ(t, 1);
+    }
+    
+    TEST(ChangePoolTest, TestChangePool) {
+        ptr<output_pattern> pattern = std::make_shared<pay_to_address_pattern>();
+        
+        // the same change as from the pattern itself, in the same order. 
+        ptr<keysource> keys = std::make_shared<counting_keysource>(1);
+        change_pool pool{pattern, keys, 16};
+        
+        ptr<keysource> given = keys;
+        for (uint32 i = 0; i < 100; i++) {
+            change expected = pattern->create_redeemable(keys);
+            change c = pool.create_redeemable(given);
+            EXPECT_EQ(c.OutputScript, expected.OutputScript);
+            EXPECT_EQ(c.Redeemer->expected_size(), expected.Redeemer->expected_size());
+            
+            // the keysource that was passed in follows the change given out. 
+            EXPECT_EQ(given->first(), keys->first());
+        }
+        
+        EXPECT_EQ(given->first(), secret(secret::test, secp256k1::secret{secp256k1::coordinate{101}}));
+        
+        // the pool fills itself up again. 
+        while (pool.available() < 16) std::this_thread::yield();
+        
+        // change is never given out twice. 
+        std::mutex m;
+        std::set<bytes> scripts;
+        std::vector<std::thread> threads;
+        for (uint32 t = 0; t < 4; t++) threads.emplace_back([&pool, &m, &scripts]() {
+            for (uint32 i = 0; i < 50; i++) {
+                change c = pool.next();
+                std::lock_guard<std::mutex> lock{m};
+                scripts.insert(c.OutputScript);
+            }
+        });
+        
+        for (std::thread& t : threads) t.join();
+        EXPECT_EQ(scripts.size(), 200);
+    }
+    
+    // throws once the keys run past a limit. 
+    struct limited_pattern final : output_pattern {
+        uint64 Limit;
+        pay_to_address_pattern Pattern;
+        
+        limited_pattern(uint64 limit) : Limit{limit}, Pattern{} {}
+        
+        change create_redeemable(ptr<keysource>& k) const override {
+            if (std::static_pointer_cast<counting_keysource>(k)->Index > Limit) throw std::runtime_error{"out of keys"};
+            return Pattern.create_redeemable(k);
+        }
+        
+        uint32 expected_size() const override {
+            return Pattern.expected_size();
+        }
+    };
+    
+    TEST(ChangePoolTest, TestChangePoolError) {
+        change_pool pool{std::make_shared<limited_pattern>(3), std::make_shared<counting_keysource>(1), 16};
+        
+        // the change that was made is given out before the error. 
+        for (uint32 i = 0; i < 3; i++) EXPECT_NO_THROW(pool.next());
+        EXPECT_THROW(pool.next(), std::runtime_error);
+        EXPECT_THROW(pool.next(), std::runtime_error);
+    }
+    
+}
@@ -0,0 +1,94 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include <gigamonkey/coin_selection.hpp>
+#include "gtest/gtest.h"
+
+namespace Gigamonkey::Bitcoin {
+    
+    // a redeemer with the size of a pay to address script. 
+    struct test_redeemer final : redeemable {
+        redemption::incomplete redeem(sighash::directive) const override {
+            return {};
+        }
+        
+        uint32 expected_size() const override {
+            return 107;
+        }
+        
+        uint32 sigops() const override {
+            return 1;
+        }
+    };
+    
+    utxo_set test_utxos(std::vector<int64> values) {
+        ptr<redeemable> r = std::make_shared<test_redeemer>();
+        utxo_set u;
+        for (uint32 i = 0; i < values.size(); i++) 
+            u.insert(spendable{output{satoshi{values[i]}, bytes(25, 0)}, r, outpoint{txid{uint256{i + 1}}, i}});
+        return u;
+    }
+    
+    TEST(CoinSelectionTest, TestCoinSelection) {
+        
+        // one satoshi per byte. An input is 148 bytes. 
+        fee f{1, 0};
+        
+        utxo_set u = test_utxos({1148, 2148, 3148, 5148, 20000, 100000});
+        EXPECT_EQ(coin_selection::input_size(*u.oldest()), 148);
+        
+        // the payment and 100 bytes for the rest of the transaction 
+        // are covered exactly by the inputs of 3148 and 2148. 
+        coin_selection exact{satoshi{4900}, f, 100};
+        coin_selection::result r = exact.select(u);
+        EXPECT_TRUE(r.valid());
+        EXPECT_EQ(r.Method, coin_selection::branch_and_bound);
+        EXPECT_EQ(r.Inputs.size(), 2);
+        EXPECT_EQ(r.Change, satoshi{0});
+        EXPECT_EQ(r.Value, satoshi{5296});
+        EXPECT_EQ(r.Fee, satoshi{396});
+        EXPECT_EQ(r.Value, exact.Target + r.Fee);
+        
+        // nothing fits without change, so change is made. 
+        coin_selection with_change{satoshi{50000}, f, 100};
+        r = with_change.select(u);
+        EXPECT_TRUE(r.valid());
+        EXPECT_NE(r.Method, coin_selection::branch_and_bound);
+        EXPECT_GT(r.Change, satoshi{0});
+        EXPECT_EQ(r.Fee, with_change.fee(r.Inputs, true));
+        EXPECT_EQ(r.Value, with_change.Target + r.Fee + r.Change);
+        
+        // largest first alone. 
+        r = with_change.select_largest_first(u);
+        EXPECT_TRUE(r.valid());
+        EXPECT_EQ(r.Inputs.size(), 1);
+        EXPECT_EQ(r.Inputs[0].Value, satoshi{100000});
+        
+        // too much. 
+        EXPECT_FALSE(coin_selection(satoshi{200000}, f, 100).select(u).valid());
+        
+        // outputs worth less than the fee to spend them are never chosen. 
+        utxo_set small = test_utxos({100, 140, 147});
+        EXPECT_FALSE(coin_selection(satoshi{1}, f, 100).select(small).valid());
+        
+        // the search gives up after a limited number of steps. 
+        std::vector<int64> many;
+        for (int64 i = 0; i < 2000; i++) many.push_back(10000 + 37 * i);
+        utxo_set u_many = test_utxos(many);
+        coin_selection limited{satoshi{1234567}, f, 100};
+        limited.MaxTries = 1000;
+        r = limited.select(u_many);
+        EXPECT_TRUE(r.valid());
+        EXPECT_GE(r.Value, limited.Target + r.Fee);
+        
+        // with no fee and no dust, every candidate reaches a target of zero alone. 
+        coin_selection nothing{satoshi{0}, fee{0, 0}, 100, 0, satoshi{0}};
+        r = nothing.select_knapsack(u);
+        EXPECT_TRUE(r.valid());
+        EXPECT_EQ(r.Inputs.size(), 1);
+        EXPECT_EQ(r.Value, r.Change);
+        EXPECT_FALSE(nothing.select_knapsack(utxo_set{}).valid());
+        
+    }
+    
+}
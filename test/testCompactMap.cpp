@@ -0,0 +1,105 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include <gigamonkey/compact_map.hpp>
+#include "gtest/gtest.h"
+#include <map>
+#include <string>
+
+namespace Gigamonkey::Bitcoin {
+    
+    // every key has the same home slot, so everything 
+    // depends on probing and on shifting entries back. 
+    struct colliding_hash {
+        uint64 operator()(const outpoint&) const {
+            return 0;
+        }
+    };
+    
+    template <typename hash> void test_outpoint_map() {
+        compact_map<outpoint, satoshi, hash> m;
+        std::map<outpoint, satoshi> expected;
+        
+        for (uint32 i = 0; i < 1000; i++) {
+            outpoint o{txid{uint256{i / 4 + 1}}, i % 4};
+            EXPECT_TRUE(m.insert(o, satoshi{i}));
+            expected.emplace(o, satoshi{i});
+        }
+        
+        EXPECT_FALSE(m.insert(outpoint{txid{uint256{1}}, 0}, satoshi{5}));
+        EXPECT_EQ(*m.find(outpoint{txid{uint256{1}}, 0}), satoshi{0});
+        EXPECT_EQ(m.size(), 1000);
+        
+        // remove every third entry. 
+        for (uint32 i = 0; i < 1000; i += 3) {
+            outpoint o{txid{uint256{i / 4 + 1}}, i % 4};
+            EXPECT_TRUE(m.erase(o));
+            EXPECT_FALSE(m.erase(o));
+            expected.erase(o);
+        }
+        
+        EXPECT_EQ(m.size(), expected.size());
+        for (const auto& e : expected) {
+            const satoshi* v = m.find(e.first);
+            ASSERT_NE(v, nullptr);
+            EXPECT_EQ(*v, e.second);
+        }
+        
+        EXPECT_FALSE(m.contains(outpoint{txid{uint256{1}}, 0}));
+        EXPECT_FALSE(m.contains(outpoint{txid{uint256{2000}}, 0}));
+        
+        size_t count = 0;
+        m.for_each([&count, &expected](const outpoint& o, const satoshi& v) {
+            count++;
+            EXPECT_EQ(expected.at(o), v);
+        });
+        EXPECT_EQ(count, expected.size());
+        
+        compact_map<outpoint, satoshi, hash> copy{m};
+        m.clear();
+        EXPECT_TRUE(m.empty());
+        EXPECT_EQ(m.find(expected.begin()->first), nullptr);
+        EXPECT_EQ(copy.size(), expected.size());
+        EXPECT_TRUE(copy.contains(expected.begin()->first));
+    }
+    
+    TEST(CompactMapTest, TestOutpointMap) {
+        test_outpoint_map<compact_hash<outpoint>>();
+        test_outpoint_map<colliding_hash>();
+    }
+    
+    TEST(CompactMapTest, TestTxidMap) {
+        txid_map<uint32> m{100};
+        size_t capacity = m.capacity();
+        for (uint32 i = 0; i < 100; i++) EXPECT_TRUE(m.emplace(sha256(std::to_string(i)), i).second);
+        
+        // reserved space is enough. 
+        EXPECT_EQ(m.capacity(), capacity);
+        
+        for (uint32 i = 0; i < 100; i++) EXPECT_EQ(*m.find(sha256(std::to_string(i))), i);
+        *m.find(sha256(std::to_string(0))) = 7;
+        EXPECT_EQ(*m.find(sha256(std::to_string(0))), 7);
+    }
+    
+    TEST(CompactMapTest, TestSaltedHasher) {
+        digest256 d = sha256(std::string{"abc"});
+        
+        // the same salt gives the same hash. 
+        salted_hasher a{1, 2};
+        EXPECT_EQ(a(d), salted_hasher(1, 2)(d));
+        EXPECT_NE(a(d), salted_hasher(3, 2)(d));
+        
+        // every hasher has its own salt. 
+        EXPECT_NE(salted_hasher{}(d), salted_hasher{}(d));
+        
+        // outputs of the same transaction are spread apart. 
+        EXPECT_NE(a(d, 0), a(d, 1));
+        EXPECT_NE(a(d, 0) & 0xffff, a(d, 1) & 0xffff);
+        
+        // keys which agree in their lowest bits do not collide. 
+        digest256 e = d;
+        e.begin()[7] ^= 1;
+        EXPECT_NE(a(d) & 0xffff, a(e) & 0xffff);
+    }
+    
+}
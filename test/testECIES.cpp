@@ -8,6 +8,36 @@
 #include "gtest/gtest.h"
 
 namespace Gigamonkey::ECIES {
+    
+    bytes string_bytes(const std::string& s) {
+        bytes b(s.size());
+        std::copy(s.begin(), s.end(), b.begin());
+        return b;
+    }
+    
+    // a message which is not a multiple of the block size. 
+    bytes long_message() {
+        bytes b(100003);
+        for (size_t i = 0; i < b.size(); i++) b[i] = byte(i * 7 + i / 251);
+        return b;
+    }
+    
+    // chunks of many sizes, including empty ones. 
+    template <typename stream> bytes in_pieces(stream& s, bytes_view b) {
+        bytes out;
+        size_t size = 0;
+        while (b.size() > 0) {
+            size_t n = std::min(size, b.size());
+            bytes x = s.update(b.substr(0, n));
+            out.insert(out.end(), x.begin(), x.end());
+            b = b.substr(n);
+            size = size * 3 + 1;
+            if (size > 5000) size = 0;
+        }
+        bytes x = s.finalize();
+        out.insert(out.end(), x.begin(), x.end());
+        return out;
+    }
 
     TEST(ECIESTest, TestBitcore) {
         using namespace bitcore;
@@ -15,16 +45,15 @@ namespace Gigamonkey::ECIES {
         Bitcoin::secret aliceKey{"L1Ejc5dAigm5XrM3mNptMEsNnHzS7s51YxU7J61ewGshZTKkbmzJ"};
         Bitcoin::secret bobKey{"KxfxrUXSMjJQcb3JgnaaA6MqsrKQ1nBSxvhuigdKRyFiEm6BZDgG"};
         
-        // bitcore
+        // bitcore, with alice's key as the ephemeral key. 
         std::string message{"attack at dawn"};
         std::string encrypted{ "0339e504d6492b082da96e11e8f039796b06cd4855c101e2492a6f10f3e056a9e712c732611c6917ab5c57a1926973bc44a1586e94a783f81d05ce72518d9b0a80e2e13c7ff7d1306583f9cc7a48def5b37fbf2d5f294f128472a6e9c78dede5f5"};
         
-        bytes message_bytes(message.size());
-        std::copy(message.begin(), message.end(), message_bytes.begin());
+        bytes message_bytes = string_bytes(message);
         
-        bytes encrypted_bytes = encrypt(message_bytes, bobKey.Secret.to_public());
+        bytes encrypted_bytes = encrypt(message_bytes, bobKey.Secret.to_public(), aliceKey.Secret);
         
-        EXPECT_EQ(encrypted, encoding::hex::write(message_bytes));
+        EXPECT_EQ(encrypted, encoding::hex::write(encrypted_bytes));
         
         bytes decrypted_bytes = decrypt(encrypted_bytes, bobKey.Secret);
         
@@ -34,6 +63,8 @@ namespace Gigamonkey::ECIES {
         
         EXPECT_EQ(message_bytes, decrypted_bytes_alice);
         
+        EXPECT_THROW(decrypt(encrypted_bytes, aliceKey.Secret), std::invalid_argument);
+        
     }
 
     TEST(ECIESTest, TestElectrum) {
@@ -42,16 +73,15 @@ namespace Gigamonkey::ECIES {
         Bitcoin::secret aliceKey{"L1Ejc5dAigm5XrM3mNptMEsNnHzS7s51YxU7J61ewGshZTKkbmzJ"};
         Bitcoin::secret bobKey{"KxfxrUXSMjJQcb3JgnaaA6MqsrKQ1nBSxvhuigdKRyFiEm6BZDgG"};
         
-        // bitcore
+        // electrum, with alice's key as the ephemeral key. 
         std::string message{"attack at dawn"};
         std::string encrypted{"QklFMQM55QTWSSsILaluEejwOXlrBs1IVcEB4kkqbxDz4Fap56+ajq0hzmnaQJXwUMZ/DUNgEx9i2TIhCA1mpBFIfxWZy+sH6H+sqqfX3sPHsGu0ug=="};
         
-        bytes message_bytes(message.size());
-        std::copy(message.begin(), message.end(), message_bytes.begin());
+        bytes message_bytes = string_bytes(message);
         
-        bytes encrypted_bytes = encrypt(message_bytes, bobKey.Secret.to_public());
+        bytes encrypted_bytes = encrypt(message_bytes, bobKey.Secret.to_public(), aliceKey.Secret);
         
-        EXPECT_EQ(encrypted, encoding::base64::write(message_bytes));
+        EXPECT_EQ(encrypted, encoding::base64::write(encrypted_bytes));
         
         bytes decrypted_bytes = decrypt(encrypted_bytes, bobKey.Secret);
         
@@ -61,7 +91,101 @@ namespace Gigamonkey::ECIES {
         
         EXPECT_EQ(message_bytes, decrypted_bytes_alice);
         
+        EXPECT_THROW(decrypt(encrypted_bytes, aliceKey.Secret), std::invalid_argument);
+        
+    }
+    
+    TEST(ECIESTest, TestStream) {
+        Bitcoin::secret aliceKey{"L1Ejc5dAigm5XrM3mNptMEsNnHzS7s51YxU7J61ewGshZTKkbmzJ"};
+        Bitcoin::secret bobKey{"KxfxrUXSMjJQcb3JgnaaA6MqsrKQ1nBSxvhuigdKRyFiEm6BZDgG"};
+        secp256k1::pubkey bob = bobKey.Secret.to_public();
+        
+        bytes message = long_message();
+        
+        // the same as encrypting all at once. 
+        electrum::encryptor e{bob, aliceKey.Secret};
+        bytes encrypted = in_pieces(e, message);
+        EXPECT_EQ(encrypted, electrum::encrypt(message, bob, aliceKey.Secret));
+        
+        electrum::decryptor d{bobKey.Secret};
+        EXPECT_EQ(in_pieces(d, encrypted), message);
+        
+        bitcore::encryptor be{bob};
+        bytes bitcore_encrypted = in_pieces(be, message);
+        EXPECT_EQ(bitcore::decrypt(bitcore_encrypted, bobKey.Secret), message);
+        
+        bitcore::decryptor bd{bobKey.Secret};
+        EXPECT_EQ(in_pieces(bd, bitcore_encrypted), message);
+        
+        // a message which was changed is rejected at the end. 
+        bytes changed = encrypted;
+        changed[changed.size() / 2] ^= 1;
+        electrum::decryptor dc{bobKey.Secret};
+        EXPECT_THROW(in_pieces(dc, changed), std::invalid_argument);
+        
+        // so is one that was cut short. 
+        electrum::decryptor ds{bobKey.Secret};
+        EXPECT_THROW(in_pieces(ds, bytes_view{encrypted}.substr(0, encrypted.size() - 1)), std::invalid_argument);
+        
+        // an empty message. 
+        EXPECT_EQ(electrum::decrypt(electrum::encrypt(bytes{}, bob), bobKey.Secret), bytes{});
+        EXPECT_EQ(bitcore::decrypt(bitcore::encrypt(bytes{}, bob), bobKey.Secret), bytes{});
     }
 
-}
+    TEST(ECIESTest, TestSession) {
+        Bitcoin::secret aliceKey{"L1Ejc5dAigm5XrM3mNptMEsNnHzS7s51YxU7J61ewGshZTKkbmzJ"};
+        Bitcoin::secret bobKey{"KxfxrUXSMjJQcb3JgnaaA6MqsrKQ1nBSxvhuigdKRyFiEm6BZDgG"};
+        secp256k1::pubkey alice = aliceKey.Secret.to_public();
+        secp256k1::pubkey bob = bobKey.Secret.to_public();
+        
+        bytes message = string_bytes("attack at dawn");
+        
+        // an electrum session only decrypts. Keys are derived once 
+        // for a sender which reuses its ephemeral key. 
+        electrum::session bob_electrum{bobKey.Secret, 2};
+        
+        for (int i = 0; i < 3; i++) 
+            EXPECT_EQ(bob_electrum.decrypt(electrum::encrypt(message, bob, aliceKey.Secret)), message);
+        
+        EXPECT_EQ(bob_electrum.cache().misses(), 1);
+        EXPECT_EQ(bob_electrum.cache().hits(), 2);
+        
+        // messages with new ephemeral keys can be decrypted too. 
+        bytes first = electrum::encrypt(message, bob);
+        bytes second = electrum::encrypt(message, bob);
+        EXPECT_NE(first, second);
+        EXPECT_EQ(bob_electrum.decrypt(first), message);
+        EXPECT_EQ(bob_electrum.decrypt(second), message);
+        EXPECT_EQ(bob_electrum.cache().size(), 2);
+        
+        // a bitcore session uses our key in place of the ephemeral 
+        // key, but each message has its own IV. 
+        bitcore::session alice_bitcore{aliceKey.Secret};
+        bitcore::session bob_bitcore{bobKey.Secret};
+        
+        bytes previous{};
+        for (int i = 0; i < 3; i++) {
+            bytes encrypted = alice_bitcore.encrypt(message, bob);
+            EXPECT_NE(encrypted, previous);
+            EXPECT_NE(encrypted, bitcore::encrypt(message, bob, aliceKey.Secret));
+            EXPECT_EQ(bob_bitcore.decrypt(encrypted), message);
+            EXPECT_EQ(bitcore::decrypt(encrypted, bobKey.Secret), message);
+            previous = encrypted;
+        }
+        
+        // keys are derived once. 
+        EXPECT_EQ(alice_bitcore.cache().misses(), 1);
+        EXPECT_EQ(alice_bitcore.cache().hits(), 2);
+        EXPECT_EQ(bob_bitcore.cache().misses(), 1);
+        
+        // streams in both directions. 
+        bytes long_one = long_message();
+        bitcore::encryptor e = bob_bitcore.encrypting(alice);
+        bitcore::decryptor d = alice_bitcore.decrypting();
+        EXPECT_EQ(in_pieces(d, in_pieces(e, long_one)), long_one);
+        EXPECT_EQ(alice_bitcore.cache().size(), 1);
+        
+        EXPECT_THROW(bob_bitcore.decrypt(alice_bitcore.encrypt(message, alice)), std::invalid_argument);
+    }
 
+}
@@ -0,0 +1,50 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include <gigamonkey/hash.hpp>
+#include "gtest/gtest.h"
+
+namespace Gigamonkey::Bitcoin {
+    
+    TEST(HashTest, TestHash160Batch) {
+        EXPECT_EQ(hash160_batch(std::vector<bytes_view>{bytes_view{}})[0], 
+            digest160{"b472a266d0bd89c13706a4132ccfb16f7c3b9fcb"});
+        
+        // every length up to two blocks, so that some messages are 
+        // hashed together and some are hashed one at a time. 
+        std::vector<bytes> messages;
+        for (size_t n = 0; n <= 128; n++) {
+            bytes b(n);
+            for (size_t i = 0; i < n; i++) b[i] = byte(i * 7 + n);
+            messages.push_back(b);
+        }
+        
+        // and a number of public keys which is not a multiple of the number of lanes. 
+        for (int i = 0; i < 13; i++) messages.push_back(sha256(std::to_string(i)));
+        
+        for (size_t size : {size_t{0}, size_t{1}, size_t{7}, size_t{8}, size_t{9}, messages.size()}) {
+            std::vector<bytes_view> views(messages.begin(), messages.begin() + size);
+            std::vector<digest160> digests = hash160_batch(views);
+            ASSERT_EQ(digests.size(), size);
+            for (size_t i = 0; i < size; i++) EXPECT_EQ(digests[i], hash160(views[i])) << "message " << i;
+        }
+    }
+    
+    TEST(HashTest, TestHashWriter) {
+        digest256 a = sha256(std::string{"a"});
+        digest256 b = sha256(std::string{"b"});
+        bytes data = write(77, a, byte(7), uint32_big{0x01020304}, uint64_little{5}, b);
+        
+        EXPECT_EQ((sha256_writer{} << a << byte(7) << uint32_big{0x01020304} << uint64_little{5} << b).finalize(), sha256(data));
+        EXPECT_EQ((hash256_writer{} << a << byte(7) << uint32_big{0x01020304} << uint64_little{5} << b).finalize(), hash256(data));
+        
+        // written a piece at a time. 
+        hash256_writer w{};
+        for (byte x : data) w << x;
+        EXPECT_EQ(w.finalize(), hash256(data));
+        
+        EXPECT_EQ(sha256_writer{}.finalize(), sha256(bytes{}));
+        EXPECT_EQ(hash256_writer{}.finalize(), hash256(bytes{}));
+    }
+    
+}
@@ -0,0 +1,183 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include <gigamonkey/caching_ledger.hpp>
+#include <gigamonkey/local_ledger.hpp>
+#include <cstdlib>
+#include <filesystem>
+#include "gtest/gtest.h"
+
+namespace Gigamonkey::Bitcoin {
+    
+    // a ledger in memory which counts how often it is asked for something. 
+    struct memory_ledger final : ledger {
+        std::map<txid, double_entry> Transactions;
+        
+        mutable uint32 Lookups{0};
+        mutable uint32 Batches{0};
+        mutable uint32 Looked{0};
+        
+        txid add(const bytes& tx) {
+            txid id = transaction::id(tx);
+            Transactions[id] = double_entry{std::make_shared<bytes>(tx)};
+            return id;
+        }
+        
+        list<block_header> headers(uint64) override {
+            return {};
+        }
+        
+        data::entry<txid, double_entry> transaction(const txid& id) const override {
+            Lookups++;
+            Looked++;
+            auto it = Transactions.find(id);
+            return data::entry<txid, double_entry>{id, it == Transactions.end() ? double_entry{} : it->second};
+        }
+        
+        std::vector<data::entry<txid, double_entry>> transactions(const std::vector<txid>& ids) const override {
+            Batches++;
+            std::vector<data::entry<txid, double_entry>> x;
+            for (const txid& id : ids) {
+                Looked++;
+                auto it = Transactions.find(id);
+                x.push_back(data::entry<txid, double_entry>{id, it == Transactions.end() ? double_entry{} : it->second});
+            }
+            return x;
+        }
+        
+        block_header header(const digest256&) const override {
+            return {};
+        }
+        
+        bytes block(const digest256&) const override {
+            return {};
+        }
+    };
+    
+    TEST(LedgerTest, TestCachingLedger) {
+        bytes script(25, 0);
+        
+        auto backend = std::make_shared<memory_ledger>();
+        
+        std::vector<txid> parents;
+        for (uint32 i = 0; i < 3; i++) parents.push_back(backend->add(transaction{1, 
+            list<input>{input{outpoint{txid{uint256{i + 1}}, 0}, bytes{}, 0}}, 
+            list<output>{output{satoshi{1000}, script}, output{satoshi{2000}, script}, output{satoshi{3000}, script}}, 0}.write()));
+        
+        // spends every output of every parent. 
+        list<input> inputs;
+        for (const txid& p : parents) for (uint32 i = 0; i < 3; i++) inputs = inputs << input{outpoint{p, i}, bytes{}, 0};
+        ledger::double_entry child{std::make_shared<bytes>(transaction{1, inputs, list<output>{output{satoshi{5000}, script}}, 0}.write())};
+        
+        // each parent is asked for once, all in one batch. 
+        ledger::vertex v = backend->make_vertex(child);
+        EXPECT_EQ(backend->Batches, 1);
+        EXPECT_EQ(backend->Looked, 3);
+        EXPECT_EQ(v.spent(), satoshi{18000});
+        
+        caching_ledger cache{backend, 2};
+        backend->Batches = 0;
+        backend->Looked = 0;
+        
+        // the cache holds the two most recent. 
+        v = cache.make_vertex(child);
+        EXPECT_EQ(v.spent(), satoshi{18000});
+        EXPECT_EQ(backend->Batches, 1);
+        EXPECT_EQ(backend->Looked, 3);
+        EXPECT_EQ(cache.size(), 2);
+        EXPECT_EQ(cache.misses(), 3);
+        
+        v = cache.make_vertex(child);
+        EXPECT_EQ(v.spent(), satoshi{18000});
+        EXPECT_EQ(backend->Batches, 2);
+        EXPECT_EQ(backend->Looked, 4);
+        EXPECT_EQ(cache.hits(), 2);
+        
+        // parents are asked for in order, so the first was missing 
+        // and was put back in place of the least recently used. 
+        txid first = *std::min_element(parents.begin(), parents.end());
+        EXPECT_TRUE(cache.transaction(first).Value.valid());
+        EXPECT_EQ(backend->Lookups, 0);
+        EXPECT_EQ(cache.hits(), 3);
+        
+        // unknown transactions are not remembered. 
+        EXPECT_FALSE(cache.transaction(txid{uint256{99}}).Value.valid());
+        EXPECT_FALSE(cache.transaction(txid{uint256{99}}).Value.valid());
+        EXPECT_EQ(backend->Lookups, 2);
+        EXPECT_EQ(cache.size(), 2);
+    }
+    
+    TEST(LedgerTest, TestLocalLedger) {
+        char name[] = "/tmp/local_ledger_XXXXXX";
+        ASSERT_NE(mkdtemp(name), nullptr);
+        std::string directory{name};
+        
+        bytes script(25, 0);
+        std::vector<bytes> txs;
+        for (uint32 i = 0; i < 1000; i++) txs.push_back(transaction{1, 
+            list<input>{input{outpoint{txid{uint256{i + 1}}, 0}, bytes(i % 100, 0), 0}}, 
+            list<output>{output{satoshi{1000 + i}, script}}, 0}.write());
+        
+        Bitcoin::block g = genesis();
+        bytes b = g.write();
+        txid coinbase = g.Transactions.first().id();
+        
+        {
+            // small segments so that records are spread over many files. 
+            local_ledger l{directory, 1 << 14};
+            for (const bytes& tx : txs) EXPECT_TRUE(l.add_transaction(tx));
+            EXPECT_FALSE(l.add_transaction(txs[0]));
+            EXPECT_FALSE(l.add_transaction(bytes{1, 2, 3}));
+            
+            // a block is added with proofs for all its transactions. 
+            EXPECT_TRUE(l.add_block(b));
+            EXPECT_EQ(l.size(), 1001);
+            EXPECT_EQ(l.height(), 1);
+            
+            // the header is out of order the second time. 
+            EXPECT_FALSE(l.add_header(g.Header));
+        }
+        
+        local_ledger l{directory, 1 << 14};
+        EXPECT_EQ(l.size(), 1001);
+        EXPECT_EQ(l.height(), 1);
+        
+        for (const bytes& tx : txs) {
+            txid id = Bitcoin::transaction::id(tx);
+            EXPECT_EQ(l.view(id), bytes_view{tx});
+            
+            ledger::double_entry e = l.transaction(id).Value;
+            ASSERT_TRUE(e.valid());
+            EXPECT_EQ(*e, tx);
+            EXPECT_FALSE(e.confirmed());
+        }
+        
+        ledger::double_entry c = l.transaction(coinbase).Value;
+        ASSERT_TRUE(c.valid());
+        EXPECT_TRUE(c.confirmed());
+        
+        digest256 hash = g.Header.hash();
+        EXPECT_EQ(l.header(hash).Hash, hash);
+        EXPECT_EQ(l.header(g.Header.MerkleRoot).Hash, hash);
+        EXPECT_EQ(l.header(hash).Height, N{0});
+        EXPECT_EQ(l.block(hash), b);
+        EXPECT_EQ(l.headers(0).size(), 1);
+        
+        EXPECT_FALSE(l.transaction(txid{uint256{99}}).Value.valid());
+        
+        // many at once, in order, including one that is not known. 
+        std::vector<data::entry<txid, ledger::double_entry>> many = 
+            l.transactions(std::vector<txid>{coinbase, txid{uint256{99}}, Bitcoin::transaction::id(txs[7])});
+        ASSERT_EQ(many.size(), 3);
+        EXPECT_TRUE(many[0].Value.confirmed());
+        EXPECT_FALSE(many[1].Value.valid());
+        EXPECT_EQ(many[1].Key, txid{uint256{99}});
+        EXPECT_EQ(*many[2].Value, txs[7]);
+        
+        EXPECT_EQ(l.view(txid{uint256{99}}).size(), 0);
+        EXPECT_EQ(l.block(txid{uint256{99}}).size(), 0);
+        
+        std::filesystem::remove_all(directory);
+    }
+    
+}
@@ -0,0 +1,157 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include <gigamonkey/payout.hpp>
+#include <gigamonkey/script/validation.hpp>
+#include "gtest/gtest.h"
+#include "keys.hpp"
+#include <map>
+
+namespace Gigamonkey::Bitcoin {
+    
+    // the outputs which may be spent, including the change of earlier payouts. 
+    struct spent_outputs {
+        std::map<outpoint, output> Outputs;
+        
+        void add(const funds& f) {
+            f.Entries.by_value([this](const spendable& s) {
+                Outputs[s.Outpoint] = output{s.Value, s.Script};
+            });
+        }
+        
+        // every input of every transaction must be valid. 
+        void check(const payout::result& r, work_stealing_pool& pool) {
+            for (const payout::batch& b : r.Batches) {
+                indexed_transaction t = indexed_transaction::read(b.Transaction);
+                
+                std::vector<output> previous;
+                for (const input& in : t.Inputs) {
+                    auto o = Outputs.find(in.Outpoint);
+                    ASSERT_NE(o, Outputs.end());
+                    previous.push_back(o->second);
+                }
+                
+                spending x{b.Transaction, {}};
+                for (const output& o : previous) x.Spent.push_back(transaction_view::output{o.Value, o.Script});
+                
+                script_validation v = validate_scripts(x, pool);
+                EXPECT_EQ(v.Inputs.size(), t.Inputs.size());
+                EXPECT_TRUE(v.valid());
+                
+                for (uint32 i = 0; i < t.Outputs.size(); i++) Outputs[outpoint{b.ID, i}] = t.Outputs[i];
+            }
+        }
+    };
+    
+    TEST(PayoutTest, TestPayout) {
+        
+        ptr<keysource> keys = std::make_shared<counting_keysource>(1);
+        ptr<output_pattern> change = std::make_shared<pay_to_address_pattern>();
+        
+        funds f{};
+        for (uint32 i = 0; i < 30; i++) f.add(pay_to_address_spendable(keys, i, satoshi{100000}));
+        
+        std::vector<payment> payments;
+        for (uint32 i = 0; i < 300; i++) payments.push_back(payment{satoshi{1000 + i}, bytes(25, byte(i))});
+        satoshi sent{0};
+        for (const payment& p : payments) sent = sent + p.Value;
+        
+        payout small{fee{1, 0}, change, 4000};
+        
+        work_stealing_pool pool{2};
+        uint64 first_key = std::static_pointer_cast<counting_keysource>(keys)->Index;
+        payout::result r = small.pay(payments, f, keys, pool);
+        ASSERT_TRUE(r.valid());
+        EXPECT_GT(r.Batches.size(), 1);
+        
+        // a key is taken for each change output and no others. 
+        uint64 changes = 0;
+        for (const payout::batch& b : r.Batches) if (b.Change != satoshi{0}) changes++;
+        EXPECT_EQ(std::static_pointer_cast<counting_keysource>(keys)->Index, first_key + changes);
+        
+        spent_outputs spent{};
+        spent.add(f);
+        spent.check(r, pool);
+        
+        uint32 paid = 0;
+        satoshi fees{0};
+        for (const payout::batch& b : r.Batches) {
+            EXPECT_LE(b.Transaction.size(), small.MaxSize);
+            
+            indexed_transaction t = indexed_transaction::read(b.Transaction);
+            EXPECT_TRUE(t.valid());
+            EXPECT_EQ(t.id(), b.ID);
+            EXPECT_EQ(t.Outputs.size(), b.Payments + (b.Change == satoshi{0} ? 0 : 1));
+            
+            // the payments are made in order. 
+            for (uint32 i = 0; i < b.Payments; i++) {
+                EXPECT_EQ(t.Outputs[i].Value, payments[paid + i].Value);
+                EXPECT_EQ(t.Outputs[i].Script, payments[paid + i].Script);
+            }
+            
+            // the fee is at least what was asked. 
+            EXPECT_GE(b.Fee, small.Fee.calculate(b.Transaction.size(), 0));
+            
+            paid += b.Payments;
+            fees = fees + b.Fee;
+        }
+        
+        EXPECT_EQ(paid, payments.size());
+        EXPECT_EQ(fees, r.Fee);
+        EXPECT_EQ(r.Remainder.Value, f.Value - sent - r.Fee);
+        
+        // change outputs are in the remainder and can be spent. 
+        payout::result again = small.pay(std::vector<payment>{payments[0]}, r.Remainder, keys, pool);
+        EXPECT_TRUE(again.valid());
+        spent.check(again, pool);
+        
+        // payments below the dust limit are not made. 
+        ptr<keysource> unchanged = keys;
+        EXPECT_FALSE(small.pay(std::vector<payment>{payment{satoshi{545}, bytes(25, 0)}}, f, keys, pool).valid());
+        
+        // not enough funds. 
+        std::vector<payment> too_much{payment{satoshi{3000000}, bytes(25, 0)}};
+        EXPECT_FALSE(small.pay(too_much, f, keys, pool).valid());
+        
+        // one payment too large for any transaction. 
+        EXPECT_FALSE(small.pay(std::vector<payment>{payment{satoshi{1000}, bytes(4000, 0)}}, f, keys, pool).valid());
+        
+        // no keys are used when there is no payout. 
+        EXPECT_EQ(keys, unchanged);
+        
+    }
+
+    // so many small outputs are needed that the inputs do not 
+    // fit in the space kept for them, so the payments are split again. 
+    TEST(PayoutTest, TestSplitAgain) {
+        
+        ptr<keysource> keys = std::make_shared<counting_keysource>(1);
+        ptr<output_pattern> change = std::make_shared<pay_to_address_pattern>();
+        
+        funds f{};
+        for (uint32 i = 0; i < 200; i++) f.add(pay_to_address_spendable(keys, i, satoshi{700}));
+        
+        std::vector<payment> payments;
+        for (uint32 i = 0; i < 20; i++) payments.push_back(payment{satoshi{1000}, bytes(25, byte(i))});
+        
+        payout small{fee{1, 0}, change, 4000};
+        
+        work_stealing_pool pool{2};
+        payout::result r = small.pay(payments, f, keys, pool);
+        ASSERT_TRUE(r.valid());
+        EXPECT_GT(r.Batches.size(), 1);
+        
+        uint32 paid = 0;
+        for (const payout::batch& b : r.Batches) {
+            EXPECT_LE(b.Transaction.size(), small.MaxSize);
+            paid += b.Payments;
+        }
+        
+        EXPECT_EQ(paid, payments.size());
+        
+        spent_outputs spent{};
+        spent.add(f);
+        spent.check(r, pool);
+    }
+    
+}
@@ -0,0 +1,317 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include <gigamonkey/script/pattern.hpp>
+#include <gigamonkey/script/classifier.hpp>
+#include <gigamonkey/script/machine.hpp>
+#include <gigamonkey/boost/boost.hpp>
+#include "gtest/gtest.h"
+
+namespace Gigamonkey::Bitcoin {
+    
+    TEST(ScriptTest, TestInstructionView) {
+        
+        bytes pubkey_hash(20, 0x11);
+        bytes long_push(300, 0x22);
+        
+        program p{OP_DUP, OP_HASH160, push_data(pubkey_hash), OP_EQUALVERIFY, OP_CHECKSIG,
+            OP_1, OP_16, push_data(long_push), OP_FALSE, OP_RETURN};
+        
+        bytes script = compile(p);
+        
+        // iterating over the script gives the same instructions as decompiling it.
+        program decompiled = decompile(script);
+        EXPECT_EQ(decompiled, p);
+        
+        list<instruction> viewed{};
+        for (const instruction_view& i : instructions{script}) {
+            EXPECT_TRUE(i.valid());
+            viewed = viewed << instruction(i);
+        }
+        
+        EXPECT_EQ(viewed, p);
+        
+        // push data points into the script rather than being copied.
+        instructions::iterator push = ++(++instructions{script}.begin());
+        EXPECT_EQ(push->Op, OP_PUSHSIZE20);
+        EXPECT_EQ(push->Data.data(), script.data() + 3);
+        EXPECT_EQ(push->Data.size(), 20);
+        EXPECT_EQ(push->length(), 21);
+        
+        EXPECT_TRUE(instructions{script}.valid());
+        
+        // small numbers are pushed by op codes.
+        byte sixteen[] {0x10};
+        byte negative_one[] {0x81};
+        EXPECT_EQ(instruction_view{OP_16}.data(), bytes_view(sixteen, 1));
+        EXPECT_EQ(instruction_view{OP_1NEGATE}.data(), bytes_view(negative_one, 1));
+        
+        // a truncated push is invalid.
+        bytes truncated = compile(program{OP_DUP, push_data(pubkey_hash)});
+        truncated.resize(truncated.size() - 1);
+        
+        EXPECT_FALSE(instructions{truncated}.valid());
+        EXPECT_EQ(decompile(truncated), program{});
+        
+        uint32 count = 0;
+        bool last_valid = true;
+        for (const instruction_view& i : instructions{truncated}) {
+            count++;
+            last_valid = i.valid();
+        }
+        
+        EXPECT_EQ(count, 2);
+        EXPECT_FALSE(last_valid);
+        
+        // anything can come after OP_RETURN.
+        bytes op_return = compile(program{OP_FALSE, OP_RETURN});
+        op_return.resize(3);
+        op_return[2] = OP_PUSHDATA4;
+        EXPECT_TRUE(instructions{op_return}.valid());
+        
+        EXPECT_FALSE(instructions{bytes{}}.valid());
+        
+        // patterns are matched over views of the script.
+        EXPECT_EQ(pay_to_address{pay_to_address::script(digest160{uint160{7}})}.Address, digest160{uint160{7}});
+        
+    }
+
+    TEST(ScriptTest, TestValidProgram) {
+        
+        list<program> valid_programs{
+            program{OP_TRUE}, 
+            program{OP_IF, OP_TRUE, OP_ENDIF}, 
+            program{OP_NOTIF, OP_TRUE, OP_ELSE, OP_FALSE, OP_ENDIF}, 
+            program{OP_IF, OP_IF, OP_TRUE, OP_ENDIF, OP_ELSE, OP_FALSE, OP_ENDIF}, 
+            program{OP_FALSE, OP_RETURN}};
+        
+        list<program> invalid_programs{
+            program{}, 
+            program{OP_IF, OP_TRUE}, 
+            program{OP_ENDIF}, 
+            program{OP_ELSE, OP_ENDIF}, 
+            program{OP_IF, OP_ELSE, OP_ELSE, OP_ENDIF}, 
+            program{OP_TRUE, OP_INVALIDOPCODE}};
+        
+        for (const program& p : valid_programs) {
+            EXPECT_TRUE(valid(p));
+            EXPECT_TRUE(valid_program(compile(p)));
+        }
+        
+        for (const program& p : invalid_programs) {
+            EXPECT_FALSE(valid(p));
+            EXPECT_FALSE(valid_program(compile(p)));
+        }
+        
+        // decompile stops at OP_RETURN inside an IF, so the IF is not closed. 
+        bytes return_in_if = compile(program{OP_IF, OP_RETURN, OP_ENDIF});
+        EXPECT_FALSE(valid(decompile(return_in_if)));
+        EXPECT_FALSE(valid_program(return_in_if));
+        
+        for (const program& p : valid_programs) EXPECT_EQ(valid_program(compile(p)), valid(decompile(compile(p))));
+        for (const program& p : invalid_programs) EXPECT_EQ(valid_program(compile(p)), valid(decompile(compile(p))));
+        
+        EXPECT_TRUE(provably_prunable(safe_op_return(bytes(10, 0x01))));
+        EXPECT_FALSE(provably_prunable(program{OP_RETURN}));
+        EXPECT_FALSE(provably_prunable(program{OP_TRUE, OP_FALSE, OP_RETURN}));
+        
+        // compiled size is exact, including data after OP_RETURN. 
+        bytes pushes(1000, 0x02);
+        program p{push_data(pushes), OP_DROP, OP_FALSE, instruction::op_return(pushes)};
+        EXPECT_EQ(compile(p).size(), length(p));
+        EXPECT_EQ(length(p), 1003 + 1 + 1 + 1001);
+        
+    }
+    
+    TEST(ScriptTest, TestCompiledPattern) {
+        
+        bytes hash(20, 0x11);
+        bytes pubkey(33, 0x02);
+        bytes pushed(300, 0x22);
+        
+        bytes p2pkh = pay_to_address::script(digest160{uint160{7}});
+        bytes p2pk = compile(program{push_data(pubkey), OP_CHECKSIG});
+        bytes op_return = compile(program{OP_FALSE, OP_RETURN, push_data(pushed), push_data(hash)});
+        bytes multisig = compile(program{OP_2, push_data(pubkey), push_data(pubkey), push_data(pubkey), OP_3, OP_CHECKMULTISIG});
+        bytes truncated = p2pkh;
+        truncated.resize(truncated.size() - 1);
+        
+        list<bytes> scripts{p2pkh, p2pk, op_return, multisig, truncated, bytes{}};
+        
+        bytes captured_a;
+        bytes captured_b;
+        list<Bitcoin::pattern> patterns{
+            pay_to_address::pattern(captured_a), 
+            pay_to_pubkey::pattern(captured_a), 
+            op_return_data::pattern(), 
+            Bitcoin::pattern{push{2}, repeated{push_size{33}, 1}, push{3}, OP_CHECKMULTISIG}, 
+            Bitcoin::pattern{optional{push_size{20, captured_a}}, repeated{alternatives{OP_DUP, push{captured_b}}, 1, 3}, any{}}};
+        
+        // the compiled pattern agrees with the pattern it was compiled from. 
+        for (const Bitcoin::pattern& p : patterns) {
+            compiled_pattern c{p};
+            EXPECT_TRUE(c.valid());
+            for (const bytes& script : scripts) {
+                captured_a = bytes{};
+                captured_b = bytes{};
+                bool expected = p.match(script);
+                bytes expected_a = captured_a;
+                bytes expected_b = captured_b;
+                
+                captured_a = bytes{};
+                captured_b = bytes{};
+                EXPECT_EQ(c.match(script), expected);
+                if (expected) {
+                    EXPECT_EQ(captured_a, expected_a);
+                    EXPECT_EQ(captured_b, expected_b);
+                }
+            }
+        }
+        
+        // captures are views into the script. 
+        compiled_pattern address{pay_to_address::pattern(captured_a)};
+        EXPECT_EQ(address.captures(), 1);
+        bytes_view captured;
+        EXPECT_TRUE(address.match(p2pkh, &captured));
+        EXPECT_EQ(captured.data(), p2pkh.data() + 3);
+        EXPECT_EQ(captured.size(), 20);
+        EXPECT_FALSE(address.match(p2pk, &captured));
+        
+        // a branch that fails does not leave its capture behind. 
+        compiled_pattern backtrack{Bitcoin::pattern{alternatives{
+            Bitcoin::pattern{push_size{20, captured_a}, OP_DUP}, 
+            Bitcoin::pattern{push_size{20}, OP_HASH160}}}};
+        bytes_view slot;
+        EXPECT_TRUE(backtrack.match(compile(program{push_data(hash), OP_HASH160}), &slot));
+        EXPECT_TRUE(slot.data() == nullptr);
+        
+        // numbers are matched by value. 
+        compiled_pattern negative{Bitcoin::pattern{push{-133}}};
+        byte minus_133[] {0x85, 0x80};
+        EXPECT_TRUE(negative.match(compile(program{push_data(bytes_view(minus_133, 2))})));
+        EXPECT_FALSE(negative.match(compile(program{OP_1NEGATE})));
+        
+    }
+    
+    TEST(ScriptTest, TestScriptClassifier) {
+        
+        bytes compressed(33, 0x02);
+        bytes uncompressed(65, 0x04);
+        bytes pushed(100, 0x22);
+        digest160 address{uint160{7}};
+        
+        bytes p2pkh = pay_to_address::script(address);
+        bytes p2pk = pay_to_pubkey::script(pubkey{uncompressed});
+        bytes op_return = compile(program{OP_FALSE, OP_RETURN, push_data(pushed), OP_1});
+        bytes multisig = compile(program{OP_2, push_data(compressed), push_data(uncompressed), push_data(compressed), OP_3, OP_CHECKMULTISIG});
+        bytes boost_script = Boost::output_script::contract(1, uint256{}, work::compact{32, 0x0080ff}, bytes{}, 0, bytes{}, address).write();
+        
+        script_classifier::classification x = script_classifier::classify(p2pkh);
+        EXPECT_EQ(x.Type, script_classifier::pay_to_address);
+        EXPECT_EQ(x.Hash160, bytes_view(address));
+        EXPECT_EQ(x.Hash160.data(), p2pkh.data() + 3);
+        
+        x = script_classifier::classify(p2pk);
+        EXPECT_EQ(x.Type, script_classifier::pay_to_pubkey);
+        EXPECT_EQ(x.Pubkey, bytes_view(uncompressed));
+        
+        x = script_classifier::classify(op_return);
+        EXPECT_EQ(x.Type, script_classifier::op_return_data);
+        uint32 count = 0;
+        for (const instruction_view& i : instructions{x.Pushes}) count++;
+        EXPECT_EQ(count, 2);
+        EXPECT_EQ(instruction_view::read(x.Pushes).data(), bytes_view(pushed));
+        
+        x = script_classifier::classify(multisig);
+        EXPECT_EQ(x.Type, script_classifier::multisig);
+        EXPECT_EQ(x.Required, 2);
+        EXPECT_EQ(x.Pushes.size(), 3 * 34 + 32);
+        
+        x = script_classifier::classify(boost_script);
+        EXPECT_EQ(x.Type, script_classifier::boost);
+        EXPECT_EQ(x.Hash160, bytes_view(address));
+        
+        // scripts which are almost but not quite standard. 
+        bytes truncated = p2pkh;
+        truncated.resize(24);
+        bytes wrong_count = compile(program{OP_2, push_data(compressed), push_data(compressed), OP_3, OP_CHECKMULTISIG});
+        bytes not_pushes = compile(program{OP_RETURN, OP_DUP});
+        bytes wrong_prefix = boost_script;
+        wrong_prefix[1] = 0x00;
+        
+        for (const bytes& b : list<bytes>{bytes{}, truncated, wrong_count, not_pushes, wrong_prefix, compile(program{OP_DUP})}) 
+            EXPECT_EQ(script_classifier::classify(b).Type, script_classifier::unknown);
+        
+        // all the outputs of a transaction. 
+        bytes tx = transaction{
+            list<input>{input{outpoint{txid{uint256{1}}, 0}, compile(program{push_data(compressed)})}}, 
+            list<output>{output{satoshi{1000}, p2pkh}, output{satoshi{0}, op_return}, output{satoshi{2000}, multisig}, output{satoshi{1}, not_pushes}}, 
+            0}.write();
+        
+        transaction_view view{tx};
+        EXPECT_TRUE(view.valid());
+        EXPECT_EQ(view.Inputs.size(), 1);
+        EXPECT_EQ(view.Outputs.size(), 4);
+        EXPECT_EQ(int64(view.Outputs[2].Value), 2000);
+        EXPECT_EQ(view.id(), transaction{tx}.id());
+        
+        std::vector<script_classifier::classification> classified;
+        script_classifier::classify(view, classified);
+        EXPECT_EQ(classified.size(), 4);
+        EXPECT_EQ(classified[0].Type, script_classifier::pay_to_address);
+        EXPECT_EQ(classified[1].Type, script_classifier::op_return_data);
+        EXPECT_EQ(classified[2].Type, script_classifier::multisig);
+        EXPECT_EQ(classified[3].Type, script_classifier::unknown);
+        EXPECT_EQ(classified[0].Hash160.data(), view.Outputs[0].Script.data() + 3);
+        
+        bytes extra = tx;
+        extra.resize(tx.size() + 1);
+        EXPECT_FALSE(transaction_view{extra}.valid());
+        EXPECT_FALSE(transaction_view{bytes_view{tx}.substr(0, tx.size() - 1)}.valid());
+        
+    }
+    
+    TEST(ScriptTest, TestMachine) {
+        
+        machine m{program{OP_1, OP_2, OP_ADD, OP_DUP, OP_TOALTSTACK, OP_3, OP_EQUAL}};
+        
+        m.step(2);
+        EXPECT_FALSE(m.halt());
+        EXPECT_EQ(m.position(), 2);
+        
+        machine::state saved = m.snapshot();
+        EXPECT_EQ(saved.Stack.size(), 2);
+        EXPECT_EQ(bytes_view(saved.Stack[1]), instruction_view{OP_2}.data());
+        
+        m.step(3);
+        machine::state x = m.snapshot();
+        EXPECT_EQ(x.Stack.size(), 1);
+        EXPECT_EQ(x.AltStack.size(), 1);
+        EXPECT_EQ(x.Stack[0], x.AltStack[0]);
+        
+        m.run();
+        EXPECT_TRUE(m.halt());
+        EXPECT_TRUE(m.success());
+        EXPECT_EQ(m.error(), SCRIPT_ERR_OK);
+        
+        // go back and run again one step at a time. 
+        m.restore(saved);
+        EXPECT_FALSE(m.halt());
+        EXPECT_EQ(m.snapshot().Stack, saved.Stack);
+        while (!m.halt()) m.step();
+        EXPECT_TRUE(m.success());
+        
+        machine failure{program{OP_1, OP_VERIFY, OP_0, OP_VERIFY, OP_1}};
+        failure.step(4);
+        EXPECT_TRUE(failure.halt());
+        EXPECT_FALSE(failure.success());
+        EXPECT_NE(failure.error(), SCRIPT_ERR_OK);
+        
+        // large elements are not kept inline. 
+        bytes large(100, 0x01);
+        machine::element e{large};
+        EXPECT_EQ(bytes_view(e), bytes_view(large));
+        
+    }
+    
+}
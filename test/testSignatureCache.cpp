@@ -0,0 +1,129 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include <gigamonkey/signature_cache.hpp>
+#include <gigamonkey/script/validation.hpp>
+#include "gtest/gtest.h"
+
+namespace Gigamonkey::secp256k1 {
+    
+    TEST(SignatureCacheTest, TestSignatureCache) {
+        
+        secret key{coordinate{"0x00000000000000000000000000000000000000000000000000000000000101a7"}};
+        pubkey p = key.to_public();
+        digest d = sha256(string_view{"sign me"});
+        digest other = sha256(string_view{"not me"});
+        signature x = key.sign(d);
+        
+        signature_cache cache{1 << 16};
+        EXPECT_EQ(cache.capacity(), (1 << 16) / 32);
+        
+        EXPECT_TRUE(cache.verify(p, d, x));
+        EXPECT_EQ(cache.hits(), 0);
+        EXPECT_EQ(cache.misses(), 1);
+        
+        EXPECT_TRUE(cache.verify(p, d, x));
+        EXPECT_EQ(cache.hits(), 1);
+        
+        // invalid signatures are not kept. 
+        EXPECT_FALSE(cache.verify(p, other, x));
+        EXPECT_FALSE(cache.verify(p, other, x));
+        EXPECT_EQ(cache.hits(), 1);
+        EXPECT_EQ(cache.misses(), 3);
+        EXPECT_DOUBLE_EQ(cache.hit_rate(), .25);
+        
+        // another cache has another salt. 
+        EXPECT_NE(cache.key(p, d, x), signature_cache{}.key(p, d, x));
+        
+        // a full cache replaces old entries and still works. 
+        signature_cache small{4 * 32};
+        EXPECT_EQ(small.capacity(), 4);
+        for (uint32 i = 0; i < 100; i++) small.insert(sha256(bytes_view(uint256{i})));
+        EXPECT_TRUE(small.verify(p, d, x));
+        EXPECT_TRUE(small.contains(small.key(p, d, x)));
+        
+        signature_cache none{0};
+        EXPECT_TRUE(none.verify(p, d, x));
+        EXPECT_FALSE(none.contains(none.key(p, d, x)));
+        
+        // many signatures at once. 
+        std::vector<signature> signatures;
+        std::vector<digest> digests;
+        for (uint32 i = 0; i < 20; i++) {
+            digests.push_back(sha256(bytes_view(uint256{i})));
+            signatures.push_back(key.sign(digests.back()));
+        }
+        
+        std::vector<signature_cache::verification> batch;
+        for (uint32 i = 0; i < 20; i++) batch.push_back({p, digests[i], signatures[i]});
+        
+        work_stealing_pool pool{2};
+        EXPECT_TRUE(cache.verify(batch, pool));
+        EXPECT_TRUE(cache.verify(batch, pool));
+        
+        batch[7].Digest = other;
+        EXPECT_FALSE(cache.verify(batch, pool));
+        
+        // pubkey::verify goes through the common cache. 
+        uint64 hits = signature_cache::common().hits();
+        EXPECT_TRUE(p.verify(d, x));
+        EXPECT_TRUE(p.verify(d, x));
+        EXPECT_GT(signature_cache::common().hits(), hits);
+        
+    }
+    
+}
+
+namespace Gigamonkey::Bitcoin {
+    
+    // a pay to address input is run through the interpreter, 
+    // which checks its signature with cached_signature_checker. 
+    TEST(SignatureCacheTest, TestCachedSignatureChecker) {
+        
+        secret key{secret::test, secp256k1::secret{secp256k1::coordinate{"0x00000000000000000000000000000000000000000000000000000000000202b3"}}};
+        pubkey p = key.to_public();
+        output spent{satoshi{5000}, pay_to_address::script(key.address().Digest)};
+        
+        auto spend = [&spent](const bytes& unlock) -> bytes {
+            return transaction{
+                list<input>{input{outpoint{txid{uint256{0x2c}}, 3}, unlock}}, 
+                list<output>{output{satoshi{4000}, bytes(25, 0)}}, 
+                0}.write();
+        };
+        
+        bytes unsigned_tx = spend(bytes{});
+        bytes tx = spend(pay_to_address::redeem(key.sign(unsigned_tx, 0, directive(sighash::all), spent), p));
+        
+        // a signature for a different amount. 
+        bytes wrong = spend(pay_to_address::redeem(
+            key.sign(unsigned_tx, 0, directive(sighash::all), output{satoshi{5001}, spent.Script}), p));
+        
+        // no script cache, so that the interpreter always runs. 
+        script_cache none{0};
+        work_stealing_pool pool{1};
+        secp256k1::signature_cache& cache = secp256k1::signature_cache::common();
+        spending good_spend{tx, {transaction_view::output{spent.Value, spent.Script}}};
+        spending wrong_spend{wrong, {transaction_view::output{spent.Value, spent.Script}}};
+        
+        uint64 hits = cache.hits();
+        uint64 misses = cache.misses();
+        
+        // the first time the signature is verified and put in the cache. 
+        EXPECT_TRUE(validate_scripts(good_spend, pool, StandardScriptVerifyFlags(true, true), none).valid());
+        EXPECT_EQ(cache.hits(), hits);
+        EXPECT_EQ(cache.misses(), misses + 1);
+        
+        // the second time it is found there. 
+        EXPECT_TRUE(validate_scripts(good_spend, pool, StandardScriptVerifyFlags(true, true), none).valid());
+        EXPECT_EQ(cache.hits(), hits + 1);
+        EXPECT_EQ(cache.misses(), misses + 1);
+        
+        // a wrong signature is never cached. 
+        EXPECT_FALSE(validate_scripts(wrong_spend, pool, StandardScriptVerifyFlags(true, true), none).valid());
+        EXPECT_FALSE(validate_scripts(wrong_spend, pool, StandardScriptVerifyFlags(true, true), none).valid());
+        EXPECT_EQ(cache.hits(), hits + 1);
+        EXPECT_EQ(cache.misses(), misses + 3);
+        
+    }
+    
+}
@@ -3,6 +3,7 @@
 
 #include <gigamonkey/spv.hpp>
 #include <gigamonkey/script/pattern.hpp>
+#include <gigamonkey/spendable.hpp>
 #include "gtest/gtest.h"
 
 namespace Gigamonkey::Bitcoin {
@@ -95,4 +96,157 @@ namespace Gigamonkey::Bitcoin {
         EXPECT_EQ(t.write(), *tx);
         
     }
+    
+    TEST(TransactionTest, TestTransactionBuilder) {
+        
+        bytes p2pkh = pay_to_address::script(digest160{uint160{7}});
+        bytes signature_script = compile(program{push_data(bytes(72, 0x30)), push_data(bytes(33, 0x02))});
+        
+        outpoint a{txid{uint256{1}}, 0};
+        outpoint b{txid{uint256{2}}, 3};
+        
+        // the same as a transaction that is written all at once. 
+        transaction_builder builder{1, 5};
+        EXPECT_TRUE(transaction_view{builder.incomplete()}.valid());
+        EXPECT_EQ(builder.add_input(a, signature_script, 0xffffffff), 0);
+        EXPECT_EQ(builder.add_output(satoshi{1000}, p2pkh), 0);
+        EXPECT_EQ(builder.add_output(satoshi{2000}, p2pkh), 1);
+        EXPECT_TRUE(transaction_view{builder.incomplete()}.valid());
+        
+        // an input which is added after outputs still comes before them. 
+        EXPECT_EQ(builder.add_input(b, 150, 0), 1);
+        EXPECT_EQ(builder.inputs(), 2);
+        EXPECT_EQ(builder.outputs(), 2);
+        
+        transaction_view incomplete{builder.incomplete()};
+        EXPECT_TRUE(incomplete.valid());
+        EXPECT_EQ(incomplete.Inputs[1].Script, bytes(150, 0));
+        
+        // only reserved scripts can be written and only if they fit. 
+        EXPECT_FALSE(builder.set_script(0, signature_script));
+        EXPECT_FALSE(builder.set_script(1, bytes(151, 0x01)));
+        EXPECT_FALSE(builder.set_script(2, signature_script));
+        EXPECT_TRUE(builder.set_script(1, signature_script));
+        
+        bytes expected = transaction{1, 
+            list<input>{input{a, signature_script, 0xffffffff}, input{b, signature_script, 0}}, 
+            list<output>{output{satoshi{1000}, p2pkh}, output{satoshi{2000}, p2pkh}}, 5}.write();
+        
+        EXPECT_EQ(builder.complete(), expected);
+        
+        // enough inputs and outputs that their numbers take more than one byte. 
+        transaction_builder many{};
+        list<input> inputs;
+        list<output> outputs;
+        for (uint32 i = 0; i < 300; i++) {
+            bytes script = compile(program{push_data(bytes(i % 20 + 1, byte(i)))});
+            many.add_input(outpoint{txid{uint256{i + 1}}, i}, i % 3 == 0 ? script.size() + 260 : script.size(), i);
+            if (i % 3 != 0) many.set_script(i, script);
+            many.add_output(satoshi{int64(i)}, script);
+            inputs = inputs << input{outpoint{txid{uint256{i + 1}}, i}, script, i};
+            outputs = outputs << output{satoshi{int64(i)}, script};
+        }
+        
+        EXPECT_TRUE(transaction_view{many.incomplete()}.valid());
+        for (uint32 i = 0; i < 300; i += 3) EXPECT_TRUE(many.set_script(i, compile(program{push_data(bytes(i % 20 + 1, byte(i)))})));
+        
+        EXPECT_EQ(many.complete(), (transaction{1, inputs, outputs, 0}.write()));
+        
+    }
+    
+    TEST(TransactionTest, TestIndexedTransaction) {
+        
+        list<input> inputs;
+        list<output> outputs;
+        for (uint32 i = 0; i < 300; i++) {
+            bytes script = compile(program{push_data(bytes(i % 30 + 1, byte(i)))});
+            inputs = inputs << input{outpoint{txid{uint256{i + 1}}, i}, script, i};
+            outputs = outputs << output{satoshi{int64(i + 1)}, script};
+        }
+        
+        transaction t{1, inputs, outputs, 7};
+        bytes written = t.write();
+        
+        // both are written the same way. 
+        indexed_transaction x{t};
+        EXPECT_EQ(x.Inputs.size(), 300);
+        EXPECT_EQ(x.Outputs.size(), 300);
+        EXPECT_EQ(x.serialized_size(), written.size());
+        EXPECT_EQ(x.write(), written);
+        EXPECT_EQ(x.id(), t.id());
+        EXPECT_EQ(x.sent(), t.sent());
+        EXPECT_TRUE(x.valid());
+        
+        indexed_transaction read = indexed_transaction::read(written);
+        EXPECT_EQ(read, x);
+        EXPECT_EQ(transaction(read), t);
+        EXPECT_EQ(read.Inputs[250], t.Inputs[250]);
+        EXPECT_EQ(read.Outputs[299], t.Outputs[299]);
+        
+        EXPECT_FALSE(indexed_transaction::read(bytes_view{written}.substr(0, written.size() - 5)).valid());
+        
+        ledger::double_entry d{std::make_shared<bytes>(written)};
+        EXPECT_EQ(d.output(123), t.Outputs[123]);
+        EXPECT_EQ(d.input(45), t.Inputs[45]);
+        EXPECT_EQ(d.output(300), output{});
+        EXPECT_EQ(d.input(300), input{});
+        for (uint32 i : {0, 1, 150, 299}) {
+            EXPECT_EQ(d.output(i), t.Outputs[i]);
+            EXPECT_EQ(d.input(i), t.Inputs[i]);
+        }
+        
+        // entries can be found up to where the transaction is cut off. 
+        bytes_view cut = bytes_view{written}.substr(0, written.size() - 5);
+        transaction_view::output out;
+        EXPECT_TRUE(transaction_view::find_output(cut, 298, out));
+        EXPECT_EQ(out.Value, satoshi{299});
+        EXPECT_FALSE(transaction_view::find_output(cut, 299, out));
+        transaction_view::input in;
+        EXPECT_TRUE(transaction_view::find_input(cut, 299, in));
+        EXPECT_EQ(bytes{in.Script}, t.Inputs[299].Script);
+        EXPECT_FALSE(transaction_view::find_input(bytes{1, 2, 3}, 0, in));
+        
+    }
+    
+    TEST(TransactionTest, TestEstimate) {
+        
+        // estimates are exact when the script sizes are known. 
+        for (uint32 inputs : {0, 1, 3, 300}) for (uint32 outputs : {1, 2, 260}) {
+            estimate e{};
+            transaction_builder b{};
+            for (uint32 i = 0; i < inputs; i++) {
+                bytes script(i % 5 == 0 ? 300 : i % 5 * 40, 0);
+                e.add_input(script.size());
+                b.add_input(outpoint{txid{uint256{i + 1}}, i}, script, 0);
+            }
+            
+            for (uint32 i = 0; i < outputs; i++) {
+                bytes script(i % 2 == 0 ? estimate::PayToAddressScriptSize : 260, 0);
+                e.add_output(script.size());
+                b.add_output(satoshi{1000}, script);
+            }
+            
+            EXPECT_EQ(e.size(), b.complete().size());
+        }
+        
+        secret key{secret::test, secp256k1::secret{secp256k1::coordinate{"0x00000000000000000000000000000000000000000000000000000000000101a7"}}};
+        pubkey compressed = key.to_public();
+        pubkey uncompressed = compressed.decompress();
+        
+        EXPECT_EQ(pay_to_address::script(key.address().Digest).size(), estimate::PayToAddressScriptSize);
+        EXPECT_EQ(pay_to_pubkey::script(compressed).size(), estimate::pay_to_pubkey_script_size(true));
+        EXPECT_EQ(pay_to_pubkey::script(uncompressed).size(), estimate::pay_to_pubkey_script_size(false));
+        
+        EXPECT_EQ(redeem_pay_to_pubkey{key}.expected_size(), estimate::PayToPubkeyRedeemSize);
+        EXPECT_EQ(redeem_pay_to_address(key, compressed).expected_size(), estimate::pay_to_address_redeem_size(true));
+        EXPECT_EQ(redeem_pay_to_address(key, uncompressed).expected_size(), estimate::pay_to_address_redeem_size(false));
+        
+        // signatures never take up more space than is estimated. 
+        for (uint32 i = 0; i < 200; i++) {
+            signature x{key.sign(sha256(bytes_view(uint256{i}))), directive(sighash::all)};
+            EXPECT_LE(compile(program{push_data(x)}).size(), estimate::MaxSignaturePushSize);
+            EXPECT_LE(compile(program{push_data(x), push_data(compressed)}).size(), estimate::pay_to_address_redeem_size(true));
+        }
+        
+    }
 }
@@ -0,0 +1,93 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include <gigamonkey/wallet.hpp>
+#include <set>
+#include "gtest/gtest.h"
+
+namespace Gigamonkey::Bitcoin {
+    
+    spendable test_spendable(uint32 i, int64 value) {
+        return spendable{output{satoshi{value}, bytes(25, byte(i))}, nullptr, outpoint{txid{uint256{i + 1}}, i}};
+    }
+    
+    TEST(UTXOTest, TestUTXOSet) {
+        
+        utxo_set u;
+        EXPECT_TRUE(u.empty());
+        EXPECT_EQ(u.oldest(), nullptr);
+        EXPECT_EQ(u.largest(), nullptr);
+        EXPECT_EQ(u.random(3), nullptr);
+        
+        // values 100, 300, 200, 500, 400. 
+        std::vector<int64> values{100, 300, 200, 500, 400};
+        for (uint32 i = 0; i < values.size(); i++) EXPECT_TRUE(u.insert(test_spendable(i, values[i])));
+        EXPECT_FALSE(u.insert(test_spendable(2, 200)));
+        
+        EXPECT_EQ(u.size(), 5);
+        EXPECT_EQ(u.value(), satoshi{1500});
+        EXPECT_EQ(u.oldest()->Value, satoshi{100});
+        EXPECT_EQ(u.largest()->Value, satoshi{500});
+        EXPECT_EQ(u.smallest()->Value, satoshi{100});
+        EXPECT_EQ(u.at_least(satoshi{250})->Value, satoshi{300});
+        EXPECT_EQ(u.at_least(satoshi{300})->Value, satoshi{300});
+        EXPECT_EQ(u.at_least(satoshi{501}), nullptr);
+        
+        EXPECT_TRUE(u.contains(outpoint{txid{uint256{4}}, 3}));
+        EXPECT_EQ(u.find(outpoint{txid{uint256{4}}, 3})->Value, satoshi{500});
+        
+        EXPECT_TRUE(u.remove(outpoint{txid{uint256{1}}, 0}));
+        EXPECT_FALSE(u.remove(outpoint{txid{uint256{1}}, 0}));
+        EXPECT_TRUE(u.remove(outpoint{txid{uint256{4}}, 3}));
+        EXPECT_EQ(u.size(), 3);
+        EXPECT_EQ(u.value(), satoshi{900});
+        EXPECT_EQ(u.oldest()->Value, satoshi{300});
+        EXPECT_EQ(u.largest()->Value, satoshi{400});
+        
+        // every output that is left can be chosen at random. 
+        std::set<int64> chosen;
+        for (uint64 r = 0; r < 3; r++) chosen.insert(int64(u.random(r)->Value));
+        EXPECT_EQ(chosen, (std::set<int64>{200, 300, 400}));
+        
+        std::vector<int64> by_value;
+        u.by_value([&by_value](const spendable& s) {
+            by_value.push_back(int64(s.Value));
+        });
+        EXPECT_EQ(by_value, (std::vector<int64>{400, 300, 200}));
+        
+        // a copy has its own indices. 
+        utxo_set v{u};
+        EXPECT_TRUE(v.remove(outpoint{txid{uint256{3}}, 2}));
+        EXPECT_EQ(v.size(), 2);
+        EXPECT_EQ(u.size(), 3);
+        EXPECT_EQ(data::size(u.entries()), 3);
+        EXPECT_EQ(u.entries().first().Value, satoshi{300});
+        
+    }
+    
+    TEST(UTXOTest, TestFunds) {
+        
+        funds f{};
+        for (uint32 i = 0; i < 100; i++) f.add(test_spendable(i, 1000 + i));
+        EXPECT_EQ(f.Entries.size(), 100);
+        
+        funds::selected next = funds{f}.select_next();
+        EXPECT_EQ(next.Selected.Value, satoshi{1000});
+        EXPECT_EQ(next.Remainder.Entries.size(), 99);
+        EXPECT_EQ(f.Entries.size(), 100);
+        
+        funds::selected random = funds{f}.select_random();
+        EXPECT_FALSE(random.Remainder.Entries.contains(random.Selected.Outpoint));
+        EXPECT_EQ(random.Remainder.Value + random.Selected.Value, f.Value);
+        
+        EXPECT_EQ(f.take_largest().Value, satoshi{1099});
+        EXPECT_EQ(f.take_next().Value, satoshi{1000});
+        EXPECT_EQ(f.Entries.size(), 98);
+        
+        while (!f.Entries.empty()) f.take_random();
+        EXPECT_EQ(f.Value, satoshi{0});
+        EXPECT_THROW(f.take_next(), std::out_of_range);
+        
+    }
+    
+}
@@ -0,0 +1,185 @@
+// Copyright (c) 2021 Daniel Krawisz
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include <gigamonkey/script/validation.hpp>
+#include <atomic>
+#include "gtest/gtest.h"
+
+namespace Gigamonkey::Bitcoin {
+    
+    TEST(ValidationTest, TestWorkStealingPool) {
+        
+        for (uint32 threads : list<uint32>{1, 2, 4}) {
+            work_stealing_pool pool{threads};
+            EXPECT_EQ(pool.threads(), threads);
+            
+            // every index is visited once. 
+            for (size_t n : list<size_t>{0, 1, 3, 1000}) {
+                std::vector<std::atomic<uint32>> visits(n);
+                for (std::atomic<uint32>& v : visits) v = 0;
+                
+                // uneven work so that some threads finish early and steal. 
+                pool.run(n, [&visits](size_t i) {
+                    if (i % 7 == 0) std::this_thread::sleep_for(std::chrono::microseconds(50));
+                    visits[i]++;
+                });
+                
+                for (const std::atomic<uint32>& v : visits) EXPECT_EQ(v, 1);
+            }
+            
+            // a loop run from inside another loop does not deadlock. 
+            std::atomic<uint32> inner{0};
+            pool.run(10, [&pool, &inner](size_t) {
+                pool.run(10, [&inner](size_t) {
+                    inner++;
+                });
+            });
+            EXPECT_EQ(inner, 100);
+        }
+        
+    }
+    
+    TEST(ValidationTest, TestValidateScripts) {
+        
+        bytes lock_one = compile(program{OP_1, OP_EQUAL});
+        bytes lock_two = compile(program{OP_2, OP_EQUAL});
+        bytes unlock = compile(program{OP_1});
+        
+        bytes tx = transaction{
+            list<input>{
+                input{outpoint{txid{uint256{1}}, 0}, unlock}, 
+                input{outpoint{txid{uint256{1}}, 1}, unlock}, 
+                input{outpoint{txid{uint256{2}}, 0}, unlock}}, 
+            list<output>{output{satoshi{1000}, lock_one}}, 
+            0}.write();
+        
+        transaction_view::output one{satoshi{500}, lock_one};
+        transaction_view::output two{satoshi{500}, lock_two};
+        
+        work_stealing_pool pool{2};
+        
+        script_validation good = validate_scripts(spending{tx, {one, one, one}}, pool, SCRIPT_VERIFY_NONE);
+        EXPECT_EQ(good.Inputs.size(), 3);
+        EXPECT_TRUE(good.valid());
+        
+        script_validation bad = validate_scripts(spending{tx, {one, two, one}}, pool, SCRIPT_VERIFY_NONE);
+        EXPECT_EQ(bad.Inputs.size(), 3);
+        EXPECT_FALSE(bad.valid());
+        EXPECT_TRUE(bad.Inputs[0].Return);
+        EXPECT_FALSE(bad.Inputs[1].Return);
+        EXPECT_TRUE(bad.Inputs[2].Return);
+        
+        // inputs of many transactions are listed together in order. 
+        script_validation many = validate_scripts(std::vector<spending>{
+            spending{tx, {one, one, one}}, 
+            spending{tx, {one, one}}, 
+            spending{tx, {two, one, one}}}, pool, SCRIPT_VERIFY_NONE);
+        EXPECT_EQ(many.Inputs.size(), 8);
+        for (int i = 0; i < 3; i++) EXPECT_TRUE(many.Inputs[i].Return);
+        
+        // the wrong number of spent outputs is an error. 
+        EXPECT_EQ(many.Inputs[3].Error, SCRIPT_ERR_UNKNOWN_ERROR);
+        EXPECT_EQ(many.Inputs[4].Error, SCRIPT_ERR_UNKNOWN_ERROR);
+        EXPECT_FALSE(many.Inputs[5].Return);
+        EXPECT_TRUE(many.Inputs[6].Return);
+        EXPECT_TRUE(many.Inputs[7].Return);
+        
+    }
+    
+    TEST(ValidationTest, TestValidateVertex) {
+        
+        bytes lock_one = compile(program{OP_1, OP_EQUAL});
+        bytes unlock = compile(program{OP_1});
+        
+        ledger::double_entry previous{std::make_shared<bytes>(transaction{
+            list<input>{input{outpoint{txid{uint256{1}}, 0}, unlock}}, 
+            list<output>{output{satoshi{1000}, lock_one}}, 
+            0}.write())};
+        txid previous_id = previous.id();
+        data::map<txid, ledger::double_entry> prev = data::map<txid, ledger::double_entry>{}.insert(previous_id, previous);
+        
+        auto spend = [&unlock, &lock_one](outpoint o) -> ledger::double_entry {
+            return ledger::double_entry{std::make_shared<bytes>(transaction{
+                list<input>{input{o, unlock}}, 
+                list<output>{output{satoshi{900}, lock_one}}, 
+                0}.write())};
+        };
+        
+        work_stealing_pool pool{2};
+        
+        script_validation good = validate_scripts(ledger::vertex{spend(outpoint{previous_id, 0}), prev}, pool, SCRIPT_VERIFY_NONE);
+        EXPECT_EQ(good.Inputs.size(), 1);
+        EXPECT_TRUE(good.valid());
+        
+        // the output index is out of range. 
+        EXPECT_FALSE(validate_scripts(ledger::vertex{spend(outpoint{previous_id, 1}), prev}, pool, SCRIPT_VERIFY_NONE).valid());
+        
+        // the previous transaction is missing. 
+        EXPECT_FALSE(validate_scripts(ledger::vertex{spend(outpoint{txid{uint256{2}}, 0}), prev}, pool, SCRIPT_VERIFY_NONE).valid());
+        
+        // no transaction at all. 
+        EXPECT_FALSE(validate_scripts(ledger::vertex{}, pool, SCRIPT_VERIFY_NONE).valid());
+        
+    }
+    
+    TEST(ValidationTest, TestScriptCache) {
+        
+        bytes lock_one = compile(program{OP_1, OP_EQUAL});
+        bytes lock_two = compile(program{OP_2, OP_EQUAL});
+        
+        bytes tx = transaction{
+            list<input>{
+                input{outpoint{txid{uint256{1}}, 0}, compile(program{OP_1})}, 
+                input{outpoint{txid{uint256{1}}, 1}, compile(program{OP_1})}}, 
+            list<output>{output{satoshi{1000}, lock_one}}, 
+            0}.write();
+        
+        transaction_view::output one{satoshi{500}, lock_one};
+        transaction_view::output two{satoshi{500}, lock_two};
+        
+        script_cache cache{100};
+        work_stealing_pool pool{2};
+        
+        // different flags, values or scripts are different keys. 
+        txid id = transaction_view{tx}.id();
+        digest256 key = cache.key(id, 0, one, SCRIPT_VERIFY_NONE);
+        EXPECT_EQ(key, cache.key(id, 0, one, SCRIPT_VERIFY_NONE));
+        EXPECT_NE(key, cache.key(id, 1, one, SCRIPT_VERIFY_NONE));
+        EXPECT_NE(key, cache.key(id, 0, two, SCRIPT_VERIFY_NONE));
+        EXPECT_NE(key, cache.key(id, 0, transaction_view::output{satoshi{501}, lock_one}, SCRIPT_VERIFY_NONE));
+        EXPECT_NE(key, cache.key(id, 0, one, SCRIPT_VERIFY_P2SH));
+        
+        // another cache has another salt. 
+        EXPECT_NE(key, script_cache{}.key(id, 0, one, SCRIPT_VERIFY_NONE));
+        
+        // only valid inputs are kept. 
+        EXPECT_FALSE(validate_scripts(spending{tx, {one, two}}, pool, SCRIPT_VERIFY_NONE, cache).valid());
+        EXPECT_EQ(cache.size(), 1);
+        EXPECT_EQ(cache.hits(), 0);
+        EXPECT_EQ(cache.misses(), 2);
+        
+        EXPECT_TRUE(validate_scripts(spending{tx, {one, one}}, pool, SCRIPT_VERIFY_NONE, cache).valid());
+        EXPECT_EQ(cache.size(), 2);
+        EXPECT_EQ(cache.hits(), 1);
+        
+        EXPECT_TRUE(validate_scripts(spending{tx, {one, one}}, pool, SCRIPT_VERIFY_NONE, cache).valid());
+        EXPECT_EQ(cache.hits(), 3);
+        EXPECT_EQ(cache.misses(), 3);
+        EXPECT_DOUBLE_EQ(cache.hit_rate(), .5);
+        
+        // a failure is never taken from the cache. 
+        EXPECT_FALSE(validate_scripts(spending{tx, {one, two}}, pool, SCRIPT_VERIFY_NONE, cache).valid());
+        
+        // old entries are dropped when the cache is full. 
+        script_cache small{16};
+        for (uint32 i = 0; i < 1000; i++) small.insert(sha256(bytes_view(uint256{i})));
+        EXPECT_LE(small.size(), 16);
+        
+        script_cache none{0};
+        none.insert(key);
+        EXPECT_FALSE(none.contains(key));
+        EXPECT_EQ(none.size(), 0);
+        
+    }
+    
+}
@@ -3,74 +3,134 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <gigamonkey/wallet.hpp>
-#include <gigamonkey/schema/random.hpp>
+#include <gigamonkey/script/validation.hpp>
 #include "gtest/gtest.h"
-#include <iostream>
+#include "keys.hpp"
 
 namespace Gigamonkey::Bitcoin {
     
+    // every input of the transaction must be valid. 
+    bool wallet_test_valid_scripts(const wallet::spent& s) {
+        spending x{*s.Transaction, {}};
+        for (const spendable& o : s.Spent) x.Spent.push_back(transaction_view::output{o.Value, o.Script});
+        script_validation v = validate_scripts(x);
+        return v.Inputs.size() == data::size(s.Spent) && v.valid();
+    }
+    
     TEST(WalletTest, TestWallet) {
         
-        // random keys schema
-        ptr<keysource> keys = random_keysource::make();
+        ptr<keysource> keys = std::make_shared<counting_keysource>(1);
         
         // The type of change addresses our wallet will generate. 
         const ptr<output_pattern> ChangePattern = std::make_shared<pay_to_address_pattern>();
         
-        const wallet::spend_policy SpendPolicy = wallet::fifo;
-        
-        uint32 num_inputs = 10;
-        satoshi redemption_value = 5000;
-        uint256 fake_txid{7};
-        
-        fee fees{.1, 10};
+        fee fees{.5, 0};
         
         // create outputs to redeem. 
-        stack<change> previous{};
         funds mine{};
-        for (uint32 i = 0; i < num_inputs; i++) {
-            previous = previous << ChangePattern->create_redeemable(keys);
-            mine = mine.insert(spendable{*previous.first().Redeemer, 
-                prevout{
-                    output{redemption_value, previous.first().OutputScript}, 
-                    outpoint{txid{fake_txid}, i}}});
-            fake_txid += 1;
-            redemption_value *= 3;
-            redemption_value /= 2;
+        int64 redemption_value = 5000;
+        for (uint32 i = 0; i < 10; i++) {
+            mine.add(pay_to_address_spendable(keys, i, satoshi{redemption_value}));
+            redemption_value = redemption_value * 3 / 2;
         }
         
         // make outputs to spend
-        stack<payment> payments{};
-        uint32 num_payments = 5;
-        satoshi payment_amount = 2000;
-        for (uint32 i = 0; i < num_payments; i++) 
-            payments = payments << payment{payment_amount, keys->first().address()};
-        
-        // negative tests:
-        // TODO spend more than in wallet
-        // TODO spend dust. 
-        
-        // create wallets 
-        wallet w1{mine, wallet::fifo, keys, fees, ChangePattern, 0};
-        wallet w2{mine, wallet::all, keys, fees, ChangePattern, 0};
-        wallet w3{mine, wallet::random, keys, fees, ChangePattern, 0};
-        
-        // make payment
-        wallet::spent s1 = w1.spend(payments);
-        wallet::spent s2 = w2.spend(payments);
-        wallet::spent s3 = w3.spend(payments);
-        
-        // check transaction deserialization
-        EXPECT_TRUE(s1.valid());
-        EXPECT_TRUE(s2.valid());
-        EXPECT_TRUE(s3.valid());
-        
-        // check fee
-        EXPECT_TRUE(fees.sufficient(s1.Vertex));
-        EXPECT_TRUE(fees.sufficient(s2.Vertex));
-        EXPECT_TRUE(fees.sufficient(s3.Vertex));
-        
-        // check remainders
+        list<payment> payments{};
+        satoshi sent{0};
+        for (uint32 i = 0; i < 5; i++) {
+            payments = payments << payment{satoshi{2000}, bytes(25, byte(i))};
+            sent = sent + satoshi{2000};
+        }
+        
+        for (wallet::spend_policy policy : {wallet::fifo, wallet::all, wallet::random, wallet::best}) {
+            wallet w{mine, policy, keys, fees, ChangePattern, satoshi{546}};
+            wallet::spent s = w.spend(payments);
+            ASSERT_TRUE(s.valid());
+            
+            transaction_view t{*s.Transaction};
+            ASSERT_TRUE(t.valid());
+            EXPECT_EQ(t.Inputs.size(), data::size(s.Spent));
+            EXPECT_GT(t.Outputs.size(), data::size(payments));
+            
+            // the payments come first, then the change. 
+            uint32 i = 0;
+            for (const payment& p : payments) {
+                EXPECT_EQ(t.Outputs[i].Value, p.Value);
+                EXPECT_EQ(bytes(t.Outputs[i].Script), p.Script);
+                i++;
+            }
+            
+            // check fee 
+            EXPECT_GE(s.Fee, fees.calculate(s.Transaction->size(), 0));
+            satoshi redeemed{0};
+            for (const spendable& x : s.Spent) redeemed = redeemed + x.Value;
+            satoshi paid{0};
+            for (const transaction_view::output& o : t.Outputs) paid = paid + o.Value;
+            EXPECT_EQ(redeemed - paid, s.Fee);
+            
+            EXPECT_TRUE(wallet_test_valid_scripts(s));
+            
+            // check remainders 
+            EXPECT_EQ(s.Remainder.Funds.Value, mine.Value - sent - s.Fee);
+            for (uint32 i = data::size(payments); i < t.Outputs.size(); i++) 
+                EXPECT_TRUE(s.Remainder.Funds.Entries.contains(outpoint{s.Transaction.id(), i}));
+            EXPECT_NE(s.Remainder.Keys, keys);
+            
+            // the change can be spent. 
+            wallet::spent again = s.Remainder.spend(list<payment>{payment{satoshi{1000}, bytes(25, 0)}});
+            ASSERT_TRUE(again.valid());
+            EXPECT_TRUE(wallet_test_valid_scripts(again));
+        }
+        
+        // spend more than in wallet 
+        wallet w{mine, wallet::fifo, keys, fees, ChangePattern, satoshi{546}};
+        EXPECT_FALSE(w.spend(list<payment>{payment{mine.Value, bytes(25, 0)}}).valid());
+        
+        // spend dust. 
+        EXPECT_FALSE(w.spend(list<payment>{payment{satoshi{545}, bytes(25, 0)}}).valid());
+        
+    }
+    
+    // best finds an output that pays exactly enough, so no change is made. 
+    TEST(WalletTest, TestWalletBestNoChange) {
+        
+        ptr<keysource> keys = std::make_shared<counting_keysource>(1);
+        const ptr<output_pattern> ChangePattern = std::make_shared<pay_to_address_pattern>();
+        
+        funds mine{};
+        mine.add(pay_to_address_spendable(keys, 0, satoshi{100000}));
+        mine.add(pay_to_address_spendable(keys, 1, satoshi{2300}));
+        mine.add(pay_to_address_spendable(keys, 2, satoshi{100000}));
+        
+        wallet w{mine, wallet::best, keys, fee{1, 0}, ChangePattern, satoshi{546}};
+        wallet::spent s = w.spend(list<payment>{payment{satoshi{2000}, bytes(25, 0)}});
+        ASSERT_TRUE(s.valid());
+        
+        transaction_view t{*s.Transaction};
+        ASSERT_TRUE(t.valid());
+        EXPECT_EQ(t.Inputs.size(), 1);
+        EXPECT_EQ(t.Outputs.size(), 1);
+        EXPECT_EQ(s.Spent.first().Value, satoshi{2300});
+        EXPECT_EQ(s.Fee, satoshi{300});
+        EXPECT_TRUE(wallet_test_valid_scripts(s));
+        
+        // no keys were used for change. 
+        EXPECT_EQ(s.Remainder.Keys, keys);
+        EXPECT_EQ(s.Remainder.Funds.Value, satoshi{200000});
+        
+        // nothing is close enough now, so change is made. 
+        wallet::spent c = s.Remainder.spend(list<payment>{payment{satoshi{2000}, bytes(25, 0)}});
+        ASSERT_TRUE(c.valid());
+        
+        transaction_view u{*c.Transaction};
+        ASSERT_TRUE(u.valid());
+        EXPECT_EQ(u.Inputs.size(), 1);
+        EXPECT_EQ(u.Outputs.size(), 2);
+        EXPECT_GE(c.Fee, fee{1, 0}.calculate(c.Transaction->size(), 0));
+        EXPECT_EQ(u.Outputs[1].Value, satoshi{100000 - 2000} - c.Fee);
+        EXPECT_TRUE(c.Remainder.Funds.Entries.contains(outpoint{c.Transaction.id(), 1}));
+        EXPECT_NE(c.Remainder.Keys, keys);
+        EXPECT_TRUE(wallet_test_valid_scripts(c));
         
     }
 